@@ -37,6 +37,8 @@
 #include "ErrorRedirector.h"
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
+#include <algorithm>
+#include <iterator>
 
 AutoComplete::AutoComplete(Configuration *configuration)
 {
@@ -48,7 +50,10 @@ void AutoComplete::ClearWorksheetWords()
   #ifdef HAVE_OPENMP_TASKS
   #pragma omp critical (AutocompleteBuiltins)
   #endif
-  m_worksheetWords.clear();
+  {
+    m_worksheetWords.clear();
+    m_fuzzyMatcherType = -1;
+  }
 }
 
 void AutoComplete::ClearDemofileList()
@@ -137,8 +142,9 @@ void AutoComplete::AddWorksheetWords(WordList::const_iterator const begin, WordL
   #pragma omp critical (AutocompleteBuiltins)
   #endif
   {
-    for (auto word = begin; word != end; std::advance(word, 1))
-      m_worksheetWords[*word] = 1;
+    for (auto word = begin; word != end; ++word)
+      m_worksheetWords[*word]++;
+    m_fuzzyMatcherType = -1;
   }
 }
 
@@ -184,11 +190,6 @@ void AutoComplete::BuiltinSymbols_BackgroundTask()
     for (auto it = Configuration::EscCodesBegin(); it != Configuration::EscCodesEnd(); ++it)
        m_wordList[esccommand].Add(it->first);
 
-    m_wordList[command].Sort();
-    m_wordList[tmplte].Sort();
-    m_wordList[unit].Sort();
-    m_wordList[esccommand].Sort();
-
     wxString line;
 
     /// Load private symbol list (do something different on Windows).
@@ -249,6 +250,12 @@ void AutoComplete::BuiltinSymbols_BackgroundTask()
         text.Flush();
       }
     }
+
+    SortUnique(m_wordList[command]);
+    SortUnique(m_wordList[tmplte]);
+    SortUnique(m_wordList[unit]);
+    SortUnique(m_wordList[esccommand]);
+    m_fuzzyMatcherType = -1;
   }
 }
 
@@ -323,8 +330,8 @@ void AutoComplete::LoadSymbols_BackgroundTask()
           )
         );
     }
-    m_builtInLoadFiles.Sort();
-    m_builtInDemoFiles.Sort();
+    SortUnique(m_builtInLoadFiles);
+    SortUnique(m_builtInDemoFiles);
   }
 }
 
@@ -368,6 +375,7 @@ void AutoComplete::UpdateDemoFiles(wxString partial, wxString maximaDir)
       if(demofilesdir.IsOpened())
         demofilesdir.Traverse(userLispIterator);
     }
+    SortUnique(m_wordList[demofile]);
   }
 }
 
@@ -408,6 +416,7 @@ void AutoComplete::UpdateGeneralFiles(wxString partial, wxString maximaDir)
       if(generalfilesdir.IsOpened())
         generalfilesdir.Traverse(fileIterator);
     }
+    SortUnique(m_wordList[generalfile]);
   }
 }
 
@@ -452,6 +461,7 @@ void AutoComplete::UpdateLoadFiles(wxString partial, wxString maximaDir)
       if(loadfilesdir.IsOpened())
         loadfilesdir.Traverse(userLispIterator);
     }
+    SortUnique(m_wordList[loadfile]);
   }
 }
 
@@ -474,55 +484,90 @@ wxArrayString AutoComplete::CompleteSymbol(wxString partial, autoCompletionType
   
     wxASSERT_MSG((type >= command) && (type <= unit), _("Bug: Autocompletion requested for unknown type of item."));
   
-    if (type != tmplte)
-    {
-      for (size_t i = 0; i < m_wordList[type].GetCount(); i++)
-      {
-        if (m_wordList[type][i].StartsWith(partial) &&
-            completions.Index(m_wordList[type][i]) == wxNOT_FOUND)
-          completions.Add(m_wordList[type][i]);
-      }
-    }
-    else
+    // The words that start with partial are sorted next to each other
+    auto const &words = m_wordList[type];
+    auto wordsEnd = std::lower_bound(words.begin(), words.end(), partial);
+    auto wordsBegin = wordsEnd;
+    while ((wordsEnd != words.end()) && wordsEnd->StartsWith(partial))
     {
-      for (size_t i = 0; i < m_wordList[type].GetCount(); i++)
-      {
-        wxString templ = m_wordList[type][i];
-        if (templ.StartsWith(partial))
-        {
-          if (completions.Index(templ) == wxNOT_FOUND)
-            completions.Add(templ);
-          if (templ.SubString(0, templ.Find(wxT("(")) - 1) == partial &&
-              perfectCompletions.Index(templ) == wxNOT_FOUND)
-            perfectCompletions.Add(templ);
-        }
-      }
+      if ((type == tmplte) && (wordsEnd->SubString(0, wordsEnd->Find(wxT("(")) - 1) == partial))
+        perfectCompletions.Add(*wordsEnd);
+      ++wordsEnd;
     }
 
     // Add a list of words that were definied on the work sheet but that aren't
     // defined as maxima commands or functions.
+    WordList worksheetWords;
     if (type == command)
-    {
-      WorksheetWords::const_iterator it;
-      for (it = m_worksheetWords.begin(); it != m_worksheetWords.end(); ++it)
-      {
-        if (it->first.StartsWith(partial))
-        {
-          if (completions.Index(it->first) == wxNOT_FOUND)
-          {
-            completions.Add(it->first);
-          }
-        }
-      }
-    }
+      for (auto word = m_worksheetWords.lower_bound(partial);
+           (word != m_worksheetWords.end()) && word->first.StartsWith(partial); ++word)
+        worksheetWords.push_back(word->first);
 
-    completions.Sort();
+    completions.Alloc((wordsEnd - wordsBegin) + worksheetWords.size());
+    std::set_union(wordsBegin, wordsEnd, worksheetWords.begin(), worksheetWords.end(),
+                   std::back_inserter(completions));
   }
   if (perfectCompletions.Count() > 0)
     return perfectCompletions;
   return completions;
 }
 
+wxArrayString AutoComplete::CompleteSymbolFuzzy(wxString partial, autoCompletionType type)
+{
+  if (((type != command) && (type != unit)) || partial.IsEmpty())
+    return CompleteSymbol(partial, type);
+
+  // Everything that starts with partial is offered. But of the words that only
+  // contain its letters only the best ones are worth showing.
+  const size_t maxFuzzyMatches = 50;
+  wxArrayString completions;
+
+  #ifdef HAVE_OPENMP_TASKS
+  #pragma omp critical (AutocompleteBuiltins)
+  #endif
+  {
+    if (m_fuzzyMatcherType != type)
+      UpdateFuzzyMatcher(type);
+    for (auto const &word : m_fuzzyMatcher.Find(partial, maxFuzzyMatches))
+      completions.Add(word);
+  }
+  return completions;
+}
+
+void AutoComplete::UpdateFuzzyMatcher(autoCompletionType type)
+{
+  auto const &words = m_wordList[type];
+  m_fuzzyMatcher.Clear();
+  if (type != command)
+  {
+    m_fuzzyMatcher.Reserve(words.GetCount());
+    for (auto const &word : words)
+      m_fuzzyMatcher.Add(word);
+  }
+  else
+  {
+    // Both lists are sorted => We can merge them and look up how often each
+    // word is used in the worksheet on the way.
+    m_fuzzyMatcher.Reserve(words.GetCount() + m_worksheetWords.size());
+    auto worksheetWord = m_worksheetWords.begin();
+    for (auto const &word : words)
+    {
+      for (; (worksheetWord != m_worksheetWords.end()) && (worksheetWord->first < word); ++worksheetWord)
+        m_fuzzyMatcher.Add(worksheetWord->first, worksheetWord->second);
+      int usage = 0;
+      if ((worksheetWord != m_worksheetWords.end()) && (worksheetWord->first == word))
+      {
+        usage = worksheetWord->second;
+        ++worksheetWord;
+      }
+      m_fuzzyMatcher.Add(word, usage);
+    }
+    for (; worksheetWord != m_worksheetWords.end(); ++worksheetWord)
+      m_fuzzyMatcher.Add(worksheetWord->first, worksheetWord->second);
+  }
+  m_fuzzyMatcherType = type;
+}
+
 void AutoComplete::AddSymbol(wxString fun, autoCompletionType type)
 {
   #ifdef HAVE_OPENMP_TASKS
@@ -550,9 +595,12 @@ void AutoComplete::AddSymbol_nowait(wxString fun, autoCompletionType type)
     type = unit;
   }
 
+  if (type == m_fuzzyMatcherType)
+    m_fuzzyMatcherType = -1;
+
   /// Add symbols
-  if ((type != tmplte) && m_wordList[type].Index(fun, true, true) == wxNOT_FOUND)
-    m_wordList[type].Add(fun);
+  if (type != tmplte)
+    InsertSorted(m_wordList[type], fun);
 
   /// Add templates - for given function and given argument count we
   /// only add one template. We count the arguments by counting '<'
@@ -561,18 +609,30 @@ void AutoComplete::AddSymbol_nowait(wxString fun, autoCompletionType type)
     fun = FixTemplate(fun);
     wxString funName = fun.SubString(0, fun.Find(wxT("(")));
     long count = fun.Freq('<');
-    size_t i = 0;
-    for (i = 0; i < m_wordList[type].GetCount(); i++)
-    {
-      wxString t = m_wordList[type][i];
-      if (t.StartsWith(funName) && (t.Freq('<') == count))
-        break;
-    }
-    if (i == m_wordList[type].GetCount())
-      m_wordList[type].Add(fun);
+    auto &templates = m_wordList[type];
+    for (auto t = std::lower_bound(templates.begin(), templates.end(), funName);
+         (t != templates.end()) && t->StartsWith(funName); ++t)
+      if (t->Freq('<') == count)
+        return;
+    InsertSorted(templates, fun);
   }
 }
 
+void AutoComplete::SortUnique(wxArrayString &words)
+{
+  std::sort(words.begin(), words.end());
+  auto end = std::unique(words.begin(), words.end());
+  if (end != words.end())
+    words.RemoveAt(end - words.begin(), words.end() - end);
+}
+
+void AutoComplete::InsertSorted(wxArrayString &words, const wxString &word)
+{
+  auto pos = std::lower_bound(words.begin(), words.end(), word);
+  if ((pos == words.end()) || (*pos != word))
+    words.Insert(word, pos - words.begin());
+}
+
 
 wxString AutoComplete::FixTemplate(wxString templ)
 {
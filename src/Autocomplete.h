@@ -36,8 +36,10 @@
 #include <wx/arrstr.h>
 #include <wx/regex.h>
 #include <wx/filename.h>
+#include <map>
 #include <vector>
 #include "Configuration.h"
+#include "FuzzyMatcher.h"
 
 /* The autocompletion logic
 
@@ -47,11 +49,17 @@
        "values" and "functions" after a package is loaded.
      - all words that appear in the worksheet
      - and a list of maxima's builtin commands.
+
+   All word lists are kept sorted and free of duplicates: This way all words
+   that start with the same prefix are neighbours and CompleteSymbol() can find
+   them by a binary search instead of looking at every word we know.
+
+   CompleteSymbolFuzzy() additionally offers the command names the user has typed
+   only some of the letters of, ranked by how well they match and by how often
+   they are used in the worksheet.
  */
 class AutoComplete
 {
-  WX_DECLARE_STRING_HASH_MAP(int, WorksheetWords);
-
 public:
   using WordList = std::vector<wxString>;
 
@@ -107,6 +115,12 @@ public:
   
   //! Returns a list of possible autocompletions for the string "partial"
   wxArrayString CompleteSymbol(wxString partial, autoCompletionType type = command);
+  /*! Like CompleteSymbol, but ranks the words and includes words that only contain partial's chars
+
+    The words that start with partial come first. For the types other than commands
+    and units this is the same as CompleteSymbol.
+  */
+  wxArrayString CompleteSymbolFuzzy(wxString partial, autoCompletionType type = command);
   //! Basically runs a regex over templates
   static wxString FixTemplate(wxString templ);
 
@@ -119,6 +133,8 @@ private:
   void LoadSymbols_BackgroundTask();
   //! Prepares the list of built-in symbols and can be run in a background task
   void BuiltinSymbols_BackgroundTask();
+  //! Makes m_fuzzyMatcher search the words of the given type
+  void UpdateFuzzyMatcher(autoCompletionType type);
 
   //! Replace the list of files in the directory the worksheet file is in to the load files list
   void UpdateLoadFiles_BackgroundTask(wxString partial, wxString maximaDir);
@@ -157,6 +173,11 @@ private:
     wxString m_prefix;
   };
 
+  //! Sorts a list of words and removes duplicates so it can be binary-searched
+  static void SortUnique(wxArrayString &words);
+  //! Adds a word to a list SortUnique() has been applied to, if it isn't in there yet
+  static void InsertSorted(wxArrayString &words, const wxString &word);
+
   //! Recursively scans the maxima directory for a list of .mac files
   class GetMacFiles_includingSubdirs : public wxDirTraverser
   {
@@ -267,10 +288,15 @@ private:
       }
   };
 
-  //! The lists of autocompletible symbols for the classes defined in autoCompletionType
+  //! The lists of autocompletible symbols for the classes defined in autoCompletionType, sorted
   wxArrayString m_wordList[7];
   static wxRegEx m_args;
-  WorksheetWords m_worksheetWords;
+  //! The words that appear in the worksheet's code cells and how often they appear there
+  std::map<wxString, int> m_worksheetWords;
+  //! Searches the words of the type m_fuzzyMatcherType for CompleteSymbolFuzzy()
+  FuzzyMatcher m_fuzzyMatcher;
+  //! The type of words m_fuzzyMatcher knows about, or -1, if the words have changed
+  int m_fuzzyMatcherType = -1;
 };
 
 #endif // AUTOCOMPLETE_H
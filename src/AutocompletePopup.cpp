@@ -39,7 +39,10 @@
 void AutocompletePopup::UpdateResults()
 {
   m_completions = m_autocomplete->CompleteSymbol(m_partial, m_type);
-  m_completions.Sort();
+  // Unless there is only one word the user can mean, offer the words that only
+  // contain the letters of m_partial, as well, best match first
+  if (m_completions.GetCount() != 1)
+    m_completions = m_autocomplete->CompleteSymbolFuzzy(m_partial, m_type);
 
   switch (m_completions.GetCount())
   {
@@ -98,6 +101,10 @@ void AutocompletePopup::OnKeyDown(wxKeyEvent &event)
       bool addChar = true;
       wxString word = m_editor->GetSelectionString();
       size_t index = word.Length();
+      // Words that only contain the letters of word have no common prefix to extend
+      for (size_t i = 0; i < m_completions.GetCount(); i++)
+        if (!m_completions[i].StartsWith(word))
+          addChar = false;
       do
       {
         if (m_completions[0].Length() <= index)
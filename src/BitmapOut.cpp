@@ -125,6 +125,14 @@ void BitmapOut::Draw()
 }
 
 wxSize BitmapOut::ToFile(const wxString &file)
+{
+  if (SaveImage(ToImage(), file))
+    return m_cmn.GetScaledSize();
+  else
+    return wxDefaultSize;
+}
+
+wxImage BitmapOut::ToImage() const
 {
   // Assign a resolution to the bitmap.
   wxImage img = m_bmp.ConvertToImage();
@@ -132,26 +140,20 @@ wxSize BitmapOut::ToFile(const wxString &file)
   if (resolution <= 0)
     resolution = 75;
   img.SetOption(wxIMAGE_OPTION_RESOLUTION, resolution * m_cmn.GetScale());
+  return img;
+}
 
-  bool success = false;
+bool BitmapOut::SaveImage(const wxImage &img, const wxString &file)
+{
   if (file.EndsWith(wxT(".bmp")))
-    success = img.SaveFile(file, wxBITMAP_TYPE_BMP);
-  else if (file.EndsWith(wxT(".xpm")))
-    success = img.SaveFile(file, wxBITMAP_TYPE_XPM);
-  else if (file.EndsWith(wxT(".jpg")))
-    success = img.SaveFile(file, wxBITMAP_TYPE_JPEG);
-  else
-  {
-    if (file.EndsWith(wxT(".png")))
-      success = img.SaveFile(file, wxBITMAP_TYPE_PNG);
-    else
-      success = img.SaveFile(file + wxT(".png"), wxBITMAP_TYPE_PNG);
-  }
-
-  if (success)
-    return m_cmn.GetScaledSize();
-  else
-    return wxDefaultSize;
+    return img.SaveFile(file, wxBITMAP_TYPE_BMP);
+  if (file.EndsWith(wxT(".xpm")))
+    return img.SaveFile(file, wxBITMAP_TYPE_XPM);
+  if (file.EndsWith(wxT(".jpg")))
+    return img.SaveFile(file, wxBITMAP_TYPE_JPEG);
+  if (file.EndsWith(wxT(".png")))
+    return img.SaveFile(file, wxBITMAP_TYPE_PNG);
+  return img.SaveFile(file + wxT(".png"), wxBITMAP_TYPE_PNG);
 }
 
 std::unique_ptr<wxBitmapDataObject> BitmapOut::GetDataObject() const
@@ -70,6 +70,21 @@ public:
    */
   wxSize ToFile(const wxString &file);
 
+  /*! Returns the bitmap as an image with the resolution set, ready for SaveImage()
+
+    Unlike the bitmap the image can be handed over to a background task.
+   */
+  wxImage ToImage() const;
+
+  /*! Saves an image ToImage() has returned to a file
+
+    Doesn't need to run in the GUI thread.
+   */
+  static bool SaveImage(const wxImage &img, const wxString &file);
+
+  //! The size of the bitmap in pixels
+  wxSize GetScaledSize() const { return m_cmn.GetScaledSize(); }
+
   //! Returns the bitmap representation of the list of cells that was passed to SetData()
   wxBitmap GetBitmap() const { return m_bmp; }
 
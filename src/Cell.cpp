@@ -1180,7 +1180,7 @@ void Cell::SetPen(double lineWidth) const
     configuration->GetAntialiassingDC()->SetPen(pen);
 }
 
-const wxString &Cell::GetValue() const
+wxString Cell::GetValue() const
 {
   return wxm::emptyString;
 }
@@ -468,7 +468,7 @@ public:
   {}
 
   virtual void SetValue(const wxString &WXUNUSED(text)) {}
-  virtual const wxString &GetValue() const;
+  virtual wxString GetValue() const;
 
   //! Get the first cell in this list of cells
   Cell *first() const;
@@ -23,6 +23,7 @@
 
 #include "CellPointers.h"
 #include "GroupCell.h"
+#include <wx/fs_mem.h>
 #include <algorithm>
 #include <iterator>
 
@@ -30,6 +31,14 @@ CellPointers::CellPointers(wxScrolledCanvas *worksheet) :
   m_worksheet(worksheet)
 {}
 
+void CellPointers::WXMXAddFile(const wxString &name, const wxMemoryBuffer &data)
+{
+  if (m_wxmxFiles)
+    m_wxmxFiles->emplace_back(name, data);
+  else
+    wxMemoryFSHandler::AddFile(name, data.GetData(), data.GetDataLen());
+}
+
 wxString CellPointers::WXMXGetNewFileName()
 {
   wxString file(wxT("image"));
@@ -90,6 +99,13 @@ bool CellPointers::ErrorList::Contains(GroupCell * cell) const
 void CellPointers::ErrorList::Add(GroupCell * cell)
 { m_errors.emplace_back(cell); }
 
+void CellPointers::XMLChanged(Cell *cell)
+{
+  // A running animation changes its frame many times between two autosaves.
+  if (std::find(m_xmlChangedCells.begin(), m_xmlChangedCells.end(), cell) == m_xmlChangedCells.end())
+    m_xmlChangedCells.emplace_back(cell);
+}
+
 void CellPointers::SetWorkingGroup(GroupCell *group)
 {
   if (group)
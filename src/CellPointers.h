@@ -25,7 +25,11 @@
 #define WXMAXIMA_CELLPOINTERS_H
 
 #include "Cell.h"
+#include "ConfusableNames.h"
+#include "SearchIndex.h"
+#include <wx/buffer.h>
 #include <wx/string.h>
+#include <list>
 #include <vector>
 
 class wxWindow;
@@ -63,6 +67,27 @@ public:
 
   int WXMXImageCount() const { return m_wxmxImgCounter; }
 
+  //! Skips the file names of images that have been saved before
+  void WXMXSkipImages(int images) { m_wxmxImgCounter += images; }
+
+  //! A file that is saved next to content.xml in a .wxmx file, like an image
+  struct WXMXFile
+  {
+    wxString name;
+    wxMemoryBuffer data;
+    WXMXFile(const wxString &name, const wxMemoryBuffer &data) : name(name), data(data) {}
+  };
+
+  /*! Adds a file to the .wxmx file that is being saved
+
+    Normally stores the file in the memory filesystem. While WXMXCollectFiles()
+    has been given a list the file is appended to that list instead.
+  */
+  void WXMXAddFile(const wxString &name, const wxMemoryBuffer &data);
+
+  //! Makes WXMXAddFile() append the files to files. NULL = use the memory filesystem.
+  void WXMXCollectFiles(std::vector<WXMXFile> *files) { m_wxmxFiles = files; }
+
   bool HasCellsSelected() const { return m_selectionStart && m_selectionEnd; }
 
   //! A list of editor cells containing error messages.
@@ -120,6 +145,41 @@ public:
     for highlighting other instances of the selected string.
   */
   wxString m_selectionString;
+  //! The index Find/Replace searches the EditorCells with
+  SearchIndex m_searchIndex;
+  /*! The string the "highlight all" mode of the find dialog marks in every editor cell
+
+    Empty if nothing is to be highlighted.
+  */
+  wxString m_searchHighlight;
+  //! Is m_searchHighlight to be found regardless of its case?
+  bool m_searchHighlightIgnoreCase = false;
+  //! The variable and function names of all GroupCells, if lookalikes are searched for in the whole worksheet
+  ConfusableNames m_worksheetNames;
+  //! Have the names of a GroupCell changed since m_worksheetNames was made?
+  bool m_worksheetNamesOutdated = true;
+  //! Is increased each time m_worksheetNames is made anew
+  int m_worksheetNamesGeneration = 0;
+  /*! The GroupCells whose output has been generated from XML, the most recently drawn first
+
+    GroupCell::RegisterLoadedOutput() appends the cells whose output wasn't
+    generated for drawing it, so Worksheet::OutputLoaded() unloads these first.
+  */
+  std::list<CellPtr<GroupCell>> m_loadedOutputs;
+  /*! The GroupCells that have turned out to be bigger than estimated while they were drawn
+
+    MatrCell::Draw() adds its group here if an entry it has built needs more
+    room than it had estimated. Worksheet::RedrawIfRequested() lays them out again.
+  */
+  std::vector<CellPtr<GroupCell>> m_groupsToRecalculate;
+  /*! The output cells whose XML attributes have changed since their GroupCell was saved
+
+    For example the frame a slideshow shows. GroupCell::ToXMLCached() doesn't
+    reuse the XML of a GroupCell that contains one of them.
+  */
+  std::vector<CellPtr<Cell>> m_xmlChangedCells;
+  //! Records that the XML attributes of cell have changed
+  void XMLChanged(Cell *cell);
 
   //! Forget where the search was started
   void ResetSearchStart()
@@ -189,6 +249,8 @@ private:
   wxScrolledCanvas *const m_worksheet;
   //! The image counter for saving .wxmx files
   int m_wxmxImgCounter = 0;
+  //! Where WXMXAddFile() puts the files, if not into the memory filesystem
+  std::vector<WXMXFile> *m_wxmxFiles = {};
 public:
   //! Is scrolling to a cell scheduled?
   bool m_scrollToCell = false;
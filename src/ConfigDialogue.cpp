@@ -362,6 +362,10 @@ void ConfigDialogue::SetCheckboxValues()
   m_documentclass->SetToolTip(_("The document class LaTeX is instructed to use for our documents."));
   m_documentclassOptions->SetToolTip(_("The options the document class LaTeX is instructed to use for our documents gets."));
   m_fixedFontInTC->SetToolTip(_("Set fixed font in text controls."));
+  m_lazyOutput->SetToolTip(_("Only generate the cells for maxima's output when it is scrolled into view and forget them again if it hasn't been seen for a long time. Makes worksheets with lots of output faster, but scrolling to an output for the first time a little slower."));
+  m_lazyLayout->SetToolTip(_("After changes that affect the whole worksheet (for example zooming) only lay out the cells near the visible part of the worksheet at once. The other cells keep their old size until they are scrolled into view."));
+  m_cacheRenderedCells->SetToolTip(_("Keep a picture of every cell on the screen and redraw only the cells that have changed. Speeds up scrolling at the cost of memory."));
+  m_checkLookalikesInWholeWorksheet->SetToolTip(_("Names that differ only by chars that look alike (for example a latin \"A\" and a greek \"Alpha\") are marked by a tooltip. If this checkbox is set names in different cells are compared, too."));
   m_offerKnownAnswers->SetToolTip(_("wxMaxima remembers the answers to maxima's questions. If this checkbox is set it automatically offers to enter the last answer to this question the user has input."));
   m_getFont->SetToolTip(_("Font used for display in document."));
   m_getMathFont->SetToolTip(_("Font used for displaying math characters in document."));
@@ -484,6 +488,10 @@ void ConfigDialogue::SetCheckboxValues()
   m_notifyIfIdle->SetValue(configuration->NotifyIfIdle());
   m_fixedFontInTC->SetValue(fixedFontTC);
   m_offerKnownAnswers->SetValue(m_configuration->OfferKnownAnswers());
+  m_checkLookalikesInWholeWorksheet->SetValue(m_configuration->CheckLookalikesInWholeWorksheet());
+  m_lazyOutput->SetValue(m_configuration->LazyOutput());
+  m_lazyLayout->SetValue(m_configuration->LazyLayout());
+  m_cacheRenderedCells->SetValue(m_configuration->CacheRenderedCells());
   m_keepPercentWithSpecials->SetValue(keepPercent);
   m_abortOnError->SetValue(configuration->GetAbortOnError());
   m_restartOnReEvaluation->SetValue(configuration->RestartOnReEvaluation());
@@ -647,6 +655,18 @@ wxPanel *ConfigDialogue::CreateWorksheetPanel()
 
   m_offerKnownAnswers = new wxCheckBox(panel, -1, _("Offer answers for questions known from previous runs"));
   vsizer->Add(m_offerKnownAnswers, 0, wxALL, 5);
+
+  m_checkLookalikesInWholeWorksheet = new wxCheckBox(panel, -1, _("Warn about lookalike names in different cells"));
+  vsizer->Add(m_checkLookalikesInWholeWorksheet, 0, wxALL, 5);
+
+  m_lazyOutput = new wxCheckBox(panel, -1, _("Generate the output only when it is scrolled into view"));
+  vsizer->Add(m_lazyOutput, 0, wxALL, 5);
+
+  m_lazyLayout = new wxCheckBox(panel, -1, _("Lay out cells only when they are scrolled into view"));
+  vsizer->Add(m_lazyLayout, 0, wxALL, 5);
+
+  m_cacheRenderedCells = new wxCheckBox(panel, -1, _("Reuse the pictures of cells that haven't changed"));
+  vsizer->Add(m_cacheRenderedCells, 0, wxALL, 5);
   
   vsizer->AddGrowableRow(10);
   panel->SetSizer(vsizer);
@@ -1243,6 +1263,10 @@ void ConfigDialogue::WriteSettings()
   configuration->SetAutosubscript_Num(m_autosubscript->GetSelection());
   config->Write(wxT("fixedFontTC"), m_fixedFontInTC->GetValue());
   configuration->OfferKnownAnswers(m_offerKnownAnswers->GetValue());
+  configuration->CheckLookalikesInWholeWorksheet(m_checkLookalikesInWholeWorksheet->GetValue());
+  configuration->LazyOutput(m_lazyOutput->GetValue());
+  configuration->LazyLayout(m_lazyLayout->GetValue());
+  configuration->CacheRenderedCells(m_cacheRenderedCells->GetValue());
   configuration->SetChangeAsterisk(m_changeAsterisk->GetValue());
   configuration->HidemultiplicationSign(m_hidemultiplicationSign->GetValue());
   configuration->Latin2Greek(m_latin2Greek->GetValue());
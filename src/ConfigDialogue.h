@@ -253,6 +253,10 @@ protected:
   wxTextCtrl *m_symbolPaneAdditionalChars;
   wxCheckBox *m_abortOnError;
   wxCheckBox *m_offerKnownAnswers;
+  wxCheckBox *m_checkLookalikesInWholeWorksheet;
+  wxCheckBox *m_lazyOutput;
+  wxCheckBox *m_lazyLayout;
+  wxCheckBox *m_cacheRenderedCells;
   wxCheckBox *m_restartOnReEvaluation;
   wxCheckBox *m_wrapLatexMath;
   wxCheckBox *m_savePanes;
@@ -123,6 +123,11 @@ void Configuration::ResetAllToDefaults(InitOpt options)
   m_showLength = 2;
   m_useUnicodeMaths = true;
   m_offerKnownAnswers = true;
+  m_checkLookalikesInWholeWorksheet = false;
+  m_lazyOutput = false;
+  m_maxLoadedOutputs = 100;
+  m_lazyLayout = false;
+  m_cacheRenderedCells = false;
   m_parenthesisDrawMode = unknown;
   m_autoWrap = 3;
   m_displayedDigits = 100;
@@ -425,6 +430,11 @@ void Configuration::ReadConfig()
   config->Read("invertBackground", &m_invertBackground);
   config->Read("maxGnuplotMegabytes", &m_maxGnuplotMegabytes);
   config->Read("offerKnownAnswers", &m_offerKnownAnswers);
+  config->Read("checkLookalikesInWholeWorksheet", &m_checkLookalikesInWholeWorksheet);
+  config->Read("lazyOutput", &m_lazyOutput);
+  config->Read("maxLoadedOutputs", &m_maxLoadedOutputs);
+  config->Read("lazyLayout", &m_lazyLayout);
+  config->Read("cacheRenderedCells", &m_cacheRenderedCells);
   config->Read(wxT("documentclass"), &m_documentclass);
   config->Read(wxT("documentclassoptions"), &m_documentclassOptions);
   config->Read(wxT("latin2greek"), &m_latin2greek);
@@ -1065,6 +1075,11 @@ void Configuration::WriteSettings()
   config->Write("language",m_language);
   config->Write("maxGnuplotMegabytes",m_maxGnuplotMegabytes);
   config->Write("offerKnownAnswers",m_offerKnownAnswers);
+  config->Write("checkLookalikesInWholeWorksheet",m_checkLookalikesInWholeWorksheet);
+  config->Write("lazyOutput",m_lazyOutput);
+  config->Write("maxLoadedOutputs",m_maxLoadedOutputs);
+  config->Write("lazyLayout",m_lazyLayout);
+  config->Write("cacheRenderedCells",m_cacheRenderedCells);
   config->Write("documentclass",m_documentclass);
   config->Write("documentclassoptions",m_documentclassOptions);
   config->Write("HTMLequationFormat", (int) (m_htmlEquationFormat));
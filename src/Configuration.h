@@ -752,6 +752,24 @@ public:
   bool OfferKnownAnswers() const {return m_offerKnownAnswers;}
   void OfferKnownAnswers(bool offerKnownAnswers)
     {m_offerKnownAnswers = offerKnownAnswers;}
+
+  //! Warn about names that look like names in other cells, not only in the same cell?
+  bool CheckLookalikesInWholeWorksheet() const {return m_checkLookalikesInWholeWorksheet;}
+  void CheckLookalikesInWholeWorksheet(bool check)
+    {m_checkLookalikesInWholeWorksheet = check;}
+
+  //! Generate the cells for maxima's output only when they are drawn the first time?
+  bool LazyOutput() const {return m_lazyOutput;}
+  void LazyOutput(bool lazy) {m_lazyOutput = lazy;}
+  //! How many GroupCells keep the cells for their output if LazyOutput() is true?
+  long MaxLoadedOutputs() const {return m_maxLoadedOutputs;}
+  void MaxLoadedOutputs(long outputs) {m_maxLoadedOutputs = outputs;}
+  //! Recalculate only the cells near the visible part of the worksheet?
+  bool LazyLayout() const {return m_lazyLayout;}
+  void LazyLayout(bool lazy) {m_lazyLayout = lazy;}
+  //! Keep a bitmap of each cell on the screen and reuse it for the next redraw?
+  bool CacheRenderedCells() const {return m_cacheRenderedCells;}
+  void CacheRenderedCells(bool cache) {m_cacheRenderedCells = cache;}
   
   wxString Documentclass() const {return m_documentclass;}
   void Documentclass(wxString clss){m_documentclass = clss;}
@@ -913,6 +931,11 @@ private:
   bool m_abortOnError;
   bool m_hidemultiplicationsign;
   bool m_offerKnownAnswers;
+  bool m_checkLookalikesInWholeWorksheet;
+  bool m_lazyOutput;
+  long m_maxLoadedOutputs;
+  bool m_lazyLayout;
+  bool m_cacheRenderedCells;
   long m_defaultPort;
   long m_maxGnuplotMegabytes;
   std::unique_ptr<CellRedrawTrace> m_cellRedrawTrace;
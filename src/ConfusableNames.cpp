@@ -0,0 +1,163 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class ConfusableNames that finds names that look alike.
+ */
+
+#include "ConfusableNames.h"
+#include <algorithm>
+#include <functional>
+
+namespace {
+//! Pairs of chars that look alike
+const wxChar *const lookalikeChars[][2] = {
+  {wxT("µ"), wxT("\u03bc")},
+  {wxT("\u2126"), wxT("\u03a9")},
+  {wxT("C"), wxT("\u03F2")},
+  {wxT("C"), wxT("\u0421")},
+  {wxT("\u03F2"), wxT("\u0421")},
+  {wxT("A"), wxT("\u0391")},
+  {wxT("A"), wxT("\u0410")},
+  {wxT("\u0391"), wxT("\u0410")},
+  {wxT("E"), wxT("\u0395")},
+  {wxT("E"), wxT("\u0415")},
+  {wxT("\u0415"), wxT("\u0395")},
+  {wxT("Z"), wxT("\u0396")},
+  {wxT("H"), wxT("\u0397")},
+  {wxT("H"), wxT("\u041D")},
+  {wxT("\u0397"), wxT("\u041D")},
+  {wxT("I"), wxT("\u0399")},
+  {wxT("I"), wxT("\u0406")},
+  {wxT("l"), wxT("\u0406")},
+  {wxT("K"), wxT("\u039A")},
+  {wxT("K"), wxT("\u041A")},
+  {wxT("\u039A"), wxT("\u041A")},
+  {wxT("\u212a"), wxT("\u041A")},
+  {wxT("K"), wxT("\u212A")},
+  {wxT("M"), wxT("\u041c")},
+  {wxT("\u039C"), wxT("\u041c")},
+  {wxT("M"), wxT("\u039C")},
+  {wxT("N"), wxT("\u039D")},
+  {wxT("O"), wxT("\u039F")},
+  {wxT("O"), wxT("\u041E")},
+  {wxT("\u039F"), wxT("\u041E")},
+  {wxT("\u039F"), wxT("\u041E")},
+  {wxT("P"), wxT("\u03A1")},
+  {wxT("X"), wxT("\u0425")},
+  {wxT("e"), wxT("\u0435")},
+  {wxT("p"), wxT("\u0440")},
+  {wxT("x"), wxT("\u0445")},
+  {wxT("y"), wxT("\u0443")},
+  {wxT("P"), wxT("\u0420")},
+  {wxT("\u03A1"), wxT("\u0420")},
+  {wxT("T"), wxT("\u03A4")},
+  {wxT("T"), wxT("\u0422")},
+  {wxT("\u03A4"), wxT("\u0422")},
+  {wxT("Y"), wxT("\u03A5")},
+  {wxT("\u212a"), wxT("\u039A")},
+  {wxT("l"), wxT("I")},
+  {wxT("B"), wxT("\u0392")},
+  {wxT("S"), wxT("\u0405")},
+  {wxT("\u0392"), wxT("\u0412")},
+  {wxT("B"), wxT("\u0412")},
+  {wxT("J"), wxT("\u0408")},
+  {wxT("a"), wxT("\u0430")},
+  {wxT("o"), wxT("\u03bf")},
+  {wxT("\u03a3"), wxT("\u2211")},
+  {wxT("o"), wxT("\u043e")},
+  {wxT("\u03bf"), wxT("\u043e")},
+  {wxT("c"), wxT("\u0441")},
+  {wxT("s"), wxT("\u0455")},
+  {wxT("t"), wxT("\u03c4")},
+  {wxT("u"), wxT("\u03c5")},
+  {wxT("x"), wxT("\u03c7")},
+  {wxT("ü"), wxT("\u03cb")},
+  {wxT("\u0460"), wxT("\u03c9")},
+  {wxT("\u0472"), wxT("\u0398")}
+};
+}
+
+const std::unordered_map<wxChar, wxChar> &ConfusableNames::SkeletonChars()
+{
+  static const std::unordered_map<wxChar, wxChar> skeletonChars = [] {
+    // If a looks like b and b looks like c all three are represented by the
+    // same char: Each group of lookalikes is represented by its smallest char.
+    std::unordered_map<wxChar, wxChar> representative;
+    std::function<wxChar(wxChar)> find = [&](wxChar ch) {
+      auto it = representative.find(ch);
+      if ((it == representative.end()) || (it->second == ch))
+        return ch;
+      return it->second = find(it->second);
+    };
+    for (auto const &pair : lookalikeChars)
+    {
+      wxChar a = find(pair[0][0]);
+      wxChar b = find(pair[1][0]);
+      representative[a] = representative[b] = std::min(a, b);
+    }
+    for (auto &ch : representative)
+      ch.second = find(ch.first);
+    return representative;
+  }();
+  return skeletonChars;
+}
+
+wxString ConfusableNames::Skeleton(const wxString &name)
+{
+  auto const &skeletonChars = SkeletonChars();
+  wxString skeleton;
+  skeleton.reserve(name.length());
+  for (wxChar ch : name)
+  {
+    auto it = skeletonChars.find(ch);
+    skeleton += (it != skeletonChars.end()) ? it->second : ch;
+  }
+  return skeleton;
+}
+
+void ConfusableNames::Add(const wxString &name)
+{
+  auto &names = m_names[Skeleton(name)];
+  if (std::find(names.begin(), names.end(), name) == names.end())
+    names.push_back(name);
+}
+
+std::vector<wxString> ConfusableNames::GetLookalikes(const wxString &name) const
+{
+  std::vector<wxString> lookalikes;
+  auto it = m_names.find(Skeleton(name));
+  if (it != m_names.end())
+    for (auto const &other : it->second)
+      if (other != name)
+        lookalikes.push_back(other);
+  return lookalikes;
+}
+
+std::vector<std::pair<wxString, wxString>> ConfusableNames::GetLookalikePairs() const
+{
+  std::vector<std::pair<wxString, wxString>> pairs;
+  for (auto const &names : m_names)
+    for (size_t i = 0; i < names.second.size(); i++)
+      for (size_t j = i + 1; j < names.second.size(); j++)
+        pairs.emplace_back(names.second[i], names.second[j]);
+  return pairs;
+}
@@ -0,0 +1,67 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class ConfusableNames that finds names that look alike.
+ */
+
+#ifndef CONFUSABLENAMES_H
+#define CONFUSABLENAMES_H
+
+#include <wx/string.h>
+#include <wx/hashmap.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*! Finds variable and function names that look alike but aren't the same
+
+  A latin "A" and a greek "Alpha" look the same, but for maxima "A" and "Α"
+  are different variables. Instead of trying every lookalike char on every
+  pair of names we replace each lookalike char by a char that represents all
+  chars that look like it. Two names that differ, but are the same after
+  this replacement (which gives their "skeleton"), look alike. A hash map from
+  the skeletons to the names finds them in a single pass over all names.
+ */
+class ConfusableNames
+{
+public:
+  //! Returns name with all lookalike chars replaced by the same char
+  static wxString Skeleton(const wxString &name);
+
+  //! Forget all names
+  void Clear() { m_names.clear(); }
+  //! Add a name. Adding a name twice doesn't do any harm.
+  void Add(const wxString &name);
+  //! Returns the names that look like name, but aren't name
+  std::vector<wxString> GetLookalikes(const wxString &name) const;
+  //! Returns all pairs of names that look alike
+  std::vector<std::pair<wxString, wxString>> GetLookalikePairs() const;
+
+private:
+  //! Maps each lookalike char to the char that represents it in skeletons
+  static const std::unordered_map<wxChar, wxChar> &SkeletonChars();
+
+  //! The names for each skeleton
+  std::unordered_map<wxString, std::vector<wxString>, wxStringHash, wxStringEqual> m_names;
+};
+
+#endif // CONFUSABLENAMES_H
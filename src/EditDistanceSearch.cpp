@@ -0,0 +1,123 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class EditDistanceSearch that finds similar words.
+ */
+
+#include "EditDistanceSearch.h"
+#include "levenshtein/levenshtein.h"
+#include <algorithm>
+#include <cstdint>
+
+void EditDistanceSearch::Clear()
+{
+  m_words.clear();
+  m_count = 0;
+}
+
+void EditDistanceSearch::Add(const wxString &word)
+{
+  if (m_words.size() <= word.Length())
+    m_words.resize(word.Length() + 1);
+  m_words[word.Length()].push_back(word);
+  m_count++;
+}
+
+std::vector<std::pair<int, wxString>> EditDistanceSearch::Find(const wxString &word, int maxDistance) const
+{
+  std::vector<std::pair<int, wxString>> result;
+  size_t minLength = (word.Length() > static_cast<size_t>(maxDistance)) ? word.Length() - maxDistance : 0;
+  size_t maxLength = std::min(word.Length() + maxDistance + 1, m_words.size());
+  for (size_t length = minLength; length < maxLength; length++)
+    for (auto const &candidate : m_words[length])
+    {
+      int distance = Distance(word, candidate, maxDistance);
+      if (distance <= maxDistance)
+        result.emplace_back(distance, candidate);
+    }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+int EditDistanceSearch::Distance(const wxString &pattern, const wxString &text, int maxDistance)
+{
+  size_t m = pattern.Length();
+  if (m == 0)
+    return static_cast<int>(text.Length());
+  if (m > 64)
+    return LevenshteinDistance(pattern, text);
+
+  // Bit i of eq[ch] tells if pattern[i] == ch. Names are mostly ASCII, the rest
+  // is looked up in the pattern.
+  std::uint64_t eq[128] = {};
+  {
+    std::uint64_t bit = 1;
+    for (auto ch : pattern)
+    {
+      if (ch < 128)
+        eq[static_cast<int>(ch)] |= bit;
+      bit <<= 1;
+    }
+  }
+
+  // The vertical deltas of the current column of the distance matrix
+  std::uint64_t plus = ~std::uint64_t(0);
+  std::uint64_t minus = 0;
+  const std::uint64_t last = std::uint64_t(1) << (m - 1);
+  int distance = static_cast<int>(m);
+  int remaining = static_cast<int>(text.Length());
+  for (auto ch : text)
+  {
+    std::uint64_t match;
+    if (ch < 128)
+      match = eq[static_cast<int>(ch)];
+    else
+    {
+      match = 0;
+      std::uint64_t bit = 1;
+      for (auto patternCh : pattern)
+      {
+        if (patternCh == ch)
+          match |= bit;
+        bit <<= 1;
+      }
+    }
+
+    std::uint64_t x = match | minus;
+    std::uint64_t diagonalZero = (((x & plus) + plus) ^ plus) | x;
+    std::uint64_t horizontalPlus = minus | ~(diagonalZero | plus);
+    std::uint64_t horizontalMinus = plus & diagonalZero;
+    if (horizontalPlus & last)
+      distance++;
+    if (horizontalMinus & last)
+      distance--;
+    // Each char of text can reduce the distance by only one
+    remaining--;
+    if (distance - remaining > maxDistance)
+      return maxDistance + 1;
+    horizontalPlus = (horizontalPlus << 1) | 1;
+    horizontalMinus <<= 1;
+    plus = horizontalMinus | ~(diagonalZero | horizontalPlus);
+    minus = horizontalPlus & diagonalZero;
+  }
+  return distance;
+}
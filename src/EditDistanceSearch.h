@@ -0,0 +1,70 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class EditDistanceSearch that finds similar words.
+ */
+
+#ifndef EDITDISTANCESEARCH_H
+#define EDITDISTANCESEARCH_H
+
+#include <wx/string.h>
+#include <utility>
+#include <vector>
+
+/*! Finds the words that are within a small Levenshtein distance of a word
+
+  Comparing a word with each of the thousands of subjects maxima's manual has
+  using a full matrix of edit distances each takes long. Instead we group the
+  words by length: Two words whose lengths differ by more than the allowed
+  distance cannot be similar enough. For the remaining words Myers' bit-parallel
+  algorithm calculates a whole column of the matrix in a few machine instructions
+  and gives up as soon as the distance cannot get small enough any more.
+ */
+class EditDistanceSearch
+{
+public:
+  //! Forget all words
+  void Clear();
+  //! Add a word to search in
+  void Add(const wxString &word);
+  //! The number of words we search in
+  size_t GetCount() const { return m_count; }
+
+  /*! Returns the words whose distance from word is at most maxDistance
+
+    The result is sorted by distance and contains pairs of the distance and the word.
+  */
+  std::vector<std::pair<int, wxString>> Find(const wxString &word, int maxDistance) const;
+
+  /*! The Levenshtein distance between pattern and text
+
+    Returns a value bigger than maxDistance if the distance is bigger than maxDistance.
+  */
+  static int Distance(const wxString &pattern, const wxString &text, int maxDistance);
+
+private:
+  //! m_words[i] contains the words with the length i
+  std::vector<std::vector<wxString>> m_words;
+  size_t m_count = 0;
+};
+
+#endif // EDITDISTANCESEARCH_H
@@ -31,12 +31,15 @@
 
 #include "CellPointers.h"
 #include "MarkDown.h"
+#include "TextExtentCache.h"
 #include "wxMaxima.h"
 #include "wxMaximaFrame.h"
 #include <wx/clipbrd.h>
 #include <wx/regex.h>
 #include <wx/tokenzr.h>
 
+unsigned long EditorCell::m_lastTextRevision = 0;
+
 EditorCell::EditorCell(GroupCell *parent, Configuration **config, const wxString &text) :
     Cell(parent, config),
     m_text(text)
@@ -273,6 +276,7 @@ wxString EditorCell::PrependNBSP(wxString input)
 // cppcheck-suppress uninitMemberVar symbolName=EditorCell::m_endHistory
 // cppcheck-suppress uninitMemberVar symbolName=EditorCell::m_fontName
 // cppcheck-suppress uninitMemberVar symbolName=EditorCell::m_tokens
+// cppcheck-suppress uninitMemberVar symbolName=EditorCell::m_tokenizedText
 EditorCell::EditorCell(const EditorCell &cell):
   EditorCell(cell.m_group, cell.m_configuration, cell.m_text)
 {
@@ -610,26 +614,22 @@ void EditorCell::ConvertNumToUNicodeChar()
 
 void EditorCell::Recalculate(AFontSize fontsize)
 {
-  Configuration *configuration = (*m_configuration);
-  if (IsZoomFactorChanged())
-    m_widths.clear();
-
   m_isDirty = false;
   if (NeedsRecalculation(fontsize))
   {
     StyleText();
     m_fontSize_Last = Scale_Px(fontsize);
-    wxDC *dc = configuration->GetDC();
     SetFont();
 
     // Measure the text hight using characters that might extend below or above the region
     // ordinary characters move in.
-    int charWidth;
-    dc->GetTextExtent(wxT("äXÄgy"), &charWidth, &m_charHeight);
+    wxSize charSize = GetTextSize(wxT("äXÄgy"));
+    int charWidth = charSize.GetWidth();
+    m_charHeight = charSize.GetHeight();
 
     // We want a little bit of vertical space between two text lines (and between two labels).
     m_charHeight += 2 * MC_TEXT_PADDING;
-    int width = 0, tokenwidth, tokenheight, linewidth = 0;
+    int width = 0, linewidth = 0;
 
     m_numberOfLines = 1;
 
@@ -648,8 +648,7 @@ void EditorCell::Recalculate(AFontSize fontsize)
       }
       else
       {
-        dc->GetTextExtent(textSnippet->GetText(), &tokenwidth, &tokenheight);
-        linewidth += tokenwidth;
+        linewidth += GetTextSize(textSnippet->GetText()).GetWidth();
         width = wxMax(width, linewidth);
       }
     }
@@ -850,6 +849,21 @@ void EditorCell::Draw(wxPoint point)
       }
     }
 
+    //
+    // Mark all matches of the find dialog's search string
+    //
+    if (!m_cellPointers->m_searchHighlight.IsEmpty())
+    {
+      std::vector<size_t> matches;
+      m_cellPointers->m_searchIndex.Find(this, m_textRevision, m_text,
+                                         m_cellPointers->m_searchHighlight,
+                                         m_cellPointers->m_searchHighlightIgnoreCase, matches);
+      for (auto start : matches)
+        if ((!IsActive()) || (static_cast<long>(start) != wxMin(m_selectionStart, m_selectionEnd)))
+          MarkSelection(start, start + m_cellPointers->m_searchHighlight.Length(),
+                        TS_EQUALSSELECTION, m_fontSize);
+    }
+
     if (IsActive()) // draw selection or matching parens
     {
       //
@@ -1000,18 +1014,6 @@ void EditorCell::Draw(wxPoint point)
   }
 }
 
-void EditorCell::SetType(CellType type)
-{
-  m_widths.clear();
-  Cell::SetType(type);
-}
-
-void EditorCell::SetStyle(TextStyle style)
-{
-  m_widths.clear();
-  Cell::SetStyle(style);
-}
-
 void EditorCell::SetFont()
 {
   Configuration *configuration = (*m_configuration);
@@ -1059,21 +1061,12 @@ void EditorCell::SetFont()
   wxASSERT_MSG(style.IsFontOk(),
                _("Seems like something is broken with a font."));
   dc->SetFont(style.GetFont());
+  m_dcStyle = style;
 }
 
 wxSize EditorCell::GetTextSize(wxString const &text)
 {
-  wxDC *dc = (*m_configuration)->GetDC();
-  StringHash::const_iterator it = m_widths.find(text);
-
-  // If we already know this text piece's size we return the cached value
-  if(it != m_widths.end())
-    return it->second;
-
-  // Ask wxWidgets to return this text piece's size (slow!)
-  wxSize sz = dc->GetTextExtent(text);
-  m_widths[text] = sz;
-  return sz;
+  return TextExtentCache::GetATextExtent((*m_configuration)->GetDC(), m_dcStyle, text);
 }
 
 void EditorCell::SetForeground()
@@ -2233,11 +2226,6 @@ bool EditorCell::HandleOrdinaryKey(wxKeyEvent &event)
     return false;
   }
 
-  // It may be not too intelligent to cache all pieces of a word we arrived at
-  // during typing
-  if(keyCode == ' ')
-    m_widths.clear();
-
   if (m_historyPosition != -1)
   {
     m_history.erase(m_history.begin() + m_historyPosition + 1, m_history.end());
@@ -3407,8 +3395,18 @@ void EditorCell::StyleTextCode()
     }
   }
 
-  // Split the line into commands, numbers etc.
-  m_tokens = MaximaTokenizer(textToStyle, *m_configuration).PopTokens();
+  // Split the line into commands, numbers etc. Typically only a few chars have
+  // changed since the last time => we can re-use most of the old tokens.
+  Configuration *configuration = *m_configuration;
+  if ((m_tokenizedChangeAsterisk == configuration->GetChangeAsterisk()) &&
+      (m_tokenizedInLispMode == configuration->InLispMode()))
+    m_tokens = MaximaTokenizer(textToStyle, configuration,
+                               m_tokenizedText, std::move(m_tokens)).PopTokens();
+  else
+    m_tokens = MaximaTokenizer(textToStyle, configuration).PopTokens();
+  m_tokenizedText = textToStyle;
+  m_tokenizedChangeAsterisk = configuration->GetChangeAsterisk();
+  m_tokenizedInLispMode = configuration->InLispMode();
 
   // Now handle the text pieces one by one
   wxString lastTokenWithText;
@@ -3765,6 +3763,8 @@ void EditorCell::StyleTextTexts()
 
 void EditorCell::StyleText()
 {
+  m_textRevision = ++m_lastTextRevision;
+
   // We will need to determine the width of text and therefore need to set
   // the font type and size.
   SetFont();
@@ -3925,46 +3925,6 @@ int EditorCell::ReplaceAll(wxString oldString, const wxString &newString, bool i
   return count;
 }
 
-bool EditorCell::FindNext(wxString str, bool down, bool ignoreCase)
-{
-  int start = down ? 0 : m_text.Length();
-  wxString text(m_text);
-
-  text.Replace(wxT('\r'), wxT(' '));
-
-  if (ignoreCase)
-  {
-    str.MakeLower();
-    text.MakeLower();
-  }
-
-  if (m_selectionStart >= 0)
-  {
-    if (down)
-      start = m_selectionStart + 1;
-    else
-      start = m_selectionStart ;
-  }
-  else if (IsActive())
-    start = m_positionOfCaret;
-
-  if (!down && m_selectionStart == 0)
-    return false;
-
-  int strStart = wxNOT_FOUND;
-  if (down)
-    strStart = text.find(str, start);
-  else
-    strStart = text.rfind(str, start);
-
-  if (strStart != wxNOT_FOUND)
-  {
-    SetSelection(strStart, strStart + str.Length());
-    return true;
-  }
-  return false;
-}
-
 bool EditorCell::ReplaceSelection(const wxString &oldStr, const wxString &newString,
                                   bool keepSelected, bool ignoreCase,
                                   bool replaceMaximaString)
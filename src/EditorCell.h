@@ -154,7 +154,7 @@ public:
 
     Naturally all soft line breaks are converted back to spaces beforehand.
    */
-  const wxString &GetValue() const override { return m_text; }
+  wxString GetValue() const override { return m_text; }
 
   /*! Converts m_text to a list of styled text snippets that will later be displayed by draw().
 
@@ -353,18 +353,6 @@ public:
    */
   int ReplaceAll(wxString oldString, const wxString &newString, bool ignoreCase);
 
-  /*! Finds the next occurrences of a string
-
-    \param str The string to search for
-    \param down 
-     - true: search downwards
-     - false: search upwards
-    \param ignoreCase
-     - true: Case-insensitive search
-     - false: Case-sensitive search
-   */
-  bool FindNext(wxString str, bool down, bool ignoreCase);
-
   bool IsSelectionChanged() const { return m_selectionChanged; }
 
   void SetSelection(int start, int end);
@@ -444,9 +432,6 @@ public:
     SetSelection(m_lastSelectionStart, 0);
   }
 
-  void SetType(CellType type) override;
-  void SetStyle(TextStyle style) override;
-
   //! Return to the selection after the cell has been left downwards
   void ReturnToSelectionFromBot()
   {
@@ -456,6 +441,15 @@ public:
   //! Get the list of commands, parenthesis, strings and whitespaces in a code cell
   const MaximaTokenizer::TokenList &GetTokens() const {return m_tokens;}
 
+  /*! A number that changes each time StyleText() styles this cell's text
+
+    No two EditorCells ever share a revision, which allows SearchIndex to tell
+    a new cell from a deleted one that had the same address.
+  */
+  unsigned long GetTextRevision() const {return m_textRevision;}
+  //! The revision the text of the EditorCell that has been changed last has got
+  static unsigned long GetLastTextRevision() {return m_lastTextRevision;}
+
   void SetNextToDraw(Cell *next) override;
 
   Cell *GetNextToDraw() const override {return m_nextToDraw;}
@@ -533,7 +527,6 @@ private:
   {
     ResetSize();
     ResetData();
-    m_widths.clear();
   }
 
   /*! Adds soft line breaks to code cells, if needed.
@@ -583,15 +576,16 @@ private:
 
 //** Large fields
 //**
-  WX_DECLARE_STRING_HASH_MAP(wxSize, StringHash);
-  //! Cached widths of text snippets, one width per style
-  StringHash m_widths;
+  //! The style SetFont() has made the DC use. GetTextSize() measures text in this style.
+  Style m_dcStyle;
 
   //! A list of all potential autoComplete targets within this cell
   std::vector<wxString> m_wordList;
 
   //! The individual commands, parenthesis, strings and whitespaces a code cell consists of
   MaximaTokenizer::TokenList m_tokens;
+  //! The text m_tokens was made from
+  wxString m_tokenizedText;
 
   wxString m_text;
   std::vector<StyledText> m_styledText;
@@ -602,6 +596,10 @@ private:
 //**
   AFontName m_fontName;
   CellPtr<Cell> m_nextToDraw;
+  //! See GetTextRevision()
+  unsigned long m_textRevision = ++m_lastTextRevision;
+  //! See GetLastTextRevision()
+  static unsigned long m_lastTextRevision;
 
 //** 4 bytes
 //**
@@ -663,6 +661,8 @@ private:
     m_isDirty = false;
     m_saveValue = false;
     m_selectionChanged = false;
+    m_tokenizedChangeAsterisk = false;
+    m_tokenizedInLispMode = false;
     m_underlined = false;
   }
 
@@ -678,6 +678,10 @@ private:
   bool m_saveValue :1 /* InitBitFields */;
   //! Has the selection changed since the last draw event?
   bool m_selectionChanged : 1 /* InitBitFields */;
+  //! The ChangeAsterisk setting m_tokens was made with
+  bool m_tokenizedChangeAsterisk : 1 /* InitBitFields */;
+  //! The lisp mode m_tokens was made in
+  bool m_tokenizedInLispMode : 1 /* InitBitFields */;
   //! Does this cell's size have to be recalculated?
   bool m_underlined : 1 /* InitBitFields */;
 };
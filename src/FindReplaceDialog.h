@@ -51,6 +51,14 @@ public:
   void SetFindString(wxString string)
   { m_contents->SetFindString(string); }
 
+  //! Does the user want all matches to be highlighted?
+  bool GetHighlightAll() const
+  { return m_contents->GetHighlightAll(); }
+
+  //! Tell the user how many matches there are. -1 = don't show a number.
+  void SetMatchCount(int count)
+  { m_contents->SetMatchCount(count); }
+
 protected:
   //! Is called if this element looses or gets the focus
   void OnActivate(wxActivateEvent &WXUNUSED(event));
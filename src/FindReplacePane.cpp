@@ -28,8 +28,8 @@
 
 #include "FindReplacePane.h"
 #include "EditorCell.h"
-#include <wx/stattext.h>
 #include <wx/button.h>
+#include <wx/config.h>
 
 FindReplacePane::FindReplacePane(wxWindow *parent, wxFindReplaceData *data) :
         wxPanel(parent, -1)
@@ -120,6 +120,21 @@ FindReplacePane::FindReplacePane(wxWindow *parent, wxFindReplaceData *data) :
           NULL, this
   );
 
+  bool highlightAll = false;
+  wxConfig::Get()->Read(wxT("findHighlightAll"), &highlightAll);
+  m_highlightAll = new wxCheckBox(this, -1, _("Highlight all"));
+  m_highlightAll->SetValue(highlightAll);
+  grid_sizer->Add(m_highlightAll, wxSizerFlags().Expand().Border(wxALL, 5));
+  m_highlightAll->Connect(
+          wxEVT_CHECKBOX,
+          wxCommandEventHandler(FindReplacePane::OnHighlightAll),
+          NULL, this
+  );
+
+  grid_sizer->AddSpacer(0);
+  m_matchCount = new wxStaticText(this, -1, wxEmptyString);
+  grid_sizer->Add(m_matchCount, wxSizerFlags().Expand().Border(wxALL, 5));
+
   // If I press <tab> in the search text box I want to arrive in the
   // replacement text box immediately.
   m_replaceText->MoveAfterInTabOrder(m_searchText);
@@ -175,6 +190,19 @@ void FindReplacePane::OnMatchCase(wxCommandEvent &event)
   wxConfig::Get()->Write(wxT("findFlags"), m_findReplaceData->GetFlags());  
 }
 
+void FindReplacePane::OnHighlightAll(wxCommandEvent &event)
+{
+  wxConfig::Get()->Write(wxT("findHighlightAll"), event.IsChecked());
+}
+
+void FindReplacePane::SetMatchCount(int count)
+{
+  if (count < 0)
+    m_matchCount->SetLabel(wxEmptyString);
+  else
+    m_matchCount->SetLabel(wxString::Format(wxPLURAL("%i match", "%i matches", count), count));
+}
+
 void FindReplacePane::OnActivate(wxActivateEvent &event)
 {
   if (event.GetActive())
@@ -37,6 +37,7 @@
 #include <wx/radiobut.h>
 #include <wx/checkbox.h>
 #include <wx/textctrl.h>
+#include <wx/stattext.h>
 
 /*! The find+replace pane
  */
@@ -55,6 +56,8 @@ private:
   wxRadioButton *m_forward;
   wxRadioButton *m_backwards;
   wxCheckBox *m_matchCase;
+  wxCheckBox *m_highlightAll;
+  wxStaticText *m_matchCount;
 
 public:
   FindReplacePane(wxWindow *parent, wxFindReplaceData *data);
@@ -67,6 +70,13 @@ public:
   wxFindReplaceData *GetData()
   { return m_findReplaceData; }
 
+  //! Does the user want all matches to be highlighted?
+  bool GetHighlightAll() const
+  { return m_highlightAll->GetValue(); }
+
+  //! Tell the user how many matches there are. -1 = don't show a number.
+  void SetMatchCount(int count);
+
 protected:
   void OnActivate(wxActivateEvent &event);
 
@@ -84,6 +94,8 @@ protected:
 
   void OnMatchCase(wxCommandEvent &event);
 
+  void OnHighlightAll(wxCommandEvent &event);
+
   void OnKeyDown(wxKeyEvent &event);
 
 };
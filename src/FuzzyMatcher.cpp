@@ -0,0 +1,190 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class FuzzyMatcher that ranks autocompletion candidates.
+ */
+
+#include "FuzzyMatcher.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+//! The scores of the individual parts of a match
+enum
+{
+  scoreMatch = 16,
+  scoreWordStart = 24,
+  scoreConsecutive = 12,
+  penaltyGapStart = 3,
+  penaltyGapExtension = 1,
+  scoreUsage = 8,
+  maxUsage = 16
+};
+
+bool IsWordChar(wchar_t ch)
+{
+  return ((ch >= L'a') && (ch <= L'z')) || ((ch >= L'0') && (ch <= L'9'));
+}
+}
+
+std::uint64_t FuzzyMatcher::CharMask(const std::wstring &text)
+{
+  std::uint64_t mask = 0;
+  for (auto ch : text)
+  {
+    unsigned bit;
+    if ((ch >= L'a') && (ch <= L'z'))
+      bit = ch - L'a';
+    else if ((ch >= L'0') && (ch <= L'9'))
+      bit = 26 + ch - L'0';
+    else if (ch == L'_')
+      bit = 36;
+    else
+      bit = 37 + static_cast<unsigned>(ch) % 27;
+    mask |= std::uint64_t(1) << bit;
+  }
+  return mask;
+}
+
+void FuzzyMatcher::Add(const wxString &word, int usage)
+{
+  std::wstring lower = word.Lower().ToStdWstring();
+  std::uint64_t mask = CharMask(lower);
+  m_words.push_back({word, std::move(lower), mask, usage});
+}
+
+int FuzzyMatcher::Score(const std::wstring &query, const std::wstring &word)
+{
+  std::vector<int> matched;
+  std::vector<int> best;
+  return Score(query, word, matched, best);
+}
+
+int FuzzyMatcher::Score(const std::wstring &query, const std::wstring &word,
+                        std::vector<int> &matched, std::vector<int> &best)
+{
+  if (query.empty())
+    return 0;
+  if (word.length() < query.length())
+    return -1;
+
+  // The first matching chars we find aren't necessarily the best ones: "le"
+  // should match the "e" of "lsquares_estimates" that starts a part of the word.
+  // So for each query char j and each position i in the word we calculate
+  //  - matched[i]: the best score for query[0...j] if query[j] matches word[i] and
+  //  - best[i]: the best score for query[0...j] if query[j] matches word[0...i].
+  const int none = std::numeric_limits<int>::min() / 2;
+  matched.assign(word.length(), none);
+  best.assign(word.length(), none);
+  for (size_t j = 0; j < query.length(); j++)
+  {
+    // The values for query[j - 1] at i - 1
+    int lastMatched = none;
+    int lastBest = none;
+    int runningBest = none;
+    for (size_t i = 0; i < word.length(); i++)
+    {
+      int score = none;
+      if (word[i] == query[j])
+      {
+        score = scoreMatch;
+        if ((i == 0) || !IsWordChar(word[i - 1]))
+          score += scoreWordStart;
+        if (j == 0)
+          score -= static_cast<int>(i) * penaltyGapExtension;
+        else if (lastBest > none)
+          score += std::max(lastMatched + scoreConsecutive, lastBest - penaltyGapStart);
+        else
+          score = none;
+      }
+      lastMatched = matched[i];
+      lastBest = best[i];
+      matched[i] = score;
+      runningBest = std::max(score, runningBest - penaltyGapExtension);
+      if (runningBest < none)
+        runningBest = none;
+      best[i] = runningBest;
+    }
+  }
+
+  int result = none;
+  for (auto score : matched)
+    result = std::max(result, score);
+  if (result <= none / 2)
+    return -1;
+  return std::max(result, 0);
+}
+
+std::vector<wxString> FuzzyMatcher::Find(const wxString &query, size_t maxFuzzyMatches) const
+{
+  std::wstring lowerQuery = query.Lower().ToStdWstring();
+  std::uint64_t queryMask = CharMask(lowerQuery);
+
+  struct Match
+  {
+    int score;
+    const Word *word;
+    bool operator<(const Match &other) const
+    {
+      if (score != other.score)
+        return score > other.score;
+      return word->word < other.word->word;
+    }
+  };
+  std::vector<Match> prefixMatches;
+  std::vector<Match> fuzzyMatches;
+  std::vector<int> matched;
+  std::vector<int> best;
+  for (auto const &word : m_words)
+  {
+    if (((word.mask & queryMask) != queryMask) || (word.lower.length() < lowerQuery.length()))
+      continue;
+    int score = Score(lowerQuery, word.lower, matched, best);
+    if (score < 0)
+      continue;
+    score += std::min(word.usage, static_cast<int>(maxUsage)) * scoreUsage;
+    // Of two equally good matches the shorter word needs less typing to reach
+    score -= static_cast<int>(word.lower.length());
+    if (word.word.StartsWith(query))
+      prefixMatches.push_back({score, &word});
+    else
+      fuzzyMatches.push_back({score, &word});
+  }
+
+  std::sort(prefixMatches.begin(), prefixMatches.end());
+  if (fuzzyMatches.size() > maxFuzzyMatches)
+  {
+    std::partial_sort(fuzzyMatches.begin(), fuzzyMatches.begin() + maxFuzzyMatches,
+                      fuzzyMatches.end());
+    fuzzyMatches.resize(maxFuzzyMatches);
+  }
+  else
+    std::sort(fuzzyMatches.begin(), fuzzyMatches.end());
+
+  std::vector<wxString> result;
+  result.reserve(prefixMatches.size() + fuzzyMatches.size());
+  for (auto const &match : prefixMatches)
+    result.push_back(match.word->word);
+  for (auto const &match : fuzzyMatches)
+    result.push_back(match.word->word);
+  return result;
+}
@@ -0,0 +1,94 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class FuzzyMatcher that ranks autocompletion candidates.
+ */
+
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <wx/string.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*! Finds the words that contain the chars of a query in the right order
+
+  "intgr" matches "integrate" and "lsq" matches "lsquares". Each match gets a
+  score that is higher if the matched chars are consecutive or start a word
+  or a part of a word after an "_", and the words the user uses often in the
+  current worksheet get a bonus. Words that start with the query always come
+  first, as these are what the user most probably wants.
+
+  For each word we remember a 64-bit mask of the chars it contains. A word whose
+  mask lacks a bit of the query's mask cannot match => Most words are rejected
+  by a single AND and only the rest needs to be scanned.
+ */
+class FuzzyMatcher
+{
+public:
+  //! Forget all words
+  void Clear() { m_words.clear(); }
+  //! Reserve memory for words
+  void Reserve(size_t words) { m_words.reserve(words); }
+  /*! Add a word to search in
+
+    \param word The word
+    \param usage How often the user has used the word. Improves the ranking of the word.
+  */
+  void Add(const wxString &word, int usage = 0);
+  //! The number of words we search in
+  size_t GetCount() const { return m_words.size(); }
+
+  /*! Returns the words that match query, best match first
+
+    \param query The string the user has typed
+    \param maxFuzzyMatches All words starting with query are returned, but only
+           this many of the words that only contain the chars of query.
+  */
+  std::vector<wxString> Find(const wxString &query, size_t maxFuzzyMatches) const;
+
+  /*! How well a word matches a query
+
+    Both strings have to be in lower case. Returns -1 if the word doesn't
+    contain all chars of the query in the right order.
+  */
+  static int Score(const std::wstring &query, const std::wstring &word);
+
+private:
+  //! Score() with buffers that can be re-used for the next word
+  static int Score(const std::wstring &query, const std::wstring &word,
+                   std::vector<int> &matched, std::vector<int> &best);
+  //! Returns a bit for each char that occurs in text
+  static std::uint64_t CharMask(const std::wstring &text);
+
+  struct Word
+  {
+    wxString word;
+    std::wstring lower;
+    std::uint64_t mask;
+    int usage;
+  };
+  std::vector<Word> m_words;
+};
+
+#endif // FUZZYMATCHER_H
@@ -33,13 +33,17 @@
 
 #include "CellPointers.h"
 #include "ImgCell.h"
+#include "RenderTimings.h"
 #include "MarkDown.h"
 #include "SlideShowCell.h"
 #include "TextCell.h"
 #include "LabelCell.h"
+#include "MathParser.h"
+#include "XmlPullParser.h"
 #include "stx/unique_cast.hpp"
 #include <wx/config.h>
 #include <wx/clipbrd.h>
+#include <algorithm>
 
 #if wxUSE_ACCESSIBILITY
   // TODO This class is not used anywhere.
@@ -186,7 +190,7 @@ GroupCell::GroupCell(Configuration **config, GroupType groupType, const wxString
   {
     std::unique_ptr<Cell> ic;
     if (wxImage::GetImageCount(initString) < 2)
-      ic = std::make_unique<ImgCell>(this, m_configuration, initString, std::shared_ptr<wxFileSystem>{} /* system fs */, false);
+      ic = std::make_unique<ImgCell>(this, m_configuration, initString, std::shared_ptr<ZipIndex>{} /* system fs */, false);
     else
       ic = std::make_unique<SlideShow>(this, m_configuration, initString, false);
     AppendOutput(std::move(ic));
@@ -204,6 +208,9 @@ GroupCell::GroupCell(const GroupCell &cell):
     SetInput(cell.m_inputLabel->CopyList());
   if (cell.m_output)
     SetOutput(cell.m_output->CopyList());
+  // Copying the XML is much cheaper than generating and copying the cells
+  m_unloadedOutput = cell.m_unloadedOutput;
+  m_outputRect = cell.m_outputRect;
   Hide(cell.m_isHidden);
   AutoAnswer(cell.m_autoAnswer);
   UpdateYPosition();
@@ -270,6 +277,7 @@ void GroupCell::ResetInputLabelList()
 GroupCell::~GroupCell()
 {
   wxDELETE(m_hiddenTree);
+  m_cellPointers->m_worksheetNamesOutdated = true;
 }
 
 GroupCell *GroupCell::GetLastWorkingGroup() const
@@ -284,6 +292,7 @@ wxString GroupCell::TexEscapeOutputCell(wxString Input)
 
 void GroupCell::SetInput(std::unique_ptr<Cell> &&input)
 {
+  ClearXMLCache();
   if (!input)
     return;
   m_inputLabel = std::move(input);
@@ -294,6 +303,7 @@ void GroupCell::SetInput(std::unique_ptr<Cell> &&input)
 
 void GroupCell::AppendInput(std::unique_ptr<Cell> &&cell)
 {
+  ClearXMLCache();
   if (!m_inputLabel)
   {
     m_inputLabel = std::move(cell);
@@ -322,20 +332,25 @@ void GroupCell::AppendInput(std::unique_ptr<Cell> &&cell)
 
 void GroupCell::SetOutput(std::unique_ptr<Cell> &&output)
 {
+  ClearXMLCache();
   if((m_cellPointers->m_answerCell) &&(m_cellPointers->m_answerCell->GetGroup() == this))
     m_cellPointers->m_answerCell = nullptr;
   
+  m_unloadedOutput.clear();
   m_output.reset();
   AppendOutput(std::move(output));
 }
 
 void GroupCell::RemoveOutput()
 {
+  ClearXMLCache();
   m_numberedAnswersCount = 0;
-  if (m_output == NULL)
+  if ((m_output == NULL) && !IsOutputUnloaded())
     return;
   // If there is nothing to do we can skip the rest of this action.
 
+  m_unloadedOutput.clear();
+
   if((m_cellPointers->m_answerCell) &&(m_cellPointers->m_answerCell->GetGroup() == this))
     m_cellPointers->m_answerCell = nullptr;
 
@@ -363,12 +378,17 @@ void GroupCell::RemoveOutput()
 
 void GroupCell::AppendOutput(std::unique_ptr<Cell> &&cell)
 {
+  ClearXMLCache();
   wxASSERT_MSG(cell, _("Bug: Trying to append NULL to a group cell."));
   if (!cell) return;
+  EnsureOutputLoaded();
   cell->SetGroupList(this);
   if (!m_output)
   {
     m_output = std::move(cell);
+    // Outputs read from a file or appended while off-screen might never be
+    // drawn => they need to be in the list, too, in order to be unloaded.
+    RegisterLoadedOutput();
 
     if (m_groupType == GC_TYPE_CODE && m_inputLabel->m_next != NULL)
       (dynamic_cast<EditorCell *>(m_inputLabel->m_next))->ContainsChanges(false);
@@ -383,67 +403,300 @@ void GroupCell::AppendOutput(std::unique_ptr<Cell> &&cell)
   Recalculate();
 }
 
-WX_DECLARE_STRING_HASH_MAP(int, CmdsAndVariables);
+//! Does this list of cells contain images we cannot regenerate from their XML?
+static bool ContainsImages(const Cell *cell)
+{
+  for (auto *tmp = cell; tmp != NULL; tmp = tmp->m_next)
+  {
+    if ((tmp->GetType() == MC_TYPE_IMAGE) || (tmp->GetType() == MC_TYPE_SLIDE))
+      return true;
+    for (auto inner = tmp->InnerBegin(); inner != tmp->InnerEnd(); ++inner)
+      if (inner && ContainsImages(inner))
+        return true;
+  }
+  return false;
+}
 
-void GroupCell::UpdateConfusableCharWarnings()
+//! Does this list of cells contain slideshows?
+static bool ContainsSlideShows(const Cell *cell)
 {
-  ClearToolTip();
+  for (auto *tmp = cell; tmp != NULL; tmp = tmp->m_next)
+  {
+    if (tmp->GetType() == MC_TYPE_SLIDE)
+      return true;
+    for (auto inner = tmp->InnerBegin(); inner != tmp->InnerEnd(); ++inner)
+      if (inner && ContainsSlideShows(inner))
+        return true;
+  }
+  return false;
+}
 
-  wxString output;
-  if (GetOutput())
-    output += GetOutput()->VariablesAndFunctionsList();
-  // Extract all variable and command names from the cell including input and output
-  CmdsAndVariables cmdsAndVariables;
+bool GroupCell::ContainsSlideShows() const
+{
+  return ::ContainsSlideShows(m_output.get());
+}
+
+static bool ShowsApproximatedImages(const Cell *cell)
+{
+  for (auto *tmp = cell; tmp != NULL; tmp = tmp->m_next)
+  {
+    auto *image = dynamic_cast<const ImgCell *>(tmp);
+    if (image && image->ShowsApproximation())
+      return true;
+    for (auto inner = tmp->InnerBegin(); inner != tmp->InnerEnd(); ++inner)
+      if (inner && ShowsApproximatedImages(inner))
+        return true;
+  }
+  return false;
+}
+
+bool GroupCell::ShowsApproximatedImages() const
+{
+  return ::ShowsApproximatedImages(m_output.get());
+}
+
+bool GroupCell::UnloadOutput()
+{
+  if ((m_groupType != GC_TYPE_CODE) || (m_output == NULL))
+    return false;
+
+  // Cells other parts of wxMaxima are working with have to stay where they are.
+  if ((m_cellPointers->GetWorkingGroup() == this) ||
+      (m_cellPointers->m_answerCell && (m_cellPointers->m_answerCell->GetGroup() == this)) ||
+      (m_cellPointers->m_currentTextCell && (m_cellPointers->m_currentTextCell->GetGroup() == this)) ||
+      (m_cellPointers->m_selectionStart && (m_cellPointers->m_selectionStart->GetGroup() == this)) ||
+      (m_cellPointers->m_selectionEnd && (m_cellPointers->m_selectionEnd->GetGroup() == this)))
+    return false;
+
+  // Images are saved as references into the .wxmx file we might not have.
+  if (ContainsImages(m_output.get()))
+    return false;
+
+  UnloadedOutput unloaded;
+  unloaded.xml = wxT("<mth>") + m_output->ListToXML() + wxT("</mth>");
+  unloaded.type = MC_TYPE_DEFAULT;
+  unloaded.fromMaxima = false;
+  unloaded.bigSkip = false;
+  unloaded.newLine = false;
+  m_unloadedOutput.push_back(unloaded);
+
+  // m_outputRect, m_width and m_height still describe the output we have unloaded
+  // which allows Recalculate() to keep the layout of the worksheet.
+  m_output.reset();
+  UpdateCellsInGroup();
+  return true;
+}
+
+bool GroupCell::AppendUnloadedOutput(const wxString &xml, CellType type, bool bigSkip, bool newLine,
+                                     const wxString &userLabel)
+{
+  ClearXMLCache();
+  if ((m_groupType != GC_TYPE_CODE) || (m_output != NULL))
+    return false;
+
+  UnloadedOutput unloaded;
+  unloaded.xml = xml;
+  unloaded.userLabel = userLabel;
+  unloaded.type = type;
+  unloaded.fromMaxima = true;
+  unloaded.bigSkip = bigSkip;
+  unloaded.newLine = newLine;
+  m_unloadedOutput.push_back(unloaded);
+  m_updateConfusableCharWarnings = true;
+
+  // The same as AppendOutput() does for the first line of output
+  if ((m_unloadedOutput.size() == 1) && (m_inputLabel->m_next != NULL))
+    (dynamic_cast<EditorCell *>(m_inputLabel->m_next))->ContainsChanges(false);
+
+  // Reserve an estimate of the line's height so the cells below this one and
+  // the scrollbar don't jump when the output is drawn for the first time.
+  if (!m_isHidden)
+  {
+    Configuration *configuration = (*m_configuration);
+    if (m_unloadedOutput.size() == 1)
+      m_outputRect = wxRect(m_currentPoint.x, m_currentPoint.y + m_center, 0, 0);
+    m_outputRect.height += configuration->Scale_Px(1.5 * configuration->GetMathFontSize().Get());
+    if (bigSkip)
+      m_outputRect.height += MC_LINE_SKIP;
+    m_height = m_inputHeight + m_outputRect.GetHeight();
+    configuration->AdjustWorksheetSize(true);
+  }
+  return true;
+}
+
+void GroupCell::RegisterLoadedOutput()
+{
+  if (m_inLoadedOutputs || !(*m_configuration)->LazyOutput())
+    return;
+  m_cellPointers->m_loadedOutputs.emplace_back(this);
+  m_inLoadedOutputs = true;
+}
+
+void GroupCell::LoadOutput()
+{
+  std::vector<UnloadedOutput> unloaded;
+  unloaded.swap(m_unloadedOutput);
+
+  MathParser parser(m_configuration);
+  Cell *last = NULL;
+  for (auto const &line : unloaded)
+  {
+    std::unique_ptr<Cell> cell;
+    if (line.fromMaxima)
+    {
+      parser.SetUserLabel(line.userLabel);
+      cell.reset(parser.ParseLine(line.xml, line.type));
+      if (!cell)
+        continue;
+      cell->SetSkip(line.bigSkip);
+      cell->ForceBreakLine(line.newLine || cell->BreakLineHere());
+    }
+    else if (!parser.ParseLineStreaming(line.xml, cell))
+      cell.reset(parser.ParseLine(line.xml, line.type));
+    if (!cell)
+      continue;
+
+    cell->SetGroupList(this);
+    // Don't use AppendOutput(): Loading the output doesn't mean that the input
+    // has been evaluated again.
+    if (!m_output)
+      m_output = std::move(cell);
+    else
+      last->AppendCell(std::move(cell));
+    last = m_output->last();
+  }
+  // Saving, copying or searching the worksheet loads outputs without drawing
+  // them => Make sure they get unloaded again.
+  RegisterLoadedOutput();
+
+  // m_variablesAndFunctions already knows the names the XML contained.
+  UpdateCellsInGroup();
+  ResetData();
+  Recalculate();
+}
+
+/*! The names in the XML of an output, as Cell::VariablesAndFunctionsList() would return them
+
+  Allows to find out about the names without generating the output's cells.
+*/
+static wxString VariablesAndFunctionsInXML(const wxString &xml)
+{
+  wxString retval;
+  // XmlPullParser expects exactly one root element
+  wxString document = wxT("<r>") + xml + wxT("</r>");
+  XmlPullParser parser(document);
+  bool inName = false;
+  while (true)
+  {
+    switch (parser.Next())
+    {
+    case XmlPullParser::StartElement:
+      // Variables, function names and labels
+      inName = (parser.GetName() == wxT("v")) || (parser.GetName() == wxT("fnm")) ||
+        (parser.GetName() == wxT("lbl"));
+      break;
+    case XmlPullParser::EndElement:
+      if (inName)
+        retval << wxT(" ");
+      inName = false;
+      break;
+    case XmlPullParser::Text:
+      if (inName)
+        retval << parser.GetText();
+      break;
+    default:
+      return retval;
+    }
+  }
+}
 
+void GroupCell::UpdateVariablesAndFunctions()
+{
+  m_variablesAndFunctions.clear();
+
+  // Extract all variable and command names from the cell including input and output
+  wxString output;
+  if (IsOutputUnloaded())
+  {
+    for (auto const &line : m_unloadedOutput)
+      output += VariablesAndFunctionsInXML(line.xml);
+  }
+  else if (m_output)
+    output += m_output->VariablesAndFunctionsList();
   if (GetInput())
     for (auto const &tok : MaximaTokenizer(
            output, *m_configuration, GetInput()->GetTokens()).PopTokens())
       if((tok.GetStyle() == TS_CODE_VARIABLE) || (tok.GetStyle() == TS_CODE_FUNCTION))
-        cmdsAndVariables[tok.GetText()] = 1;
-  
-  // Now we step through all the words we found
-  while(!cmdsAndVariables.empty())
-  {
-    CmdsAndVariables::iterator cmp = cmdsAndVariables.begin();
-    wxString word;
-    word = cmp->first;
-    cmdsAndVariables.erase(cmp);
-    // Now iterate through all remaining words
-    cmp = cmdsAndVariables.begin();
-    while(cmp != cmdsAndVariables.end())
-    {
-      // iterate through all lookalike chars
-      for (wxString::const_iterator it = m_lookalikeChars.begin(); it < m_lookalikeChars.end(); ++it)
-      {
-        wxChar ch1 = *it;
-        ++it;
-        wxASSERT(it < m_lookalikeChars.end());
-        wxChar ch2 = *it;
-        wxString word_subst = word;
-        if(word_subst.Replace(ch1,ch2))
-        {
-          if(cmp->first == word_subst)
-            AddToolTip(_("Warning: Lookalike chars: ") +
-                       cmp->first.utf8_str() + wxT("\u2260") +
-                       word.utf8_str()
-              );
-        }
-        word_subst = word;
-        if(word_subst.Replace(ch2,ch1))
-        {
-          if(cmp->first == word_subst)
-            AddToolTip(_("Warning: Lookalike chars: ") +
-                       cmp->first +
-                       wxT(" \u2260 ") +
-                       word
-              );
-        }
-          
-      }
-      ++cmp;
-    }
-  }
+        m_variablesAndFunctions.push_back(tok.GetText());
+  std::sort(m_variablesAndFunctions.begin(), m_variablesAndFunctions.end());
+  m_variablesAndFunctions.erase(
+    std::unique(m_variablesAndFunctions.begin(), m_variablesAndFunctions.end()),
+    m_variablesAndFunctions.end());
+
   m_updateConfusableCharWarnings = false;
+  m_cellPointers->m_worksheetNamesOutdated = true;
+}
+
+void GroupCell::AddVariablesAndFunctions(ConfusableNames &names)
+{
+  for (GroupCell *group = this; group; group = group->GetNext())
+  {
+    if (group->m_updateConfusableCharWarnings)
+      group->UpdateVariablesAndFunctions();
+    for (auto const &name : group->m_variablesAndFunctions)
+      names.Add(name);
+    if (group->m_hiddenTree)
+      group->m_hiddenTree->AddVariablesAndFunctions(names);
+  }
+}
+
+bool GroupCell::ConfusableCharWarningsOutdated() const
+{
+  if (m_updateConfusableCharWarnings)
+    return true;
+  // The warnings about names in other cells have to go
+  if (!(*m_configuration)->CheckLookalikesInWholeWorksheet())
+    return m_worksheetNamesGeneration >= 0;
+  return m_cellPointers->m_worksheetNamesOutdated ||
+    (m_worksheetNamesGeneration != m_cellPointers->m_worksheetNamesGeneration);
+}
+
+void GroupCell::UpdateConfusableCharWarnings()
+{
+  if (m_updateConfusableCharWarnings)
+    UpdateVariablesAndFunctions();
+  ClearToolTip();
+
+  ConfusableNames names;
+  for (auto const &name : m_variablesAndFunctions)
+    names.Add(name);
+  for (auto const &lookalikes : names.GetLookalikePairs())
+    AddToolTip(_("Warning: Lookalike chars: ") +
+               lookalikes.first + wxT(" \u2260 ") + lookalikes.second);
+
+  m_worksheetNamesGeneration = -1;
+  if (!(*m_configuration)->CheckLookalikesInWholeWorksheet())
+    return;
+
+  // The names of all cells are collected only if one of them has changed
+  CellPointers *cellPointers = m_cellPointers;
+  if (cellPointers->m_worksheetNamesOutdated)
+  {
+    GroupCell *first = this;
+    while (first->GetPrevious())
+      first = first->GetPrevious();
+    cellPointers->m_worksheetNames.Clear();
+    first->AddVariablesAndFunctions(cellPointers->m_worksheetNames);
+    cellPointers->m_worksheetNamesOutdated = false;
+    cellPointers->m_worksheetNamesGeneration++;
+  }
+  for (auto const &name : m_variablesAndFunctions)
+    for (auto const &other : cellPointers->m_worksheetNames.GetLookalikes(name))
+      // Lookalikes within this cell have been reported above
+      if (!std::binary_search(m_variablesAndFunctions.begin(), m_variablesAndFunctions.end(), other))
+        AddToolTip(_("Warning: Lookalike chars in another cell: ") +
+                   other + wxT(" \u2260 ") + name);
+  m_worksheetNamesGeneration = cellPointers->m_worksheetNamesGeneration;
 }
 
 void GroupCell::Recalculate()
@@ -452,6 +705,8 @@ void GroupCell::Recalculate()
 
   if (NeedsRecalculation(m_fontSize))
   {
+    ClearRenderCache();
+    ClearXMLCache();
     m_mathFontSize = (*m_configuration)->GetMathFontSize();
     Configuration *configuration = (*m_configuration);
     m_recalculateWidths = false;
@@ -477,13 +732,52 @@ void GroupCell::Recalculate()
       }  
     }
     else*/
+    if (IsOutputUnloaded())
+    {
+      // We don't know the exact size of the output before we have generated
+      // its cells => keep the last known size until the cell is drawn.
+      m_outputRect.x = m_currentPoint.x;
+      m_outputRect.y = m_currentPoint.y + m_center;
+      if (!m_isHidden)
+      {
+        m_height = m_inputHeight + m_outputRect.GetHeight();
+        m_width = wxMax(m_width, m_outputRect.GetWidth());
+      }
+    }
+    else
       RecalculateHeightOutput();
   }
   UpdateYPosition();
 }
 
+bool GroupCell::RecalculateInRegion(const wxRect &region)
+{
+  // A cell that has never been recalculated doesn't have a size we could use
+  // as an estimate.
+  if ((m_height < 0) || !NeedsRecalculation((*m_configuration)->GetDefaultFontSize()))
+  {
+    Recalculate();
+    return false;
+  }
+
+  UpdateYPosition();
+  if (GetRect().Intersects(region))
+  {
+    Recalculate();
+    return false;
+  }
+
+  // The worksheet resets these flags after each recalculation => remember
+  // that they have been set.
+  if ((*m_configuration)->RecalculationForce() || (*m_configuration)->FontChanged())
+    ResetData();
+  return true;
+}
+
 void GroupCell::InputHeightChanged()
 {
+  ClearRenderCache();
+  ClearXMLCache();
   ResetCellListSizes();
   if(m_inputLabel)
     m_inputLabel->ResetCellListSizes();
@@ -498,6 +792,12 @@ void GroupCell::InputHeightChanged()
     m_outputRect.y = m_currentPoint.y + m_center;
     m_width = wxMax(m_width, m_output->GetLineWidth());
   }
+  else if (IsOutputUnloaded() && !m_isHidden)
+  {
+    m_height += m_outputRect.GetHeight();
+    m_outputRect.y = m_currentPoint.y + m_center;
+    m_width = wxMax(m_width, m_outputRect.GetWidth());
+  }
   m_recalculateWidths = false;
   UpdateYPositionList();
 }
@@ -693,6 +993,7 @@ int GroupCell::GetInputIndent()
 
 void GroupCell::Draw(wxPoint point)
 {
+  RenderTimings::Scope timing(RenderTimings::drawGroup);
   Cell::Draw(point);
 
   Configuration *configuration = (*m_configuration);
@@ -702,7 +1003,9 @@ void GroupCell::Draw(wxPoint point)
 
   if (DrawThisCell(point))
   {
-    if (m_updateConfusableCharWarnings)
+    if (!m_isHidden)
+      EnsureOutputLoaded();
+    if (ConfusableCharWarningsOutdated())
       UpdateConfusableCharWarnings();
 
     wxDC *dc = configuration->GetDC();
@@ -977,7 +1280,8 @@ void GroupCell::DrawBracket()
       points[n++] = {-bracketWidth + lineWidth_2,  lineWidth_2};
 
       // The rest of the bracket
-      if (configuration->ShowCodeCells() && m_groupType == GC_TYPE_CODE && m_output && !m_isHidden)
+      if (configuration->ShowCodeCells() && m_groupType == GC_TYPE_CODE &&
+          (m_output || IsOutputUnloaded()) && !m_isHidden)
       {
         points[n++] = {-bracketWidth + lineWidth_2,      m_inputLabel->GetHeightList()};
         points[n++] = {-bracketWidth / 2 + lineWidth_2,  m_inputLabel->GetHeightList()};
@@ -1010,6 +1314,7 @@ wxString GroupCell::ToString() const
 {
   wxString str;
   Configuration *configuration = (*m_configuration);
+  EnsureOutputLoaded();
 
   if (m_inputLabel != NULL)
   {
@@ -1049,6 +1354,7 @@ wxString GroupCell::ToTeX() const
 wxString GroupCell::ToRTF() const
 {
   Configuration *configuration = (*m_configuration);
+  EnsureOutputLoaded();
   if (m_groupType == GC_TYPE_PAGEBREAK)
     return (wxT("\\page "));
 
@@ -1090,6 +1396,7 @@ wxString GroupCell::ToTeX(wxString imgDir, wxString filename, int *imgCounter) c
 {
   wxASSERT_MSG((imgCounter != NULL), _(wxT("Bug: No image counter to write to!")));
   if (imgCounter == NULL) return wxEmptyString;
+  EnsureOutputLoaded();
   wxString str;
   switch (m_groupType)
   {
@@ -1404,7 +1711,12 @@ wxString GroupCell::ToXML() const
   str += wxT(">\n");
 
   Cell *input = GetInput();
-  Cell *output = GetLabel();
+  // Output UnloadOutput() has converted to XML can be saved without generating
+  // its cells again.
+  bool outputIsXML = IsOutputUnloaded() &&
+    std::none_of(m_unloadedOutput.begin(), m_unloadedOutput.end(),
+                 [](const UnloadedOutput &line) { return line.fromMaxima; });
+  Cell *output = outputIsXML ? NULL : GetLabel();
   // write contents
   switch (m_groupType)
   {
@@ -1422,6 +1734,13 @@ wxString GroupCell::ToXML() const
         str += output->ListToXML();
         str += wxT("\n</mth></output>");
       }
+      else if (outputIsXML)
+      {
+        str += wxT("\n<output>\n");
+        for (auto const &line : m_unloadedOutput)
+          str += line.xml;
+        str += wxT("</output>");
+      }
       break;
     case GC_TYPE_IMAGE:
       if (input != NULL)
@@ -1464,6 +1783,41 @@ wxString GroupCell::ToXML() const
   return str;
 }
 
+const wxString &GroupCell::ToXMLCached(std::vector<CellPointers::WXMXFile> &files)
+{
+  // Typing in a cell doesn't notify the GroupCell => compare the input.
+  wxString input;
+  if (GetEditable())
+    input = GetEditable()->GetValue();
+  // The images are named after their position in the document
+  int firstImage = m_cellPointers->WXMXImageCount();
+  // Output cells like slideshows tell CellPointers if their attributes change.
+  auto &changedCells = m_cellPointers->m_xmlChangedCells;
+  auto mine = std::partition(changedCells.begin(), changedCells.end(),
+                             [this](const CellPtr<Cell> &cell)
+                             { return cell && (cell->GetGroup() != this); });
+  if (std::any_of(mine, changedCells.end(), [](const CellPtr<Cell> &cell){ return bool(cell); }))
+    ClearXMLCache();
+  changedCells.erase(mine, changedCells.end());
+
+  if (m_xmlCache && (m_xmlCache->firstImage == firstImage) && (m_xmlCache->input == input))
+    m_cellPointers->WXMXSkipImages(m_xmlCache->images);
+  else
+  {
+    std::unique_ptr<XMLCache> cache(new XMLCache);
+    cache->input = input;
+    cache->firstImage = firstImage;
+    m_cellPointers->WXMXCollectFiles(&cache->files);
+    cache->xml = ToXML();
+    m_cellPointers->WXMXCollectFiles(NULL);
+    cache->images = m_cellPointers->WXMXImageCount() - firstImage;
+    m_xmlCache = std::move(cache);
+  }
+
+  files.insert(files.end(), m_xmlCache->files.begin(), m_xmlCache->files.end());
+  return m_xmlCache->xml;
+}
+
 void GroupCell::SelectRectGroup(const wxRect &rect, const wxPoint one, const wxPoint two,
                                 CellPtr<Cell> *first, CellPtr<Cell> *last)
 {
@@ -1479,7 +1833,7 @@ void GroupCell::SelectRectGroup(const wxRect &rect, const wxPoint one, const wxP
       (m_inputLabel->ContainsRect(rect))
           )
     m_inputLabel->SelectRect(rect, first, last);
-  else if (m_output != NULL && !m_isHidden && m_outputRect.Contains(rect))
+  else if ((m_output || IsOutputUnloaded()) && !m_isHidden && m_outputRect.Contains(rect))
     SelectRectInOutput(rect, one, two, first, last);
 
   if (!*first || !*last)
@@ -1495,8 +1849,12 @@ void GroupCell::SelectInner(const wxRect &rect, CellPtr<Cell> *first, CellPtr<Ce
 
   if (m_inputLabel->ContainsRect(rect))
     m_inputLabel->SelectRect(rect, first, last);
-  else if (m_output != NULL && !m_isHidden && m_outputRect.Contains(rect))
-    m_output->SelectRect(rect, first, last);
+  else if ((m_output || IsOutputUnloaded()) && !m_isHidden && m_outputRect.Contains(rect))
+  {
+    EnsureOutputLoaded();
+    if (m_output)
+      m_output->SelectRect(rect, first, last);
+  }
 
   if (!*first || !*last)
   {
@@ -1520,6 +1878,7 @@ void GroupCell::SelectRectInOutput(const wxRect &rect, const wxPoint one, const
 {
   if (m_isHidden)
     return;
+  EnsureOutputLoaded();
 
   wxPoint start, end;
 
@@ -1601,6 +1960,7 @@ const wxString &GroupCell::GetToolTip(const wxPoint point) const
   if (m_isHidden)
     return *retval;
   
+  EnsureOutputLoaded();
   for (auto *tmp = m_output.get(); tmp; tmp = tmp->GetNext())
   {
     // If a cell contains a cell containing a tooltip, the tooltip of the
@@ -1705,6 +2065,7 @@ void GroupCell::SelectOutput(CellPtr<Cell> *start, CellPtr<Cell> *end)
   if (m_isHidden)
     return;
 
+  EnsureOutputLoaded();
   *start = m_output;
 
   while (*start && ((*start)->GetStyle() != TS_LABEL) && ((*start)->GetStyle() != TS_USERLABEL))
@@ -1809,6 +2170,7 @@ bool GroupCell::UnBreakUpCells(Cell *cell)
 
 void GroupCell::Hide(bool hide)
 {
+  ClearXMLCache();
   if (IsFoldable())
     return;
 
@@ -1820,8 +2182,9 @@ void GroupCell::Hide(bool hide)
     GetEditable()->SetFirstLineOnly(m_isHidden);
 
   // Don't keep cached versions of scaled images around if they aren't visible at all.
-  if (GetLabel())
-    GetLabel()->ClearCacheList();
+  // An unloaded output has no such images.
+  if (m_output)
+    m_output->ClearCacheList();
 
   ResetSize();
   GetEditable()->ResetSize();
@@ -1837,6 +2200,7 @@ void GroupCell::SwitchHide()
 //
 bool GroupCell::HideTree(GroupCell *tree)
 {
+  ClearXMLCache();
   if (m_hiddenTree)
     return false;
   m_hiddenTree = tree;
@@ -1846,8 +2210,8 @@ bool GroupCell::HideTree(GroupCell *tree)
   GroupCell *tmp = m_hiddenTree;
   while (tmp)
   {
-    if (tmp->GetLabel())
-      tmp->GetLabel()->ClearCacheList();
+    if (tmp->m_output)
+      tmp->m_output->ClearCacheList();
     tmp = tmp->GetNext();
   }
 
@@ -1856,6 +2220,7 @@ bool GroupCell::HideTree(GroupCell *tree)
 
 GroupCell *GroupCell::UnhideTree()
 {
+  ClearXMLCache();
   GroupCell *tree = m_hiddenTree;
   m_hiddenTree->SetHiddenTreeParent(m_hiddenTreeParent);
   m_hiddenTree = NULL;
@@ -1893,6 +2258,7 @@ void GroupCell::SetHiddenTreeParent(GroupCell *parent)
 
 GroupCell *GroupCell::Fold()
 {
+  ClearXMLCache();
   if (!IsFoldable() || m_hiddenTree) // already folded?? shouldn't happen
     return NULL;
   if (m_next == NULL)
@@ -1946,6 +2312,7 @@ GroupCell *GroupCell::Fold()
 // be careful to update m_last if this happens in the main tree in MathCtrl
 GroupCell *GroupCell::Unfold()
 {
+  ClearXMLCache();
   if (!IsFoldable() || !m_hiddenTree)
     return NULL;
 
@@ -2223,69 +2590,3 @@ void GroupCell::SetNextToDraw(Cell *next)
 {
   m_nextToDraw = next;
 }
-
-wxString GroupCell:: m_lookalikeChars(
-    wxT("µ")		wxT("\u03bc")
-    wxT("\u2126")	wxT("\u03a9")
-    wxT("C")		wxT("\u03F2")
-    wxT("C")		wxT("\u0421")
-    wxT("\u03F2")	wxT("\u0421")
-    wxT("A")		wxT("\u0391")
-    wxT("A")		wxT("\u0410")
-    wxT("\u0391")	wxT("\u0410")
-    wxT("M")		wxT("\u0392")
-    wxT("E")		wxT("\u0395")
-    wxT("E")		wxT("\u0415")
-    wxT("\u0415")	wxT("\u0395")
-    wxT("Z")		wxT("\u0396")
-    wxT("H")		wxT("\u0397")
-    wxT("H")		wxT("\u041D")
-    wxT("\u0397")	wxT("\u041D")
-    wxT("I")		wxT("\u0399")
-    wxT("I")		wxT("\u0406")
-    wxT("l")		wxT("\u0406")
-    wxT("K")		wxT("\u039A")
-    wxT("K")		wxT("\u041A")
-    wxT("\u039A")	wxT("\u041A")
-    wxT("\u212a")	wxT("\u041A")
-    wxT("K")		wxT("\u212A")
-    wxT("M")		wxT("\u041c")
-    wxT("\u039C")	wxT("\u041c")
-    wxT("M")		wxT("\u039C")
-    wxT("N")		wxT("\u039D")
-    wxT("O")		wxT("\u039F")
-    wxT("O")		wxT("\u041E")
-    wxT("\u039F")	wxT("\u041E")
-    wxT("\u039F")	wxT("\u041E")
-    wxT("P")		wxT("\u03A1")
-    wxT("X")		wxT("\u0425")
-    wxT("e")		wxT("\u0435")
-    wxT("p")		wxT("\u0440")
-    wxT("x")		wxT("\u0445")
-    wxT("y")		wxT("\u0443")
-    wxT("P")		wxT("\u0420")
-    wxT("\u03A1")	wxT("\u0420")
-    wxT("T")		wxT("\u03A4")
-    wxT("T")		wxT("\u0422")
-    wxT("\u03A4")	wxT("\u0422")
-    wxT("Y")		wxT("\u03A5")
-    wxT("\u212a")	wxT("\u039A")
-    wxT("l")		wxT("I")
-    wxT("B")		wxT("\u0392")
-    wxT("S")		wxT("\u0405")
-    wxT("\u0392")	wxT("\u0412")
-    wxT("B")		wxT("\u0412")
-    wxT("J")		wxT("\u0408")
-    wxT("a")		wxT("\u0430")
-    wxT("o")		wxT("\u03bf")
-    wxT("\u03a3")      wxT("\u2211")
-    wxT("o")		wxT("\u043e")
-    wxT("\u03bf")	wxT("\u043e")
-    wxT("c")		wxT("\u0441")
-    wxT("s")		wxT("\u0455")
-    wxT("t")		wxT("\u03c4")
-    wxT("u")		wxT("\u03c5")
-    wxT("x")		wxT("\u03c7")
-    wxT("ü")		wxT("\u03cb")
-    wxT("\u0460")	wxT("\u03c9")
-    wxT("\u0472")	wxT("\u0398"));
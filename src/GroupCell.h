@@ -31,7 +31,10 @@
 #define GROUPCELL_H
 
 #include "Cell.h"
+#include "CellPointers.h"
 #include "EditorCell.h"
+#include <wx/bitmap.h>
+#include <vector>
 
 //! All types a GroupCell can be of
 // This enum's elements must be synchronized with (WXMFormat.h) WXMHeaderId.
@@ -98,12 +101,14 @@ public:
   {
     m_autoAnswer = autoAnswer;
     if(GetEditable() != NULL) GetEditable()->AutoAnswer(autoAnswer);
+    ClearXMLCache();
   }
   // Add a new answer to the cell
   void SetAnswer(wxString question, wxString answer)
   {
     if (answer != wxEmptyString)
       m_knownAnswers[question] = answer;
+    ClearXMLCache();
   }
 
   InnerCellIterator InnerBegin() const override { return InnerCellIterator(&m_inputLabel); }
@@ -133,7 +138,11 @@ public:
   // general methods
   GroupType GetGroupType() const { return m_groupType; }
 
-  void SetGroupType(GroupType type) { m_groupType = type; }
+  void SetGroupType(GroupType type)
+    {
+      m_groupType = type;
+      ClearXMLCache();
+    }
 
   void SetGroup(GroupCell *parent) override; // setting parent for all mathcells in GC
 
@@ -166,8 +175,79 @@ public:
   */
   void RemoveOutput();
 
-  //! GroupCells warn if they contain both greek and latin lookalike chars.
+  /*! Frees the output cells and keeps only their XML representation
+
+    Used for GroupCells that haven't been drawn for a long time. The size the
+    output had is kept so the worksheet layout doesn't change. The cells are
+    generated again by EnsureOutputLoaded().
+
+    \return false, if this output cannot be unloaded without losing information
+   */
+  bool UnloadOutput();
+  /*! Appends a line of maxima's output without generating cells for it, yet
+
+    Only works if the output currently isn't made of cells.
+
+    \param xml The line in the format MathParser::ParseLine() expects
+    \param type The type MathParser::ParseLine() should assign to the cells
+    \param bigSkip Start the line with a bigger vertical gap
+    \param newLine Start the line in a new line
+    \param userLabel The user-defined label of this output, if there is one
+    \return false, if the line has to be appended as cells
+  */
+  bool AppendUnloadedOutput(const wxString &xml, CellType type, bool bigSkip, bool newLine,
+                            const wxString &userLabel);
+  /*! Appends this cell to CellPointers::m_loadedOutputs, unless it is in that list, already
+
+    The outputs at the end of the list are the first ones Worksheet::OutputLoaded()
+    unloads, so outputs that never have been drawn go there.
+   */
+  void RegisterLoadedOutput();
+  //! Informs this cell if Worksheet::OutputLoaded() has put it in or removed it from CellPointers::m_loadedOutputs
+  void InLoadedOutputs(bool inList) { m_inLoadedOutputs = inList; }
+  //! Is (a part of) our output currently only kept as XML?
+  bool IsOutputUnloaded() const { return !m_unloadedOutput.empty(); }
+  //! Generates the output cells from the XML, if they have been unloaded
+  void EnsureOutputLoaded() const
+    {
+      // The output is part of the cell's contents, not of its identity => This
+      // is allowed for a const cell.
+      if (IsOutputUnloaded())
+        const_cast<GroupCell *>(this)->LoadOutput();
+    }
+
+  /*! The bitmap Worksheet::OnPaint() has drawn this cell into
+
+    Returns wxNullBitmap if there is no such bitmap or if it shows a different
+    part of the worksheet than rect.
+   */
+  const wxBitmap &GetRenderCache(const wxRect &rect) const
+    { return (rect == m_renderCacheRect) ? m_renderCache : wxNullBitmap; }
+  //! Remember the bitmap this cell has been drawn into
+  void SetRenderCache(const wxBitmap &bitmap, const wxRect &rect)
+    {
+      m_renderCache = bitmap;
+      m_renderCacheRect = rect;
+    }
+  //! Forget the bitmap this cell has been drawn into
+  void ClearRenderCache()
+    {
+      m_renderCache = wxNullBitmap;
+      m_renderCacheRect = {};
+    }
+  //! Does this cell contain a slideshow that might change its frame at any moment?
+  bool ContainsSlideShows() const;
+  //! Does this cell show images that will be replaced by their exact rescale soon?
+  bool ShowsApproximatedImages() const;
+
+  /*! GroupCells warn if they contain names that differ only by lookalike chars
+
+    For example a name with a latin "A" and one with a greek "Alpha". If the
+    configuration asks for it names in other cells are taken into account, too.
+  */
   void UpdateConfusableCharWarnings();
+  //! Do the names in this cell or in the worksheet need to be checked for lookalike chars?
+  bool ConfusableCharWarningsOutdated() const;
   
   wxString ToTeX(wxString imgDir, wxString filename, int *imgCounter) const;
 
@@ -184,6 +264,15 @@ public:
 
   wxString ToXML() const override;
 
+  /*! Returns ToXML() and appends the files it saves to files
+
+    Reuses the result of the last call if the cell hasn't changed since then
+    which makes autosaving big worksheets cheap.
+  */
+  const wxString &ToXMLCached(std::vector<CellPointers::WXMXFile> &files);
+  //! Forget the result of the last ToXMLCached()
+  void ClearXMLCache() { m_xmlCache.reset(); }
+
   void Hide(bool hide) override;
 
   void SwitchHide();
@@ -222,14 +311,14 @@ public:
 
     See also GetOutput();
   */
-  Cell *GetLabel() const { return m_output.get(); }
+  Cell *GetLabel() const { EnsureOutputLoaded(); return m_output.get(); }
 
   /*! Returns the list of cells the output consists of, starting after the label.
 
     See also GetLabel()
   */
   Cell *GetOutput() const
-  { if (m_output == NULL) return NULL; else return m_output->m_next; }
+  { EnsureOutputLoaded(); if (m_output == NULL) return NULL; else return m_output->m_next; }
 
   //! Determine which rectangle is occupied by this GroupCell
   wxRect GetOutputRect() const { return m_outputRect; }
@@ -242,6 +331,14 @@ public:
    */
   void Recalculate(AFontSize WXUNUSED(fontsize)) override {Recalculate();}
   void Recalculate();
+  /*! Recalculate() this cell only if it intersects region
+
+    A cell outside region only updates its y position and keeps its last size
+    as an estimate. It still needs to be recalculated later.
+
+    \return true, if the cell still needs to be recalculated.
+  */
+  bool RecalculateInRegion(const wxRect &region);
 
   //! Recalculate the height of the input part of the cell
   void RecalculateHeightInput();
@@ -417,16 +514,37 @@ public:
 
   bool GetSuppressTooltipMarker() const { return m_suppressTooltipMarker; }
   void SetSuppressTooltipMarker(bool suppress)
-    {m_suppressTooltipMarker = suppress;}
+    {
+      m_suppressTooltipMarker = suppress;
+      ClearXMLCache();
+    }
 protected:
   bool NeedsRecalculation(AFontSize fontSize) const override;
   int GetInputIndent();
   int GetLineIndent(Cell *cell);
   void UpdateCellsInGroup();
+  //! Generates the output cells from m_unloadedOutput
+  void LoadOutput();
+
+  //! A line of output we only know the XML of
+  struct UnloadedOutput
+  {
+    //! The XML, including a root element
+    wxString xml;
+    //! The user-defined label for MathParser::SetUserLabel()
+    wxString userLabel;
+    CellType type;
+    //! Does the XML come from maxima and therefore needs MathParser::ParseLine()?
+    bool fromMaxima;
+    bool bigSkip;
+    bool newLine;
+  };
 
 //** 16-byte objects (16 bytes)
 //**
   wxRect m_outputRect{-1, -1, 0, 0};
+  //! The part of the worksheet m_renderCache shows
+  wxRect m_renderCacheRect;
 
 //** 8/4 byte objects (40 bytes)
 //**
@@ -444,10 +562,34 @@ protected:
   std::unique_ptr<Cell> m_output;
   // The pointers above point to inner cells and must be kept contiguous.
 
-//** 4-byte objects (12 bytes)
+  //! The output, if UnloadOutput() has freed the cells it consists of
+  std::vector<UnloadedOutput> m_unloadedOutput;
+  //! The variable and function names this cell contains, sorted
+  std::vector<wxString> m_variablesAndFunctions;
+  //! This cell, as drawn by the last Worksheet::OnPaint()
+  wxBitmap m_renderCache;
+
+  //! What ToXMLCached() has generated the last time
+  struct XMLCache
+  {
+    //! The contents of the input at that time
+    wxString input;
+    wxString xml;
+    //! The value of CellPointers::WXMXImageCount() before the XML was generated
+    int firstImage = 0;
+    //! The number of images the XML refers to
+    int images = 0;
+    //! The images and gnuplot files the XML refers to
+    std::vector<CellPointers::WXMXFile> files;
+  };
+  std::unique_ptr<XMLCache> m_xmlCache;
+
+//** 4-byte objects (16 bytes)
 //**
   int m_labelWidth_cached = 0;
   int m_inputWidth, m_inputHeight;
+  //! The CellPointers::m_worksheetNamesGeneration we have checked our names against, or -1
+  int m_worksheetNamesGeneration = -1;
 
 //** 2-byte objects (6 bytes)
 //**
@@ -471,15 +613,22 @@ protected:
     m_inEvaluationQueue = false;
     m_lastInEvaluationQueue = false;
     m_updateConfusableCharWarnings = true;
+    m_inLoadedOutputs = false;
   }
 
   //! Does this GroupCell automatically fill in the answer to questions?
   bool m_autoAnswer : 1 /* InitBitFields */;
   bool m_inEvaluationQueue : 1 /* InitBitFields */;
   bool m_lastInEvaluationQueue : 1 /* InitBitFields */;
+  //! Does m_variablesAndFunctions need to be updated?
   bool m_updateConfusableCharWarnings : 1 /* InitBitFields */;
+  //! Are we in CellPointers::m_loadedOutputs?
+  bool m_inLoadedOutputs : 1 /* InitBitFields */;
 
-  static wxString m_lookalikeChars;
+  //! Collects the names the cell contains in m_variablesAndFunctions
+  void UpdateVariablesAndFunctions();
+  //! Adds the names of this and all following cells, including folded ones, to names
+  void AddVariablesAndFunctions(ConfusableNames &names);
 };
 
 #endif /* GROUPCELL_H */
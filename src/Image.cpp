@@ -36,6 +36,12 @@
 #include "SvgBitmap.h"
 #include "ErrorRedirector.h"
 #include "StringUtils.h"
+#include <algorithm>
+#include <cstring>
+
+std::list<Image *> Image::m_mipmapUsers;
+size_t Image::m_mipmapBytesTotal = 0;
+constexpr size_t Image::mipmapMemoryBudget;
 
 Image::Image(Configuration **config)
 {
@@ -104,11 +110,11 @@ Image::Image(Configuration **config, const wxBitmap &bitmap)
 }
 
 // constructor which loads an image
-// filesystem cannot be passed by const reference as we want to keep the
-// pointer to the file system alive in a background task
-// cppcheck-suppress performance symbolName=filesystem
-Image::Image(Configuration **config, wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove):
-    m_fs_keepalive_imagedata(filesystem)
+// archive cannot be passed by const reference as we want to keep the
+// pointer to the archive alive in a background task
+// cppcheck-suppress performance symbolName=archive
+Image::Image(Configuration **config, wxString image, std::shared_ptr<ZipIndex> archive, bool remove):
+    m_archive_keepalive_imagedata(archive)
 {
   #ifdef HAVE_OMP_HEADER
   omp_init_lock(&m_gnuplotLock);
@@ -124,7 +130,7 @@ Image::Image(Configuration **config, wxString image, std::shared_ptr<wxFileSyste
   m_maxHeight = -1;
   m_originalWidth = 640;
   m_originalHeight = 480;
-  LoadImage(image, filesystem, remove);
+  LoadImage(image, archive, remove);
 }
 
 Image::~Image()
@@ -133,6 +139,7 @@ Image::~Image()
   #ifdef HAVE_OPENMP_TASKS
   #pragma omp taskwait
   #endif
+  ClearMipmaps();
   {
     if(!m_gnuplotSource.IsEmpty())
     {
@@ -172,6 +179,62 @@ wxMemoryBuffer Image::ReadCompressedImage(wxInputStream *data)
   return retval;
 }
 
+bool Image::ReadImageSize(const wxMemoryBuffer &image, size_t &width, size_t &height)
+{
+  const unsigned char *data = static_cast<const unsigned char *>(image.GetData());
+  size_t length = image.GetDataLen();
+  if (!data)
+    return false;
+
+  // PNG: The signature is followed by the IHDR chunk that starts with the
+  // width and the height as 32-bit big-endian numbers.
+  static const unsigned char pngSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  if ((length >= 24) && (memcmp(data, pngSignature, sizeof(pngSignature)) == 0) &&
+      (memcmp(data + 12, "IHDR", 4) == 0))
+  {
+    width = (size_t(data[16]) << 24) | (size_t(data[17]) << 16) | (size_t(data[18]) << 8) | data[19];
+    height = (size_t(data[20]) << 24) | (size_t(data[21]) << 16) | (size_t(data[22]) << 8) | data[23];
+    return (width > 0) && (height > 0);
+  }
+
+  // GIF: The logical screen size follows the signature as 16-bit little-endian numbers.
+  if ((length >= 10) && ((memcmp(data, "GIF87a", 6) == 0) || (memcmp(data, "GIF89a", 6) == 0)))
+  {
+    width = data[6] | (size_t(data[7]) << 8);
+    height = data[8] | (size_t(data[9]) << 8);
+    return (width > 0) && (height > 0);
+  }
+
+  // JPEG: Walk the segments until we find a "start of frame" one.
+  if ((length >= 4) && (data[0] == 0xff) && (data[1] == 0xd8))
+  {
+    size_t pos = 2;
+    while (pos + 9 < length)
+    {
+      if (data[pos] != 0xff)
+        return false;
+      unsigned char marker = data[pos + 1];
+      // Fill bytes
+      if (marker == 0xff)
+      {
+        pos++;
+        continue;
+      }
+      size_t segmentLength = (size_t(data[pos + 2]) << 8) | data[pos + 3];
+      // SOF0...SOF15, except for DHT (c4), JPG (c8) and DAC (cc)
+      if ((marker >= 0xc0) && (marker <= 0xcf) &&
+          (marker != 0xc4) && (marker != 0xc8) && (marker != 0xcc))
+      {
+        height = (size_t(data[pos + 5]) << 8) | data[pos + 6];
+        width = (size_t(data[pos + 7]) << 8) | data[pos + 8];
+        return (width > 0) && (height > 0);
+      }
+      pos += 2 + segmentLength;
+    }
+  }
+  return false;
+}
+
 wxBitmap Image::GetUnscaledBitmap()
 {
   #ifdef HAVE_OMP_HEADER
@@ -188,12 +251,14 @@ wxBitmap Image::GetUnscaledBitmap()
   {
     std::vector<unsigned char> imgdata(m_originalWidth*m_originalHeight*4);
 
-    nsvgRasterize(m_svgRast.get(), m_svgImage, 0,0,1, imgdata.data(),
-                  m_originalWidth, m_originalHeight, m_originalWidth*4);
+    RasterizeSvg(m_svgImage, 1, imgdata.data(), m_originalWidth, m_originalHeight);
     return SvgBitmap::RGBA2wxBitmap(imgdata.data(), m_originalWidth, m_originalHeight);
   }
   else
   {
+    // No need to decode the image again if we have done so for drawing it
+    if (!m_mipmaps.empty())
+      return wxBitmap(m_mipmaps[0]);
     wxMemoryInputStream istream(m_compressedImage.GetData(), m_compressedImage.GetDataLen());
     wxImage img(istream, wxBITMAP_TYPE_ANY);
     wxBitmap bmp;
@@ -236,20 +301,20 @@ bool Image::IsOk()
 }
 
 
-// filesystem cannot be passed by const reference as we want to keep the
-// pointer to the file system alive in a background task
-// cppcheck-suppress performance symbolName=filesystem
-void Image::GnuplotSource(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem)
+// archive cannot be passed by const reference as we want to keep the
+// pointer to the archive alive in a background task
+// cppcheck-suppress performance symbolName=archive
+void Image::GnuplotSource(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<ZipIndex> archive)
 {
-  m_fs_keepalive_gnuplotdata = filesystem;
+  m_archive_keepalive_gnuplotdata = archive;
   #ifdef HAVE_OPENMP_TASKS
   wxLogMessage(_("Scheduling background task that loads the gnuplot data for a plot."));
   #pragma omp task
   #endif
-  LoadGnuplotSource_Backgroundtask(gnuplotFilename, dataFilename, filesystem);
+  LoadGnuplotSource_Backgroundtask(gnuplotFilename, dataFilename, archive);
 }
 
-void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem)
+void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<ZipIndex> archive)
 {
   #ifdef HAVE_OMP_HEADER
   omp_set_lock(&m_gnuplotLock);
@@ -260,7 +325,7 @@ void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString
   m_gnuplotSource = gnuplotFilename;
   m_gnuplotData = dataFilename;
 
-  if(filesystem == NULL)
+  if(archive == NULL)
   {
     if(wxFileExists(dataFilename))
     {    
@@ -355,14 +420,9 @@ void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString
   else
   {
     {
-      wxFSFile *fsfile;
-      #ifdef HAVE_OPENMP_TASKS
-      #pragma omp critical (OpenFSFile)
-      #endif
-      fsfile = filesystem->OpenFile(m_gnuplotSource);
-      if (fsfile)
+      std::unique_ptr<wxInputStream> input = archive->OpenEntry(m_gnuplotSource);
+      if (input)
       { // open successful
-        std::unique_ptr<wxInputStream> input(fsfile->GetStream());
         if(input->IsOk())
         {
           wxTextInputStream textIn(*input, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
@@ -409,14 +469,9 @@ void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString
       }
     }
     {
-      wxFSFile *fsfile;
-      #ifdef HAVE_OPENMP_TASKS
-      #pragma omp critical (OpenFSFile)
-      #endif
-      fsfile = filesystem->OpenFile(m_gnuplotData);
-      if (fsfile)
+      std::unique_ptr<wxInputStream> input = archive->OpenEntry(m_gnuplotData);
+      if (input)
       { // open successful
-        wxInputStream *input = fsfile->GetStream();
         if(input->IsOk())
         {
           wxTextInputStream textIn(*input, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
@@ -452,7 +507,7 @@ void Image::LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString
       }
     }
   }
-  m_fs_keepalive_gnuplotdata.reset();
+  m_archive_keepalive_gnuplotdata.reset();
   #ifdef HAVE_OMP_HEADER
   omp_unset_lock(&m_gnuplotLock);
   #endif
@@ -756,57 +811,242 @@ wxBitmap Image::GetBitmap(double scale)
   }
   
   // Let's see if we have cached the scaled bitmap with the right size
-  if (m_scaledBitmap.GetWidth() == m_width)
+  if ((m_scaledBitmap.GetWidth() == m_width) &&
+      !(m_scaledBitmapIsApproximation && ExactImageReady()))
     return m_scaledBitmap;
   
+  // Make sure we stay within sane defaults
+  if (m_width < 1)m_width = 1;
+  if (m_height < 1)m_height = 1;
+
   // Seems like we need to create a new scaled bitmap.
   if (m_svgRast)
   {
-    // First create rgba data
-    std::vector<unsigned char> imgdata(m_width*m_height*4);
+    std::unique_ptr<SvgRaster> raster;
+    #ifdef HAVE_OPENMP_TASKS
+    #pragma omp critical (ImageRescale)
+    #endif
+    raster = std::move(m_svgRaster);
 
-    nsvgRasterize(m_svgRast.get(), m_svgImage, 0,0,
-                  ((double)m_width)/((double)m_originalWidth),
-                  imgdata.data(), m_width, m_height, m_width*4);
+    if (raster && (raster->width == m_width) && (raster->height == m_height))
+    {
+      m_scaledBitmap = SvgBitmap::RGBA2wxBitmap(raster->rgba.data(), m_width, m_height);
+      m_scaledBitmapIsApproximation = false;
+    }
+    else
+    {
+      #ifdef HAVE_OPENMP_TASKS
+      // Show the raster we already have, scaled to the new size, until the new one is ready
+      if ((m_scaledBitmap.GetWidth() > 1) && (m_scaledBitmap.GetHeight() > 1))
+        m_scaledBitmap = wxBitmap(m_scaledBitmap.ConvertToImage().Scale(
+                                    m_width, m_height, wxIMAGE_QUALITY_BILINEAR), 32);
+      else
+      {
+        wxImage placeholder(m_width, m_height);
+        placeholder.InitAlpha();
+        std::memset(placeholder.GetAlpha(), 0, m_width * m_height);
+        m_scaledBitmap = wxBitmap(placeholder, 32);
+      }
+      m_scaledBitmapIsApproximation = true;
+      RescaleInBackground();
+      #else
+      std::vector<unsigned char> imgdata(m_width*m_height*4);
+      RasterizeSvg(m_svgImage, ((double)m_width)/((double)m_originalWidth),
+                   imgdata.data(), m_width, m_height);
+      m_scaledBitmap = SvgBitmap::RGBA2wxBitmap(imgdata.data(), m_width, m_height);
+      #endif
+    }
     #ifdef HAVE_OMP_HEADER
     omp_unset_lock(&m_gnuplotLock);
     #endif
-    return m_scaledBitmap = SvgBitmap::RGBA2wxBitmap(imgdata.data(), m_width, m_height);
+    return m_scaledBitmap;
   }
+
+  m_isOk = true;
+  int level = GetMipmapLevel(m_width);
+  if (level < 0)
+  {
+    InvalidBitmap();
+    return m_scaledBitmap;
+  }
+
+  const wxImage &mipmap = m_mipmaps[level];
+  m_scaledBitmapIsApproximation = false;
+  if ((mipmap.GetWidth() == m_width) && (mipmap.GetHeight() == m_height))
+    m_scaledBitmap = wxBitmap(mipmap, 24);
   else
+  {
+    std::unique_ptr<wxImage> exactImage;
+    #ifdef HAVE_OPENMP_TASKS
+    #pragma omp critical (ImageRescale)
+    #endif
+    exactImage = std::move(m_exactImage);
+
+    if (exactImage && (exactImage->GetWidth() == m_width) && (exactImage->GetHeight() == m_height))
+      m_scaledBitmap = wxBitmap(*exactImage, 24);
+    else
+    {
+      #ifdef HAVE_OPENMP_TASKS
+      // Show a good approximation now and the exact image as soon as it is ready
+      m_scaledBitmap = wxBitmap(mipmap.Scale(m_width, m_height, wxIMAGE_QUALITY_BILINEAR), 24);
+      m_scaledBitmapIsApproximation = true;
+      RescaleInBackground();
+      #else
+      m_scaledBitmap = wxBitmap(mipmap.Scale(m_width, m_height, wxIMAGE_QUALITY_BICUBIC), 24);
+      #endif
+    }
+  }
+  #ifdef HAVE_OMP_HEADER
+  omp_unset_lock(&m_gnuplotLock);
+  #endif
+  return m_scaledBitmap;
+}
+
+int Image::GetMipmapLevel(long width)
+{
+  if (m_mipmaps.empty())
   {
     wxImage img;
     if (m_compressedImage.GetDataLen() > 0)
     {
       wxMemoryInputStream istream(m_compressedImage.GetData(), m_compressedImage.GetDataLen());
-
       img = wxImage(istream, wxBITMAP_TYPE_ANY);
     }
-    m_isOk = true;
+    if (!img.Ok())
+      return -1;
+    m_mipmaps.push_back(img);
+  }
 
-    if (img.Ok())
-      m_scaledBitmap = wxBitmap(img);
-    else
-      InvalidBitmap();
+  size_t level = 0;
+  while ((m_mipmaps[level].GetWidth() / 2 >= width) && (m_mipmaps[level].GetHeight() >= 2))
+  {
+    if (level + 1 >= m_mipmaps.size())
+      m_mipmaps.push_back(m_mipmaps[level].ShrinkBy(2, 2));
+    level++;
   }
+  TouchMipmaps();
+  return level;
+}
 
-  // Make sure we stay within sane defaults
-  if (m_width < 1)m_width = 1;
-  if (m_height < 1)m_height = 1;
+void Image::TouchMipmaps()
+{
+  size_t bytes = 0;
+  for (auto const &mipmap : m_mipmaps)
+    bytes += static_cast<size_t>(mipmap.GetWidth()) * mipmap.GetHeight() * (mipmap.HasAlpha() ? 4 : 3);
 
-  // Create a scaled bitmap and return it.
-  if(m_scaledBitmap.IsOk())
+  if (m_mipmapBytes > 0)
+    m_mipmapUsers.splice(m_mipmapUsers.begin(), m_mipmapUsers, m_mipmapUser);
+  else
   {
-    wxImage img = m_scaledBitmap.ConvertToImage();
-    img.Rescale(m_width, m_height, wxIMAGE_QUALITY_BICUBIC);
-    m_scaledBitmap = wxBitmap(img, 24);
+    m_mipmapUsers.push_front(this);
+    m_mipmapUser = m_mipmapUsers.begin();
+  }
+  m_mipmapBytesTotal = m_mipmapBytesTotal - m_mipmapBytes + bytes;
+  m_mipmapBytes = bytes;
+
+  // Drop the mipmaps of the images that haven't been drawn for the longest time
+  while ((m_mipmapBytesTotal > mipmapMemoryBudget) && (m_mipmapUsers.back() != this))
+    m_mipmapUsers.back()->ClearMipmaps();
+}
+
+void Image::ClearMipmaps()
+{
+  if (m_mipmapBytes > 0)
+  {
+    m_mipmapUsers.erase(m_mipmapUser);
+    m_mipmapBytesTotal -= m_mipmapBytes;
+    m_mipmapBytes = 0;
+  }
+  m_mipmaps.clear();
+}
+
+bool Image::ExactImageReady()
+{
+  bool ready = false;
+  #ifdef HAVE_OPENMP_TASKS
+  #pragma omp critical (ImageRescale)
+  #endif
+  ready = (m_exactImage != nullptr) || (m_svgRaster != nullptr);
+  return ready;
+}
+
+void Image::RescaleInBackground()
+{
+  #ifdef HAVE_OPENMP_TASKS
+  bool pending = false;
+  #pragma omp critical (ImageRescale)
+  {
+    pending = m_exactImagePending;
+    m_exactImagePending = true;
+  }
+  // If the pending rescale is for an outdated size the next redraw starts a new one
+  if (pending)
+    return;
+
+  long width = m_width;
+  long height = m_height;
+  // The task tells the GUI thread to draw the image again once it is done
+  wxWindow *worksheet = (*m_configuration)->GetWorkSheet();
+  if (m_svgRast)
+  {
+    NSVGimage *svgImage = m_svgImage;
+    double scale = ((double)width)/((double)m_originalWidth);
+    #pragma omp task firstprivate(svgImage, scale, width, height, worksheet)
+    {
+      std::unique_ptr<SvgRaster> raster(new SvgRaster{width, height, {}});
+      raster->rgba.resize(width * height * 4);
+      RasterizeSvg(svgImage, scale, raster->rgba.data(), width, height);
+      #pragma omp critical (ImageRescale)
+      {
+        m_svgRaster = std::move(raster);
+        m_exactImagePending = false;
+      }
+      if (worksheet)
+        worksheet->CallAfter([worksheet]{worksheet->Refresh();});
+    }
+    return;
+  }
+
+  // wxImage's reference counting isn't thread-safe => the task gets its own copy.
+  wxImage *original = new wxImage(m_mipmaps[0].Copy());
+  #pragma omp task firstprivate(original, width, height, worksheet)
+  {
+    std::unique_ptr<wxImage> source(original);
+    std::unique_ptr<wxImage> exactImage(new wxImage(source->Scale(width, height, wxIMAGE_QUALITY_BICUBIC)));
+    #pragma omp critical (ImageRescale)
+    {
+      m_exactImage = std::move(exactImage);
+      m_exactImagePending = false;
+    }
+    if (worksheet)
+      worksheet->CallAfter([worksheet]{worksheet->Refresh();});
   }
-  else
-    m_scaledBitmap = wxBitmap(1,1);
-  #ifdef HAVE_OMP_HEADER
-  omp_unset_lock(&m_gnuplotLock);
   #endif
-  return m_scaledBitmap;
+}
+
+void Image::RasterizeSvg(NSVGimage *image, double scale, unsigned char *rgba,
+                         long width, long height)
+{
+  // Each band needs its own rasterizer, but they all share the parsed image.
+  const long bandHeight = 256;
+  for (long top = 0; top < height; top += bandHeight)
+  {
+    #ifdef HAVE_OPENMP_TASKS
+    #pragma omp task firstprivate(top)
+    #endif
+    {
+      NSVGrasterizer *rasterizer = nsvgCreateRasterizer();
+      if (rasterizer)
+      {
+        nsvgRasterize(rasterizer, image, 0, -top, scale, rgba + top * width * 4,
+                      width, std::min(bandHeight, height - top), width * 4);
+        nsvgDeleteRasterizer(rasterizer);
+      }
+    }
+  }
+  #ifdef HAVE_OPENMP_TASKS
+  #pragma omp taskwait
+  #endif
 }
 
 void Image::InvalidBitmap()
@@ -855,6 +1095,7 @@ void Image::LoadImage(const wxBitmap &bitmap)
   m_originalWidth = image.GetWidth();
   m_originalHeight = image.GetHeight();
   m_scaledBitmap.Create(1, 1);
+  ClearMipmaps();
   m_width = 1;
   m_height = 1;
 }
@@ -864,12 +1105,12 @@ wxString Image::GetExtension()
   return m_extension;
 }
 
-// filesystem cannot be passed by const reference as we want to keep the
-// pointer to the file system alive in a background task
-// cppcheck-suppress performance symbolName=filesystem
-void Image::LoadImage(wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove)
+// archive cannot be passed by const reference as we want to keep the
+// pointer to the archive alive in a background task
+// cppcheck-suppress performance symbolName=archive
+void Image::LoadImage(wxString image, std::shared_ptr<ZipIndex> archive, bool remove)
 {
-  m_fs_keepalive_imagedata = filesystem;
+  m_archive_keepalive_imagedata = archive;
   m_extension = wxFileName(image).GetExt();
   m_extension = m_extension.Lower();
   // If we don't have fine-grained locking using omp.h we don't profit from sending the
@@ -882,10 +1123,10 @@ void Image::LoadImage(wxString image, std::shared_ptr<wxFileSystem> filesystem,
   #pragma omp task
   #endif
   #endif
-  LoadImage_Backgroundtask(image, filesystem, remove);
+  LoadImage_Backgroundtask(image, archive, remove);
 }
 
-void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove)
+void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<ZipIndex> archive, bool remove)
 {
   #ifdef HAVE_OMP_HEADER
   WaitForLoad waitforload(&m_imageLoadLock);
@@ -895,25 +1136,8 @@ void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSyste
   m_compressedImage.Clear();
   m_scaledBitmap.Create(1, 1);
 
-  if (filesystem)
-  {
-    wxFSFile * fsfile;
-    #ifdef HAVE_OPENMP_TASKS
-    #pragma omp critical (OpenFSFile)
-    #endif
-    fsfile = filesystem->OpenFile(image);
-    if (fsfile)
-    { // open successful
-
-      wxInputStream *istream = fsfile->GetStream();
-
-      m_compressedImage = ReadCompressedImage(istream);
-    }
-
-    // Closing and deleting fsfile is important: If this line is missing
-    // opening .wxmx files containing hundreds of images might lead to a
-    // "too many open files" error.
-  }
+  if (archive)
+    m_compressedImage = archive->Read(image);
   else
   {
     wxFile file;
@@ -1009,6 +1233,12 @@ void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSyste
         m_originalHeight = m_svgImage->height;
       }
     }
+    else if (ReadImageSize(m_compressedImage, m_originalWidth, m_originalHeight))
+    {
+      // Decoding the image can wait until GetBitmap() is called for the
+      // first time, which only happens if the image is ever drawn.
+      m_isOk = true;
+    }
     else
     {   
       wxMemoryInputStream istream(m_compressedImage.GetData(), m_compressedImage.GetDataLen());
@@ -1028,7 +1258,7 @@ void Image::LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSyste
       }
     }
   }
-  m_fs_keepalive_imagedata.reset();
+  m_archive_keepalive_imagedata.reset();
   #ifdef HAVE_OMP_HEADER
   omp_unset_lock(&m_imageLoadLock);
   #endif
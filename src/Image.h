@@ -34,9 +34,11 @@
 #include "Version.h"
 #include <wx/image.h>
 
-#include <wx/filesys.h>
-#include <wx/fs_arc.h>
 #include <wx/buffer.h>
+#include <list>
+#include <memory>
+#include <vector>
+#include "ZipIndex.h"
 #include "nanoSVG/nanosvg.h"
 #include "nanoSVG/nanosvgrast.h"
 
@@ -66,6 +68,18 @@
       to store them in their uncompressed form.
     - One could even delete the cached scaled images for all cells that currently 
       are off-screen in order to save memory.
+
+  Bitmap images are decoded only once into a chain of mipmaps, each level half the
+  size of the previous one. A new zoom factor is served from the smallest level that
+  is at least as big as the scaled image. If that still needs rescaling, we first
+  show a fast bilinear rescale and let a background task make the exact bicubic one
+  that replaces it the next time the image is drawn. All images together keep at most
+  mipmapMemoryBudget bytes of mipmaps; the ones that haven't been drawn for the
+  longest time are dropped first.
+
+  SVG images are rasterized by a background task at the exact size, in horizontal
+  bands that are rendered in parallel. Until the raster is ready the previous one,
+  scaled to the new size, is shown instead.
  */
 class Image final
 {
@@ -87,10 +101,10 @@ public:
 
     \param config The pointer to the current configuration storage for the worksheet
     \param image The name of the file
-    \param filesystem The filesystem to load it from
+    \param archive The .wxmx file to load it from. NULL = the operating system's filesystem
     \param remove true = Delete the file after loading it
    */
-  Image(Configuration **config, wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove = true);
+  Image(Configuration **config, wxString image, std::shared_ptr<ZipIndex> archive, bool remove = true);
 
   ~Image();
 
@@ -103,7 +117,7 @@ public:
     are text-only they profit from being compressed and are stored in the 
     memory in their compressed form.
    */
-  void GnuplotSource(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem);
+  void GnuplotSource(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<ZipIndex> archive);
 
   //! Load the gnuplot source file from the system's filesystem
   void GnuplotSource(wxString gnuplotFilename, wxString dataFilename)
@@ -169,6 +183,9 @@ public:
 
   //! Does the image show an actual image or an "broken image" symbol?
   bool IsOk();
+
+  //! Is the bitmap GetBitmap() returned last only an approximation that waits for an exact rescale?
+  bool ShowsApproximation() const { return m_scaledBitmapIsApproximation; }
   
   //! Returns the image in its unscaled form
   wxBitmap GetUnscaledBitmap();
@@ -218,6 +235,13 @@ public:
   //! The tooltip to use wherever an image that's not Ok is shown.
   static const wxString &GetBadImageToolTip();
 
+  /*! Rasterizes an svg image into rgba, which must hold width * height * 4 bytes
+
+    The image is split into horizontal bands that are rasterized in parallel.
+   */
+  static void RasterizeSvg(NSVGimage *image, double scale, unsigned char *rgba,
+                           long width, long height);
+
 private:
   //! A zipped version of the gnuplot commands that produced this image.
   wxMemoryBuffer m_gnuplotSource_Compressed;
@@ -229,6 +253,50 @@ private:
   size_t m_originalHeight;
   //! The bitmap, scaled down to the screen size
   wxBitmap m_scaledBitmap;
+  //! Is m_scaledBitmap only the fast approximation that waits for an exact rescale?
+  bool m_scaledBitmapIsApproximation = false;
+  /*! The decoded image, halved in size again and again. Level 0 has the original size.
+
+    Only touched by the GUI thread.
+   */
+  std::vector<wxImage> m_mipmaps;
+  //! The number of bytes m_mipmaps occupies
+  size_t m_mipmapBytes = 0;
+  //! Our entry in m_mipmapUsers. Valid only if m_mipmaps isn't empty.
+  std::list<Image *>::iterator m_mipmapUser;
+  //! The images that have mipmaps, the one drawn most recently first
+  static std::list<Image *> m_mipmapUsers;
+  //! The number of bytes the mipmaps of all images occupy
+  static size_t m_mipmapBytesTotal;
+  //! How many bytes of mipmaps we keep before we start dropping the least recently used ones
+  static constexpr size_t mipmapMemoryBudget = 256 * 1024 * 1024;
+  //! The exact rescale a background task has made for us, or nullptr
+  std::unique_ptr<wxImage> m_exactImage;
+  //! The RGBA data of an svg image rasterized at a given size
+  struct SvgRaster
+  {
+    long width;
+    long height;
+    std::vector<unsigned char> rgba;
+  };
+  //! The raster of our svg image a background task has made for us, or nullptr
+  std::unique_ptr<SvgRaster> m_svgRaster;
+  //! Is a background task making an exact rescale or svg raster right now?
+  bool m_exactImagePending = false;
+  /*! Returns the index of the smallest mipmap that is at least width pixels wide
+
+    Decodes the image and creates the mipmap levels as needed. Returns -1 if the
+    image cannot be decoded.
+   */
+  int GetMipmapLevel(long width);
+  //! Records that our mipmaps have been used and drops other images' ones if we are over budget
+  void TouchMipmaps();
+  //! Forgets the mipmaps
+  void ClearMipmaps();
+  //! Has a background task finished an exact rescale or svg raster for us?
+  bool ExactImageReady();
+  //! Starts a background task that rescales or rasterizes the original image to the current size
+  void RescaleInBackground();
   //! The file extension for the current image type
   wxString m_extension;
   //! Does this image contain an actual image?
@@ -237,13 +305,18 @@ private:
   wxString m_gnuplotSource;
   //! The gnuplot data file for this image, if any.
   wxString m_gnuplotData;
-  void LoadImage_Backgroundtask(wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove);
-  void LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem);
+  void LoadImage_Backgroundtask(wxString image, std::shared_ptr<ZipIndex> archive, bool remove);
+  void LoadGnuplotSource_Backgroundtask(wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<ZipIndex> archive);
 
   //! Loads an image from a file
-  void LoadImage(wxString image, std::shared_ptr<wxFileSystem> filesystem, bool remove = true);
+  void LoadImage(wxString image, std::shared_ptr<ZipIndex> archive, bool remove = true);
   //! Reads the compressed image into a memory buffer
   static wxMemoryBuffer ReadCompressedImage(wxInputStream *data);
+  /*! Reads the size of a .png, .gif or .jpeg image from its header
+
+    Much faster than decoding the whole image. Returns false for all other formats.
+   */
+  static bool ReadImageSize(const wxMemoryBuffer &image, size_t &width, size_t &height);
   Configuration **m_configuration;
   //! The upper width limit for displaying this image
   double m_maxWidth;
@@ -255,8 +328,8 @@ private:
   NSVGimage* m_svgImage = {};
   std::unique_ptr<struct NSVGrasterizer, decltype(std::free)*> m_svgRast{nullptr, std::free};
 
-  std::shared_ptr<wxFileSystem> m_fs_keepalive_gnuplotdata;
-  std::shared_ptr<wxFileSystem> m_fs_keepalive_imagedata;
+  std::shared_ptr<ZipIndex> m_archive_keepalive_gnuplotdata;
+  std::shared_ptr<ZipIndex> m_archive_keepalive_imagedata;
   #ifdef HAVE_OMP_HEADER
   omp_lock_t m_gnuplotLock;
   omp_lock_t m_imageLoadLock;
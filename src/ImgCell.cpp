@@ -70,13 +70,13 @@ ImgCell::ImgCell(GroupCell *parent, Configuration **config, const wxBitmap &bitm
 int ImgCell::s_counter = 0;
 
 // constructor which load image
-ImgCell::ImgCell(GroupCell *parent, Configuration **config, const wxString &image, std::shared_ptr<wxFileSystem> filesystem, bool remove)
+ImgCell::ImgCell(GroupCell *parent, Configuration **config, const wxString &image, std::shared_ptr<ZipIndex> archive, bool remove)
   : Cell(parent, config)
 {
   InitBitFields();
   m_type = MC_TYPE_IMAGE;
   if (image != wxEmptyString)
-    m_image = std::make_shared<Image>(m_configuration, image, filesystem, remove);
+    m_image = std::make_shared<Image>(m_configuration, image, archive, remove);
   else
     m_image = std::make_shared<Image>(m_configuration);
   m_drawBoundingBox = false;
@@ -300,10 +300,8 @@ wxString ImgCell::ToXML() const
   if (m_image)
   {
     if (m_image->GetCompressedImage())
-      wxMemoryFSHandler::AddFile(basename + m_image->GetExtension(),
-                                 m_image->GetCompressedImage().GetData(),
-                                 m_image->GetCompressedImage().GetDataLen()
-      );
+      m_cellPointers->WXMXAddFile(basename + m_image->GetExtension(),
+                                  m_image->GetCompressedImage());
   }
 
   wxString flags;
@@ -342,10 +340,7 @@ wxString ImgCell::ToXML() const
       wxMemoryBuffer data = m_image->GetGnuplotSource();
       if(data.GetDataLen() > 0)
       {
-        wxMemoryFSHandler::AddFile(gnuplotSource,
-                                   data.GetData(),
-                                   data.GetDataLen()
-          );
+        m_cellPointers->WXMXAddFile(gnuplotSource, data);
       }
     }
     if(gnuplotData != wxEmptyString)
@@ -354,10 +349,7 @@ wxString ImgCell::ToXML() const
       wxMemoryBuffer data = m_image->GetGnuplotData();
       if(data.GetDataLen() > 0)
       {
-        wxMemoryFSHandler::AddFile(gnuplotData,
-                                   data.GetData(),
-                                   data.GetDataLen()
-          );
+        m_cellPointers->WXMXAddFile(gnuplotData, data);
       }
     }
   }
@@ -208,8 +208,9 @@ void LabelCell::Recalculate(AFontSize fontsize)
     if (index != noText)
     {
       Style style = configuration->GetStyle(m_textStyle, configuration->GetDefaultFontSize());
+      style.SetFontSize(Scale_Px(m_fontSize_scaledToFit));
       
-      wxSize labelSize = GetTextSize(configuration->GetDC(), m_displayedText, index);
+      wxSize labelSize = GetTextSize(configuration->GetDC(), style, m_displayedText, index);
       wxASSERT_MSG((labelSize.GetWidth() > 0) || (m_displayedText.IsEmpty()),
                    _("Seems like something is broken with the maths font."));
 
@@ -224,7 +225,7 @@ void LabelCell::Recalculate(AFontSize fontsize)
 #endif
         style.SetFontSize(Scale_Px(m_fontSize_scaledToFit));
         dc->SetFont(style.GetFont());
-        labelSize = GetTextSize((*m_configuration)->GetDC(), m_displayedText, index);
+        labelSize = GetTextSize((*m_configuration)->GetDC(), style, m_displayedText, index);
       }
       m_height = labelSize.GetHeight();
       m_width = labelSize.GetWidth() + Scale_Px(2);
@@ -20,6 +20,10 @@
 //  SPDX-License-Identifier: GPL-2.0+
 
 #include "LogPane.h"
+#include "RenderTimings.h"
+#include <wx/button.h>
+#include <wx/filedlg.h>
+
 LogPane::LogPane(wxWindow *parent, wxWindowID id, bool becomeLogTarget) : wxPanel(parent, id)
 {
   wxBoxSizer *vbox  = new wxBoxSizer(wxVERTICAL);
@@ -31,6 +35,23 @@ LogPane::LogPane(wxWindow *parent, wxWindowID id, bool becomeLogTarget) : wxPane
   m_textCtrl->SetMinSize(wxSize(wxSystemSettings::GetMetric( wxSYS_SCREEN_X )/10,
                                 wxSystemSettings::GetMetric( wxSYS_SCREEN_Y )/10));
   vbox->Add(m_textCtrl, wxSizerFlags().Expand().Proportion(1));
+
+  wxBoxSizer *timingsBox = new wxBoxSizer(wxHORIZONTAL);
+  m_measureTimings = new wxCheckBox(this, -1, _("Measure render timings"));
+  m_measureTimings->SetValue(RenderTimings::Enabled());
+  m_measureTimings->SetToolTip(_("Measure how long drawing, laying out and parsing the output takes in order to find out what makes a worksheet slow."));
+  timingsBox->Add(m_measureTimings, wxSizerFlags().Center());
+  wxButton *saveTimings = new wxButton(this, -1, _("Save trace..."));
+  saveTimings->SetToolTip(_("Save the timings in a format chrome://tracing can display"));
+  timingsBox->Add(saveTimings, wxSizerFlags().Border(wxLEFT, 5));
+  vbox->Add(timingsBox, wxSizerFlags().Border(wxALL, 5));
+  m_timings = new wxStaticText(this, -1, wxEmptyString);
+  vbox->Add(m_timings, wxSizerFlags().Expand().Border(wxLEFT | wxRIGHT | wxBOTTOM, 5));
+
+  m_timingsTimer.SetOwner(this);
+  Connect(wxEVT_TIMER, wxTimerEventHandler(LogPane::OnTimer), NULL, this);
+  m_measureTimings->Connect(wxEVT_CHECKBOX, wxCommandEventHandler(LogPane::OnMeasureTimings), NULL, this);
+  saveTimings->Connect(wxEVT_BUTTON, wxCommandEventHandler(LogPane::OnSaveTimings), NULL, this);
     
   if (becomeLogTarget)
     BecomeLogTarget();    
@@ -61,8 +82,45 @@ void LogPane::BecomeLogTarget()
   #endif
 }
 
+void LogPane::OnMeasureTimings(wxCommandEvent &WXUNUSED(event))
+{
+  bool measure = m_measureTimings->GetValue();
+  RenderTimings::Enable(measure);
+  if (measure)
+  {
+    RenderTimings::Get().Clear();
+    m_timingsTimer.Start(1000);
+  }
+  else
+    m_timingsTimer.Stop();
+}
+
+void LogPane::OnSaveTimings(wxCommandEvent &WXUNUSED(event))
+{
+  wxFileDialog fileDialog(this,
+                          _("Save trace"), wxEmptyString,
+                          wxT("wxmaxima-trace.json"),
+                          _("Chrome trace (*.json)|*.json"),
+                          wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+  if (fileDialog.ShowModal() != wxID_OK)
+    return;
+  if (!RenderTimings::Get().WriteChromeTrace(fileDialog.GetPath()))
+    wxLogError(_("Cannot write the render timings to %s"), fileDialog.GetPath());
+}
+
+void LogPane::OnTimer(wxTimerEvent &WXUNUSED(event))
+{
+  wxString summary = RenderTimings::Get().GetSummary();
+  if (summary != m_timings->GetLabel())
+  {
+    m_timings->SetLabel(summary);
+    Layout();
+  }
+}
+
 LogPane::~LogPane()
 {
+  m_timingsTimer.Stop();
   DropLogTarget();
 }
 
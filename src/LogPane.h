@@ -26,6 +26,9 @@
 #include <wx/wx.h>
 #include <wx/panel.h>
 #include <wx/textctrl.h>
+#include <wx/checkbox.h>
+#include <wx/stattext.h>
+#include <wx/timer.h>
 #include "ErrorRedirector.h"
 #include "stx/optional.hpp"
 
@@ -43,8 +46,20 @@ public:
   ~LogPane();
 
 private:
+  //! Called if the user switches measuring the render timings on or off
+  void OnMeasureTimings(wxCommandEvent &event);
+  //! Called if the user wants to save the render timings
+  void OnSaveTimings(wxCommandEvent &event);
+  //! Updates the render timings summary
+  void OnTimer(wxTimerEvent &event);
   //! The textctrl all log messages appear on
   wxTextCtrl *m_textCtrl;
+  //! Switches measuring the render timings on or off
+  wxCheckBox *m_measureTimings;
+  //! Shows how long drawing, layout and parsing have taken recently
+  wxStaticText *m_timings;
+  //! Updates m_timings while the timings are being measured
+  wxTimer m_timingsTimer;
   //! Shows all error messages on gui dialogues
   stx::optional<wxLogTextCtrl> m_logPanelTarget;
   //! Redirects error messages - here to a wxLog
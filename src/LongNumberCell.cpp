@@ -29,6 +29,9 @@
 
 #include "LongNumberCell.h"
 #include "StringUtils.h"
+#include <algorithm>
+
+constexpr char LongNumberCell::unicodeMinus;
 
 LongNumberCell::LongNumberCell(GroupCell *parent,
                                Configuration **config,
@@ -36,14 +39,17 @@ LongNumberCell::LongNumberCell(GroupCell *parent,
   : TextCell(parent, config, number, TS_NUMBER)
 {
   InitBitFields();
+  PackDigits();
 }
 
 // cppcheck-suppress uninitMemberVar symbolName=LongNumberCell::m_alt
 // cppcheck-suppress uninitMemberVar symbolName=LongNumberCell::m_altJs
 // cppcheck-suppress uninitMemberVar symbolName=LongNumberCell::m_initialToolTip
 LongNumberCell::LongNumberCell(const LongNumberCell &cell):
-    TextCell(cell.m_group, cell.m_configuration)
+    TextCell(cell),
+    m_digits(cell.m_digits)
 {
+  InitBitFields();
 }
 
 std::unique_ptr<Cell> LongNumberCell::Copy() const
@@ -51,22 +57,98 @@ std::unique_ptr<Cell> LongNumberCell::Copy() const
   return std::make_unique<LongNumberCell>(*this);
 }
 
+void LongNumberCell::PackDigits()
+{
+  std::string digits;
+  digits.reserve(m_text.Length());
+  for (wxUniChar ch : m_text)
+  {
+    if (ch == wxT('\u2212'))
+      digits += unicodeMinus;
+    else if (ch.IsAscii())
+      digits += static_cast<char>(ch.GetValue());
+    else
+    {
+      m_digits.reset();
+      return;
+    }
+  }
+  m_digits = std::make_shared<const std::string>(std::move(digits));
+  // clear() would keep the memory allocated
+  wxString().swap(m_text);
+  wxString().swap(m_displayedText);
+  m_displayedDigits_old = -1;
+}
+
+wxString LongNumberCell::GetDigits(size_t start, size_t length) const
+{
+  wxString digits;
+  if (!m_digits || (start >= m_digits->size()))
+    return digits;
+  length = std::min(length, m_digits->size() - start);
+  digits.reserve(length);
+  for (size_t i = start; i < start + length; i++)
+  {
+    char ch = (*m_digits)[i];
+    digits += (ch == unicodeMinus) ? wxUniChar(0x2212) : wxUniChar(ch);
+  }
+  return digits;
+}
+
+void LongNumberCell::SetValue(const wxString &text)
+{
+  m_digits.reset();
+  TextCell::SetValue(text);
+  PackDigits();
+}
+
+wxString LongNumberCell::GetValue() const
+{
+  if (!m_digits)
+    return m_text;
+  return GetDigits();
+}
+
+wxString LongNumberCell::GetDisplayedText()
+{
+  if (m_displayedDigits_old != (*m_configuration)->GetDisplayedDigits())
+    UpdateDisplayedText();
+  if (m_numStart.empty())
+    return m_displayedText;
+  return m_numStart + m_ellipsis + m_numEnd;
+}
+
 void LongNumberCell::UpdateDisplayedText()
 {
+  if (!m_digits)
+    TextCell::UpdateDisplayedText();
   unsigned int displayedDigits = (*m_configuration)->GetDisplayedDigits();
-  if (m_displayedText.Length() > displayedDigits)
+  size_t length = m_digits ? m_digits->size() : m_displayedText.Length();
+  if (length > displayedDigits)
   {
     int left = displayedDigits / 3;
-    if (left > 30) left = 30;      
-    m_numStart = m_displayedText.Left(left);
-    m_ellipsis = wxString::Format(_("[%i digits]"), (int) m_displayedText.Length() - 2 * left);
-    m_numEnd = m_displayedText.Right(left);
+    if (left > 30) left = 30;
+    if (m_digits)
+    {
+      m_numStart = GetDigits(0, left);
+      m_numEnd = GetDigits(length - left, left);
+      wxString().swap(m_displayedText);
+    }
+    else
+    {
+      m_numStart = m_displayedText.Left(left);
+      m_numEnd = m_displayedText.Right(left);
+    }
+    m_ellipsis = wxString::Format(_("[%i digits]"), (int) length - 2 * left);
   }
   else
   {
     m_numStart.clear();
     m_ellipsis.clear();
     m_numEnd.clear();
+    // We show all digits => TextCell needs them.
+    if (m_digits)
+      m_displayedText = GetDigits();
   }
   m_sizeCache.clear();
   m_displayedDigits_old = (*m_configuration)->GetDisplayedDigits();
@@ -98,12 +180,12 @@ void LongNumberCell::Recalculate(AFontSize fontsize)
     if(m_numStart != wxEmptyString)
     {
       m_fontSize = fontsize;
-      SetFont(fontsize);
+      auto const style = SetFont(fontsize);
       Configuration *configuration = (*m_configuration);
       wxDC *dc = configuration->GetDC();
-      auto numStartSize = GetTextSize(dc, m_numStart, numberStart);
-      auto ellipsisSize = GetTextSize(dc, m_ellipsis, ellipsis);
-      auto numEndSize   = GetTextSize(dc, m_numEnd,   numberEnd);
+      auto numStartSize = GetTextSize(dc, style, m_numStart, numberStart);
+      auto ellipsisSize = GetTextSize(dc, style, m_ellipsis, ellipsis);
+      auto numEndSize   = GetTextSize(dc, style, m_numEnd,   numberEnd);
       m_numStartWidth = numStartSize.GetWidth();
       m_ellipsisWidth = ellipsisSize.GetWidth();
       m_width = m_numStartWidth + m_ellipsisWidth + numEndSize.GetWidth();
@@ -152,3 +234,68 @@ void LongNumberCell::Draw(wxPoint point)
   }
 }
 
+
+wxString LongNumberCell::ToString() const
+{
+  if (!m_digits || !GetAltCopyText().empty())
+    return TextCell::ToString();
+
+  // Like TextCell::ToString() we replace the unicode minus signs by ASCII ones
+  std::string digits(*m_digits);
+  std::replace(digits.begin(), digits.end(), unicodeMinus, '-');
+  wxString text = wxString::FromAscii(digits.data(), digits.size());
+  if ((m_next != NULL) && (m_next->BreakLineHere()))
+    text += "\n";
+  return text;
+}
+
+wxString LongNumberCell::ToMathML() const
+{
+  if (!m_digits)
+    return TextCell::ToMathML();
+  return wxT("<mn>") + XMLescape(ToString()) + wxT("</mn>\n");
+}
+
+wxString LongNumberCell::ToOMML() const
+{
+  if (!m_digits)
+    return TextCell::ToOMML();
+  //Text-only lines are better handled in RTF.
+  if (
+          (m_previous && (m_previous->GetStyle() != TS_LABEL) && (!m_previous->HardLineBreak())) &&
+          (HardLineBreak())
+          )
+    return wxEmptyString;
+  return wxT("<m:r>") + XMLescape(GetDigits()) + wxT("</m:r>\n");
+}
+
+wxString LongNumberCell::ToRTF() const
+{
+  if (!m_digits)
+    return TextCell::ToRTF();
+  // TextCell exports only labels to RTF
+  return wxEmptyString;
+}
+
+wxString LongNumberCell::ToXML() const
+{
+  if (!m_digits)
+    return TextCell::ToXML();
+  wxString tag = (m_isHidden || m_isHidableMultSign) ? wxT("h") : wxT("n");
+  return wxT("<") + tag + GetXMLFlags() + wxT(">") + XMLescape(GetDigits()) +
+    wxT("</") + tag + wxT(">");
+}
+
+wxString LongNumberCell::GetDiffPart() const
+{
+  if (!m_digits)
+    return TextCell::GetDiffPart();
+  return wxT(",") + GetDigits() + wxT(",1");
+}
+
+bool LongNumberCell::IsShortNum() const
+{
+  if (!m_digits)
+    return TextCell::IsShortNum();
+  return (m_next == NULL) && (m_digits->size() < 4);
+}
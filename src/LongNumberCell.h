@@ -24,10 +24,17 @@
 #define LONGNUMBERCELL_H
 
 #include "TextCell.h"
+#include <memory>
+#include <string>
 
 /*! A cell containing a long number
 
   A specialised TextCell, that can display a long number, or shorten it using an ellipsis.
+
+  A wxString needs 4 bytes per digit on many platforms, and TextCell keeps two of them.
+  This cell therefore keeps the number in a one-byte-per-char buffer that all copies
+  of the cell share, and creates the few digits it actually displays, and the full
+  text for exports, only when they are needed.
  */
 class LongNumberCell final : public TextCell
 {
@@ -41,11 +48,44 @@ public:
   void Draw(wxPoint point) override;
   bool NeedsRecalculation(AFontSize fontSize) const override;
   void SetStyle(TextStyle style) override;
+  void SetValue(const wxString &text) override;
+  wxString GetValue() const override;
+  /*! The text this cell displays
+
+    If the number has more digits than the configuration allows to display these
+    are the first and the last few digits with a "[n digits]" message between them.
+   */
+  wxString GetDisplayedText();
+
+  wxString ToMathML() const override;
+  wxString ToOMML() const override;
+  wxString ToRTF() const override;
+  wxString ToString() const override;
+  wxString ToXML() const override;
+  wxString GetDiffPart() const override;
+  bool IsShortNum() const override;
 
 protected:
   virtual void UpdateDisplayedText() override;
 
 private:
+  /*! Moves the number from m_text to m_digits
+
+    Leaves the number in m_text if it contains chars other than ASCII and unicode
+    minus signs.
+   */
+  void PackDigits();
+  //! Returns length chars of the number, starting at start
+  wxString GetDigits(size_t start = 0, size_t length = wxString::npos) const;
+
+  //! The byte that stands for a unicode minus sign in m_digits. Isn't ASCII.
+  static constexpr char unicodeMinus = '\x80';
+  /*! The number, one byte per char, with the unicode minus signs replaced by unicodeMinus
+
+    Never modified, only replaced => The copies of this cell can share it.
+    nullptr if the number is kept in m_text instead.
+   */
+  std::shared_ptr<const std::string> m_digits;
 
   int m_numStartWidth = 0;
   int m_ellipsisWidth = 0;
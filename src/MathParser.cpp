@@ -53,6 +53,7 @@
 #include "StringUtils.h"
 #include "VisiblyInvalidCell.h"
 #include "SlideShowCell.h"
+#include "RenderTimings.h"
 
 /*! Calls a member function from a function pointer
 
@@ -84,7 +85,8 @@ wxXmlNode *MathParser::GetNextTag(wxXmlNode *node)
   return SkipWhitespaceNode(node);
 }
 
-MathParser::MathParser(Configuration **cfg, const wxString &zipfile)
+MathParser::MathParser(Configuration **cfg, std::shared_ptr<ZipIndex> archive) :
+  m_archive(std::move(archive))
 {
   // We cannot do this at the startup of the program as we first need to wait
   // for the language selection to take place
@@ -95,71 +97,109 @@ MathParser::MathParser(Configuration **cfg, const wxString &zipfile)
   m_FracStyle = FracCell::FC_NORMAL;
   if(m_innerTags.empty())
   {
-    m_innerTags[wxT("v")] = &MathParser::ParseVariableNameTag;
-    m_innerTags[wxT("mi")] = &MathParser::ParseVariableNameTag;
-    m_innerTags[wxT("mo")] = &MathParser::ParseOperatorNameTag;
-    m_innerTags[wxT("t")] = &MathParser::ParseMiscTextTag;
-    m_innerTags[wxT("n")] = &MathParser::ParseNumberTag;
-    m_innerTags[wxT("mn")] = &MathParser::ParseNumberTag;
-    m_innerTags[wxT("p")] = &MathParser::ParseParenTag;
-    m_innerTags[wxT("f")] = &MathParser::ParseFracTag;
-    m_innerTags[wxT("mfrac")] = &MathParser::ParseFracTag;
-    m_innerTags[wxT("e")] = &MathParser::ParseSupTag;
-    m_innerTags[wxT("msup")] = &MathParser::ParseSupTag;
-    m_innerTags[wxT("i")] = &MathParser::ParseSubTag;
-    m_innerTags[wxT("munder")] = &MathParser::ParseSubTag;
-    m_innerTags[wxT("fn")] = &MathParser::ParseFunTag;
-    m_innerTags[wxT("g")] = &MathParser::ParseGreekTag;
-    m_innerTags[wxT("s")] = &MathParser::ParseSpecialConstantTag;
-    m_innerTags[wxT("fnm")] = &MathParser::ParseFunctionNameTag;
-    m_innerTags[wxT("q")] = &MathParser::ParseSqrtTag;
-    m_innerTags[wxT("d")] = &MathParser::ParseDiffTag;
-    m_innerTags[wxT("sm")] = &MathParser::ParseSumTag;
-    m_innerTags[wxT("in")] = &MathParser::ParseIntTag;
-    m_innerTags[wxT("mspace")] = &MathParser::ParseSpaceTag;
-    m_innerTags[wxT("at")] = &MathParser::ParseAtTag;
-    m_innerTags[wxT("a")] = &MathParser::ParseAbsTag;
-    m_innerTags[wxT("cj")] = &MathParser::ParseConjugateTag;
-    m_innerTags[wxT("ie")] = &MathParser::ParseSubSupTag;
-    m_innerTags[wxT("mmultiscripts")] = &MathParser::ParseMmultiscriptsTag;
-    m_innerTags[wxT("lm")] = &MathParser::ParseLimitTag;
-    m_innerTags[wxT("r")] = &MathParser::ParseRowTag;
-    m_innerTags[wxT("mrow")] = &MathParser::ParseRowTag;
-    m_innerTags[wxT("tb")] = &MathParser::ParseTableTag;
-    m_innerTags[wxT("mth")] = &MathParser::ParseMthTag;
-    m_innerTags[wxT("line")] = &MathParser::ParseMthTag;
-    m_innerTags[wxT("lbl")] = &MathParser::ParseOutputLabelTag;
-    m_innerTags[wxT("st")] = &MathParser::ParseStringTag;
-    m_innerTags[wxT("hl")] = &MathParser::ParseHighlightTag;
-    m_innerTags[wxT("h")] = &MathParser::ParseHiddenOperatorTag;
-    m_innerTags[wxT("img")] = &MathParser::ParseImageTag;
-    m_innerTags[wxT("slide")] = &MathParser::ParseSlideshowTag;
-    m_innerTags[wxT("editor")] = &MathParser::ParseEditorTag;
-    m_innerTags[wxT("cell")] = &MathParser::ParseCellTag;
-    m_innerTags[wxT("ascii")] = &MathParser::ParseCharCode;
-    m_innerTags[wxT("output")] = &MathParser::ParseOutputTag;
-    m_innerTags[wxT("mtd")] = &MathParser::ParseMtdTag;
-    m_innerTags[wxT("math")] = &MathParser::ParseMthTag;
+    m_innerTags[MathTag::v] = &MathParser::ParseVariableNameTag;
+    m_innerTags[MathTag::mi] = &MathParser::ParseVariableNameTag;
+    m_innerTags[MathTag::mo] = &MathParser::ParseOperatorNameTag;
+    m_innerTags[MathTag::t] = &MathParser::ParseMiscTextTag;
+    m_innerTags[MathTag::n] = &MathParser::ParseNumberTag;
+    m_innerTags[MathTag::mn] = &MathParser::ParseNumberTag;
+    m_innerTags[MathTag::p] = &MathParser::ParseParenTag;
+    m_innerTags[MathTag::f] = &MathParser::ParseFracTag;
+    m_innerTags[MathTag::mfrac] = &MathParser::ParseFracTag;
+    m_innerTags[MathTag::e] = &MathParser::ParseSupTag;
+    m_innerTags[MathTag::msup] = &MathParser::ParseSupTag;
+    m_innerTags[MathTag::i] = &MathParser::ParseSubTag;
+    m_innerTags[MathTag::munder] = &MathParser::ParseSubTag;
+    m_innerTags[MathTag::fn] = &MathParser::ParseFunTag;
+    m_innerTags[MathTag::g] = &MathParser::ParseGreekTag;
+    m_innerTags[MathTag::s] = &MathParser::ParseSpecialConstantTag;
+    m_innerTags[MathTag::fnm] = &MathParser::ParseFunctionNameTag;
+    m_innerTags[MathTag::q] = &MathParser::ParseSqrtTag;
+    m_innerTags[MathTag::d] = &MathParser::ParseDiffTag;
+    m_innerTags[MathTag::sm] = &MathParser::ParseSumTag;
+    m_innerTags[MathTag::in] = &MathParser::ParseIntTag;
+    m_innerTags[MathTag::mspace] = &MathParser::ParseSpaceTag;
+    m_innerTags[MathTag::at] = &MathParser::ParseAtTag;
+    m_innerTags[MathTag::a] = &MathParser::ParseAbsTag;
+    m_innerTags[MathTag::cj] = &MathParser::ParseConjugateTag;
+    m_innerTags[MathTag::ie] = &MathParser::ParseSubSupTag;
+    m_innerTags[MathTag::mmultiscripts] = &MathParser::ParseMmultiscriptsTag;
+    m_innerTags[MathTag::lm] = &MathParser::ParseLimitTag;
+    m_innerTags[MathTag::r] = &MathParser::ParseRowTag;
+    m_innerTags[MathTag::mrow] = &MathParser::ParseRowTag;
+    m_innerTags[MathTag::tb] = &MathParser::ParseTableTag;
+    m_innerTags[MathTag::mth] = &MathParser::ParseMthTag;
+    m_innerTags[MathTag::line] = &MathParser::ParseMthTag;
+    m_innerTags[MathTag::lbl] = &MathParser::ParseOutputLabelTag;
+    m_innerTags[MathTag::st] = &MathParser::ParseStringTag;
+    m_innerTags[MathTag::hl] = &MathParser::ParseHighlightTag;
+    m_innerTags[MathTag::h] = &MathParser::ParseHiddenOperatorTag;
+    m_innerTags[MathTag::img] = &MathParser::ParseImageTag;
+    m_innerTags[MathTag::slide] = &MathParser::ParseSlideshowTag;
+    m_innerTags[MathTag::editor] = &MathParser::ParseEditorTag;
+    m_innerTags[MathTag::cell] = &MathParser::ParseCellTag;
+    m_innerTags[MathTag::ascii] = &MathParser::ParseCharCode;
+    m_innerTags[MathTag::output] = &MathParser::ParseOutputTag;
+    m_innerTags[MathTag::mtd] = &MathParser::ParseMtdTag;
+    m_innerTags[MathTag::math] = &MathParser::ParseMthTag;
   }
-  if(m_groupTags.empty())
+  if(m_streamTags.empty())
   {
-    m_groupTags[wxT("code")] = &MathParser::GroupCellFromCodeTag;
-    m_groupTags[wxT("image")] = &MathParser::GroupCellFromImageTag;
-    m_groupTags[wxT("pagebreak")] = &MathParser::GroupCellFromPagebreakTag;
-    m_groupTags[wxT("text")] = &MathParser::GroupCellFromTextTag;
-    m_groupTags[wxT("title")] = &MathParser::GroupCellFromTitleTag;
-    m_groupTags[wxT("section")] = &MathParser::GroupCellFromSectionTag;
-    m_groupTags[wxT("subsection")] = &MathParser::GroupCellFromSubsectionTag;
-    m_groupTags[wxT("subsubsection")] = &MathParser::GroupCellFromSubsubsectionTag;
-    m_groupTags[wxT("heading5")] = &MathParser::GroupCellHeading5Tag;
-    m_groupTags[wxT("heading6")] = &MathParser::GroupCellHeading6Tag;
+    m_streamTags[MathTag::v] = &MathParser::StreamVariableNameTag;
+    m_streamTags[MathTag::mi] = &MathParser::StreamVariableNameTag;
+    m_streamTags[MathTag::mo] = &MathParser::StreamOperatorNameTag;
+    m_streamTags[MathTag::t] = &MathParser::StreamMiscTextTag;
+    m_streamTags[MathTag::n] = &MathParser::StreamNumberTag;
+    m_streamTags[MathTag::mn] = &MathParser::StreamNumberTag;
+    m_streamTags[MathTag::p] = &MathParser::StreamParenTag;
+    m_streamTags[MathTag::f] = &MathParser::StreamFracTag;
+    m_streamTags[MathTag::mfrac] = &MathParser::StreamFracTag;
+    m_streamTags[MathTag::e] = &MathParser::StreamSupTag;
+    m_streamTags[MathTag::msup] = &MathParser::StreamSupTag;
+    m_streamTags[MathTag::i] = &MathParser::StreamSubTag;
+    m_streamTags[MathTag::munder] = &MathParser::StreamSubTag;
+    m_streamTags[MathTag::fn] = &MathParser::StreamFunTag;
+    m_streamTags[MathTag::g] = &MathParser::StreamGreekTag;
+    m_streamTags[MathTag::s] = &MathParser::StreamSpecialConstantTag;
+    m_streamTags[MathTag::fnm] = &MathParser::StreamFunctionNameTag;
+    m_streamTags[MathTag::q] = &MathParser::StreamSqrtTag;
+    m_streamTags[MathTag::d] = &MathParser::StreamDiffTag;
+    m_streamTags[MathTag::sm] = &MathParser::StreamSumTag;
+    m_streamTags[MathTag::in] = &MathParser::StreamIntTag;
+    m_streamTags[MathTag::mspace] = &MathParser::StreamSpaceTag;
+    m_streamTags[MathTag::at] = &MathParser::StreamAtTag;
+    m_streamTags[MathTag::a] = &MathParser::StreamAbsTag;
+    m_streamTags[MathTag::cj] = &MathParser::StreamConjugateTag;
+    m_streamTags[MathTag::ie] = &MathParser::StreamSubSupTag;
+    m_streamTags[MathTag::lm] = &MathParser::StreamLimitTag;
+    m_streamTags[MathTag::r] = &MathParser::StreamRowTag;
+    m_streamTags[MathTag::mrow] = &MathParser::StreamRowTag;
+    m_streamTags[MathTag::mth] = &MathParser::StreamMthTag;
+    m_streamTags[MathTag::line] = &MathParser::StreamMthTag;
+    m_streamTags[MathTag::lbl] = &MathParser::StreamOutputLabelTag;
+    m_streamTags[MathTag::st] = &MathParser::StreamStringTag;
+    m_streamTags[MathTag::hl] = &MathParser::StreamChildrenTag;
+    m_streamTags[MathTag::h] = &MathParser::StreamHiddenOperatorTag;
+    m_streamTags[MathTag::output] = &MathParser::StreamChildrenTag;
+    m_streamTags[MathTag::mtd] = &MathParser::StreamChildrenTag;
+    m_streamTags[MathTag::math] = &MathParser::StreamMthTag;
+    // "tb" is handled by StreamParseTable(). Everything else is rare enough to
+    // be passed to the handlers in m_innerTags.
   }
-  m_highlight = false;
-  if (zipfile.Length() > 0)
+  if(m_groupTags.empty())
   {
-    m_fileSystem = std::unique_ptr<wxFileSystem>(new wxFileSystem());
-    m_fileSystem->ChangePathTo(zipfile + wxT("#zip:/"), true);
+    m_groupTags[GroupTag::code] = &MathParser::GroupCellFromCodeTag;
+    m_groupTags[GroupTag::image] = &MathParser::GroupCellFromImageTag;
+    m_groupTags[GroupTag::pagebreak] = &MathParser::GroupCellFromPagebreakTag;
+    m_groupTags[GroupTag::text] = &MathParser::GroupCellFromTextTag;
+    m_groupTags[GroupTag::title] = &MathParser::GroupCellFromTitleTag;
+    m_groupTags[GroupTag::section] = &MathParser::GroupCellFromSectionTag;
+    m_groupTags[GroupTag::subsection] = &MathParser::GroupCellFromSubsectionTag;
+    m_groupTags[GroupTag::subsubsection] = &MathParser::GroupCellFromSubsubsectionTag;
+    m_groupTags[GroupTag::heading5] = &MathParser::GroupCellHeading5Tag;
+    m_groupTags[GroupTag::heading6] = &MathParser::GroupCellHeading6Tag;
   }
+  m_highlight = false;
 }
 
 MathParser::~MathParser()
@@ -245,7 +285,7 @@ Cell *MathParser::ParseSlideshowTag(wxXmlNode *node)
   bool del = node->GetAttribute(wxT("del"), wxT("false")) == wxT("true");
   node->GetAttribute(wxT("gnuplotSources"), &gnuplotSources);
   node->GetAttribute(wxT("gnuplotData"), &gnuplotData);
-  SlideShow *slideShow = new SlideShow(NULL, m_configuration, m_fileSystem);
+  SlideShow *slideShow = new SlideShow(NULL, m_configuration, m_archive);
   wxString str(node->GetChildren()->GetContent());
   wxArrayString images;
   wxString framerate;
@@ -286,7 +326,7 @@ Cell *MathParser::ParseSlideshowTag(wxXmlNode *node)
         i,
         gnuplotFiles.GetNextToken(),
         dataFiles.GetNextToken(),
-        m_fileSystem
+        m_archive
         );
     }
   }
@@ -299,8 +339,8 @@ Cell *MathParser::ParseImageTag(wxXmlNode *node)
   ImgCell *imageCell = {};
   wxString filename(node->GetChildren()->GetContent());
 
-  if (m_fileSystem) // loading from zip
-    imageCell = new ImgCell(NULL, m_configuration, filename, m_fileSystem, false);
+  if (m_archive) // loading from zip
+    imageCell = new ImgCell(NULL, m_configuration, filename, m_archive, false);
   else
   {
     if (node->GetAttribute(wxT("del"), wxT("yes")) != wxT("no"))
@@ -329,7 +369,7 @@ Cell *MathParser::ParseImageTag(wxXmlNode *node)
   wxString gnuplotData = node->GetAttribute(wxT("gnuplotdata"), wxEmptyString);
 
   if (!gnuplotSource.empty())
-    imageCell->GnuplotSource(gnuplotSource, gnuplotData, m_fileSystem);
+    imageCell->GnuplotSource(gnuplotSource, gnuplotData, m_archive);
 
   if (node->GetAttribute(wxT("rect"), wxT("true")) == wxT("false"))
     imageCell->DrawRectangle(false);
@@ -405,7 +445,7 @@ Cell *MathParser::ParseCellTag(wxXmlNode *node)
   // read (group)cell type
   wxString type = node->GetAttribute(wxT("type"), wxT("text"));
 
-  GroupCell * (MathParser::* function)(wxXmlNode *node) = m_groupTags[type];
+  GroupCellFunc function = m_groupTags[GroupTagFromName(type)];
   if (function != NULL)
     group =  CALL_MEMBER_FN(*this,function)(node);
   else  
@@ -776,8 +816,17 @@ Cell *MathParser::ParseFunTag(wxXmlNode *node)
 Cell *MathParser::ParseText(wxXmlNode *node, TextStyle style)
 {
   wxString str;
+  if (node != NULL)
+    str = node->GetContent();
+  Cell *retval = ParseTextString(str, style);
+  ParseCommonAttrs(node, retval);
+  return retval;
+}
+
+Cell *MathParser::ParseTextString(wxString str, TextStyle style)
+{
   TextCell *retval = NULL;
-  if ((node != NULL) && ((str = node->GetContent()) != wxEmptyString))
+  if (!str.IsEmpty())
   {
     str.Replace(wxT("-"), wxT("\u2212")); // unicode minus sign
 
@@ -833,8 +882,6 @@ Cell *MathParser::ParseText(wxXmlNode *node, TextStyle style)
 
   if (retval == NULL)
     retval = new TextCell(NULL, m_configuration);
-
-  ParseCommonAttrs(node, retval);
   return retval;
 }
 
@@ -856,6 +903,24 @@ void MathParser::ParseCommonAttrs(wxXmlNode *node, Cell *cell)
     cell->SetAltCopyText(val);
 }
 
+void MathParser::ParseCommonAttrs(const XmlPullParser::Attributes &attributes, Cell *cell)
+{
+  if(cell == NULL)
+    return;
+  if(attributes.Empty())
+    return;
+
+  if(attributes.Get(wxT("breakline"), wxT("false")) == wxT("true"))
+    cell->ForceBreakLine(true);
+
+  wxString val;
+  if (attributes.Get(wxT("tooltip"), &val))
+    if (!val.empty())
+      cell->SetToolTip(std::move(val));
+  if(attributes.Get(wxT("altCopy"), &val))
+    cell->SetAltCopyText(val);
+}
+
 void MathParser::ParseCommonGroupCellAttrs(wxXmlNode *node, GroupCell *group)
 {
   if(group == NULL)
@@ -1069,7 +1134,7 @@ Cell *MathParser::ParseTag_(wxXmlNode *node, bool all)
 
       Cell *tmp = NULL;
 
-      Cell * (MathParser::* function)(wxXmlNode *node) = m_innerTags[tagName];
+      MathCellFunc function = m_innerTags[MathTagFromName(tagName)];
       if (function != NULL)
         tmp =  CALL_MEMBER_FN(*this, function)(node);
 //      if ((tmp == NULL) && (node->GetChildren()))
@@ -1137,6 +1202,7 @@ std::unique_ptr<Cell> MathParser::ParseTag(wxXmlNode *node, bool all)
 
 Cell *MathParser::ParseLine(wxString s, CellType style)
 {
+  RenderTimings::Scope timing(RenderTimings::parse);
   m_ParserStyle = style;
   m_FracStyle = FracCell::FC_NORMAL;
   m_highlight = false;
@@ -1167,16 +1233,27 @@ Cell *MathParser::ParseLine(wxString s, CellType style)
   if (((long) s.Length() < showLength) || (showLength == 0))
   {
 
-    wxXmlDocument xml;
+    std::unique_ptr<Cell> streamed;
+    if (ParseLineStreaming(s, streamed))
+      cell = streamed.release();
+    else
+    {
+      // Our parser only knows the XML maxima and wxMaxima generate.
+      // Let's see if wxXmlDocument can make sense of the rest.
+      m_FracStyle = FracCell::FC_NORMAL;
+      m_highlight = false;
+
+      wxXmlDocument xml;
 
-    wxStringInputStream xmlStream(s);
+      wxStringInputStream xmlStream(s);
 
-    xml.Load(xmlStream, wxT("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
+      xml.Load(xmlStream, wxT("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
 
-    wxXmlNode *doc = xml.GetRoot();
+      wxXmlNode *doc = xml.GetRoot();
 
-    if (doc != NULL)
-      cell = ParseTag_(doc->GetChildren());
+      if (doc != NULL)
+        cell = ParseTag_(doc->GetChildren());
+    }
   }
   else
   {
@@ -1189,7 +1266,624 @@ Cell *MathParser::ParseLine(wxString s, CellType style)
   return cell;
 }
 
+bool MathParser::ParseLineStreaming(const wxString &s, std::unique_ptr<Cell> &cell)
+{
+  XmlPullParser reader(s);
+  // The root element only is a container for the cells
+  if (reader.Next() != XmlPullParser::StartElement)
+    return false;
+  std::vector<StreamNode> children;
+  if (!StreamParseChildren(reader, children))
+    return false;
+  if (reader.Next() != XmlPullParser::EndOfDocument)
+    return false;
+  cell = StreamTakeCells(StreamSlots(children), 0);
+  return true;
+}
+
+bool MathParser::StreamParseElement(XmlPullParser &reader, StreamNode &node)
+{
+  node.name = reader.GetName();
+  node.attributes = reader.GetAttributes();
+
+  MathTag tag = MathTagFromName(node.name);
+  if (tag == MathTag::tb)
+  {
+    if (!StreamParseTable(reader, node))
+      return false;
+  }
+  else
+  {
+    StreamCellFunc builder = m_streamTags[tag];
+    if (builder == NULL)
+    {
+      std::unique_ptr<wxXmlNode> xmlNode(StreamToXmlNode(reader, node.name, node.attributes));
+      if (!xmlNode)
+        return false;
+      node.cell.reset(ParseTag_(xmlNode.get(), false));
+      return true;
+    }
+
+    std::vector<StreamNode> children;
+    bool highlight = m_highlight;
+    if (tag == MathTag::hl)
+      m_highlight = true;
+    bool wellFormed = StreamParseChildren(reader, children, tag == MathTag::d);
+    m_highlight = highlight;
+    if (!wellFormed)
+      return false;
+    node.cell.reset(CALL_MEMBER_FN(*this, builder)(node.attributes, children));
+  }
+
+  if ((!node.cell) && (node.attributes.Get(wxT("listdelim")) != wxT("true")))
+    node.cell.reset(new VisiblyInvalidCell(NULL, m_configuration,
+                                           wxString::Format(m_unknownXMLTagToolTip,
+                                                            node.name.utf8_str())));
+  ParseCommonAttrs(node.attributes, node.cell.get());
+  return true;
+}
+
+bool MathParser::StreamParseChildren(XmlPullParser &reader, std::vector<StreamNode> &children,
+                                     bool diffStyle)
+{
+  while (true)
+  {
+    switch (reader.Next())
+    {
+    case XmlPullParser::EndElement:
+      return true;
+    case XmlPullParser::Text:
+      children.emplace_back();
+      children.back().text = reader.GetText();
+      children.back().highlight = m_highlight;
+      if (!IsWhitespaceNode(children.back()))
+        diffStyle = false;
+      break;
+    case XmlPullParser::StartElement:
+    {
+      children.emplace_back();
+      auto fracStyle = m_FracStyle;
+      if (diffStyle)
+        m_FracStyle = FracCell::FC_DIFF;
+      diffStyle = false;
+      bool wellFormed = StreamParseElement(reader, children.back());
+      m_FracStyle = fracStyle;
+      if (!wellFormed)
+        return false;
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+}
+
+bool MathParser::StreamParseTable(XmlPullParser &reader, StreamNode &node)
+{
+  std::unique_ptr<MatrCell> matrix(new MatrCell(NULL, m_configuration));
+  matrix->SetHighlight(m_highlight);
+
+  const XmlPullParser::Attributes &attributes = node.attributes;
+  if (attributes.Get(wxT("special"), wxT("false")) == wxT("true"))
+    matrix->SetSpecialFlag(true);
+  if (attributes.Get(wxT("inference"), wxT("false")) == wxT("true"))
+  {
+    matrix->SetInferenceFlag(true);
+    matrix->SetSpecialFlag(true);
+  }
+  if (attributes.Get(wxT("colnames"), wxT("false")) == wxT("true"))
+    matrix->ColNames(true);
+  if (attributes.Get(wxT("rownames"), wxT("false")) == wxT("true"))
+    matrix->RowNames(true);
+  if (attributes.Get(wxT("roundedParens"), wxT("false")) == wxT("true"))
+    matrix->RoundedParens(true);
+
+  bool endOfTable = false;
+  while (!endOfTable)
+  {
+    switch (reader.Next())
+    {
+    case XmlPullParser::EndElement:
+      endOfTable = true;
+      break;
+    case XmlPullParser::Text:
+    {
+      StreamNode text;
+      text.text = reader.GetText();
+      // A text row has no cells
+      if (!IsWhitespaceNode(text))
+        matrix->NewRow();
+      break;
+    }
+    case XmlPullParser::StartElement:
+    {
+      matrix->NewRow();
+      // The entries of a big matrix are turned into cells when they are drawn
+      if (matrix->GetEntries() >= MatrCell::maxEagerEntries)
+      {
+        if (!StreamTableRowAsXML(reader, *matrix))
+          return false;
+        break;
+      }
+      std::vector<StreamNode> cells;
+      if (!StreamParseChildren(reader, cells))
+        return false;
+      auto slots = StreamSlots(cells);
+      for (size_t i = 0; i < slots.size(); i++)
+      {
+        matrix->NewColumn();
+        matrix->AddNewCell(HandleNullPointer(StreamTakeCell(slots, i)));
+      }
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  matrix->SetType(m_ParserStyle);
+  matrix->SetStyle(TS_VARIABLE);
+  matrix->SetDimension();
+  node.cell = std::move(matrix);
+  return true;
+}
+
+bool MathParser::StreamTableRowAsXML(XmlPullParser &reader, MatrCell &matrix)
+{
+  while (true)
+  {
+    switch (reader.Next())
+    {
+    case XmlPullParser::EndElement:
+      return true;
+    case XmlPullParser::Text:
+    {
+      StreamNode text;
+      text.text = reader.GetText();
+      if (!IsWhitespaceNode(text))
+      {
+        matrix.NewColumn();
+        matrix.AddNewCell(HandleNullPointer(std::unique_ptr<Cell>(ParseTextString(text.text))));
+      }
+      break;
+    }
+    case XmlPullParser::StartElement:
+    {
+      wxString xml;
+      if (!reader.SkipElement(xml))
+        return false;
+      matrix.NewColumn();
+      matrix.AddNewEntry(xml);
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+}
+
+wxXmlNode *MathParser::StreamToXmlNode(XmlPullParser &reader, const wxString &name,
+                                       const XmlPullParser::Attributes &attributes)
+{
+  std::unique_ptr<wxXmlNode> element(new wxXmlNode(wxXML_ELEMENT_NODE, name));
+  for (auto const &attribute : attributes.GetAll())
+    element->AddAttribute(attribute.first, attribute.second);
+
+  wxXmlNode *last = NULL;
+  while (true)
+  {
+    wxXmlNode *child;
+    switch (reader.Next())
+    {
+    case XmlPullParser::EndElement:
+      return element.release();
+    case XmlPullParser::Text:
+      child = new wxXmlNode(wxXML_TEXT_NODE, wxEmptyString, reader.GetText());
+      break;
+    case XmlPullParser::StartElement:
+      child = StreamToXmlNode(reader, reader.GetName(), reader.GetAttributes());
+      if (child == NULL)
+        return NULL;
+      break;
+    default:
+      return NULL;
+    }
+    // AddChild() would have to search for the end of the list every time
+    if (last == NULL)
+      element->AddChild(child);
+    else
+      element->InsertChildAfter(child, last);
+    last = child;
+  }
+}
+
+bool MathParser::IsWhitespaceNode(const StreamNode &node)
+{
+  if (!node.name.IsEmpty())
+    return false;
+  // Does the same as SkipWhitespaceNode(), but without copying the text
+  size_t length = node.text.Length();
+  while ((length > 0) && wxIsspace(node.text[length - 1]))
+    length--;
+  return length <= 1;
+}
+
+std::vector<MathParser::StreamNode *> MathParser::StreamSlots(std::vector<StreamNode> &children)
+{
+  std::vector<StreamNode *> slots;
+  slots.reserve(children.size());
+  for (auto &child : children)
+    if (!IsWhitespaceNode(child))
+      slots.push_back(&child);
+  return slots;
+}
+
+wxString MathParser::StreamLeafText(const std::vector<StreamNode> &children)
+{
+  if ((!children.empty()) && children.front().name.IsEmpty())
+    return children.front().text;
+  return wxEmptyString;
+}
+
+std::unique_ptr<Cell> MathParser::StreamTakeCell(const std::vector<StreamNode *> &slots, size_t index)
+{
+  if (index >= slots.size())
+    return nullptr;
+  StreamNode *slot = slots[index];
+  if (slot->name.IsEmpty())
+  {
+    bool highlight = m_highlight;
+    m_highlight = slot->highlight;
+    std::unique_ptr<Cell> cell(ParseTextString(slot->text));
+    m_highlight = highlight;
+    return cell;
+  }
+  return std::move(slot->cell);
+}
+
+std::unique_ptr<Cell> MathParser::StreamTakeCells(const std::vector<StreamNode *> &slots, size_t index)
+{
+  std::unique_ptr<Cell> retval;
+  Cell *last = NULL;
+  for (size_t i = index; i < slots.size(); i++)
+  {
+    Cell *cell = StreamTakeCell(slots, i).release();
+    if (cell == NULL)
+      continue;
+    if (last == NULL)
+      retval.reset(cell);
+    else
+      last->AppendCell(cell);
+    last = cell;
+  }
+  return retval;
+}
+
+Cell *MathParser::StreamMiscTextTag(const XmlPullParser::Attributes &attributes,
+                                    std::vector<StreamNode> &children)
+{
+  if (attributes.Get(wxT("listdelim")) == wxT("true"))
+    return NULL;
+  TextStyle style = TS_DEFAULT;
+  wxString type = attributes.Get(wxT("type"));
+  if (type == wxT("error"))
+    style = TS_ERROR;
+  if (type == wxT("warning"))
+    style = TS_WARNING;
+  return ParseTextString(StreamLeafText(children), style);
+}
+
+Cell *MathParser::StreamHiddenOperatorTag(const XmlPullParser::Attributes &,
+                                          std::vector<StreamNode> &children)
+{
+  Cell *retval = ParseTextString(StreamLeafText(children));
+  retval->SetHidableMultSign(true);
+  return retval;
+}
+
+Cell *MathParser::StreamOutputLabelTag(const XmlPullParser::Attributes &attributes,
+                                       std::vector<StreamNode> &children)
+{
+  Cell *tmp;
+  wxString user_lbl = attributes.Get(wxT("userdefinedlabel"), m_userDefinedLabel);
+
+  if (attributes.Get(wxT("userdefined"), wxT("no")) != wxT("yes"))
+    tmp = ParseTextString(StreamLeafText(children), TS_LABEL);
+  else
+  {
+    tmp = ParseTextString(StreamLeafText(children), TS_USERLABEL);
+
+    // Backwards compatibility to 17.04/17.12, see ParseOutputLabelTag()
+    if(user_lbl == wxEmptyString)
+    {
+      user_lbl = dynamic_cast<TextCell *>(tmp)->GetValue();
+      user_lbl = user_lbl.substr(1,user_lbl.Length() - 2);
+    }
+  }
+
+  dynamic_cast<LabelCell *>(tmp)->SetUserDefinedLabel(user_lbl);
+  tmp->ForceBreakLine(true);
+  return tmp;
+}
+
+Cell *MathParser::StreamChildrenTag(const XmlPullParser::Attributes &,
+                                    std::vector<StreamNode> &children)
+{
+  return StreamTakeCells(StreamSlots(children), 0).release();
+}
+
+Cell *MathParser::StreamRowTag(const XmlPullParser::Attributes &attributes,
+                               std::vector<StreamNode> &children)
+{
+  auto inner = StreamTakeCells(StreamSlots(children), 0);
+  if (attributes.Get(wxT("list")) != wxT("true"))
+    return inner.release();
+
+  ListCell *cell = new ListCell(NULL, m_configuration);
+  // No special Handling for NULL args here: They are completely legal in this case.
+  cell->SetInner(std::move(inner), m_ParserStyle);
+  cell->SetHighlight(m_highlight);
+  cell->SetStyle(TS_VARIABLE);
+  return cell;
+}
+
+Cell *MathParser::StreamMthTag(const XmlPullParser::Attributes &,
+                               std::vector<StreamNode> &children)
+{
+  Cell *retval = StreamTakeCells(StreamSlots(children), 0).release();
+  if (retval != NULL)
+    retval->ForceBreakLine(true);
+  else
+    retval = new TextCell(NULL, m_configuration, wxT(" "));
+  return retval;
+}
+
+Cell *MathParser::StreamParenTag(const XmlPullParser::Attributes &attributes,
+                                 std::vector<StreamNode> &children)
+{
+  ParenCell *cell = new ParenCell(NULL, m_configuration);
+  // No special Handling for NULL args here: They are completely legal in this case.
+  cell->SetInner(StreamTakeCells(StreamSlots(children), 0), m_ParserStyle);
+  cell->SetHighlight(m_highlight);
+  cell->SetStyle(TS_VARIABLE);
+  if (!attributes.Empty())
+    cell->SetPrint(false);
+  return cell;
+}
+
+Cell *MathParser::StreamSqrtTag(const XmlPullParser::Attributes &,
+                                std::vector<StreamNode> &children)
+{
+  SqrtCell *cell = new SqrtCell(NULL, m_configuration);
+  cell->SetInner(HandleNullPointer(StreamTakeCells(StreamSlots(children), 0)));
+  cell->SetType(m_ParserStyle);
+  cell->SetStyle(TS_VARIABLE);
+  cell->SetHighlight(m_highlight);
+  return cell;
+}
+
+Cell *MathParser::StreamAbsTag(const XmlPullParser::Attributes &,
+                               std::vector<StreamNode> &children)
+{
+  AbsCell *cell = new AbsCell(NULL, m_configuration);
+  cell->SetInner(HandleNullPointer(StreamTakeCells(StreamSlots(children), 0)));
+  cell->SetType(m_ParserStyle);
+  cell->SetStyle(TS_VARIABLE);
+  cell->SetHighlight(m_highlight);
+  return cell;
+}
+
+Cell *MathParser::StreamConjugateTag(const XmlPullParser::Attributes &,
+                                     std::vector<StreamNode> &children)
+{
+  ConjugateCell *cell = new ConjugateCell(NULL, m_configuration);
+  cell->SetInner(HandleNullPointer(StreamTakeCells(StreamSlots(children), 0)));
+  cell->SetType(m_ParserStyle);
+  cell->SetStyle(TS_VARIABLE);
+  cell->SetHighlight(m_highlight);
+  return cell;
+}
+
+Cell *MathParser::StreamFracTag(const XmlPullParser::Attributes &attributes,
+                                std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  FracCell *frac = new FracCell(NULL, m_configuration);
+  frac->SetFracStyle(m_FracStyle);
+  frac->SetHighlight(m_highlight);
+  frac->SetNum(HandleNullPointer(StreamTakeCell(slots, 0)));
+  frac->SetDenom(HandleNullPointer(StreamTakeCell(slots, 1)));
+
+  if (attributes.Get(wxT("line")) == wxT("no"))
+    frac->SetFracStyle(FracCell::FC_CHOOSE);
+  if (attributes.Get(wxT("diffstyle")) == wxT("yes"))
+    frac->SetFracStyle(FracCell::FC_DIFF);
+  frac->SetType(m_ParserStyle);
+  frac->SetStyle(TS_VARIABLE);
+  frac->SetupBreakUps();
+  return frac;
+}
+
+Cell *MathParser::StreamSupTag(const XmlPullParser::Attributes &attributes,
+                               std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  ExptCell *expt = new ExptCell(NULL, m_configuration);
+  if (!attributes.Empty())
+    expt->IsMatrix(true);
+
+  auto base = HandleNullPointer(StreamTakeCell(slots, 0));
+  auto baseText = base->ToString();
+  expt->SetBase(std::move(base));
+
+  auto power = HandleNullPointer(StreamTakeCell(slots, 1));
+  power->SetExponentFlag();
+  auto powerText = power->ToString();
+  expt->SetPower(std::move(power));
+  expt->SetType(m_ParserStyle);
+  expt->SetStyle(TS_VARIABLE);
+
+  ParseCommonAttrs(attributes, expt);
+  if(attributes.Get(wxT("mat"), wxT("false")) == wxT("true"))
+    expt->SetAltCopyText(baseText + wxT("^^") + powerText);
+
+  return expt;
+}
+
+Cell *MathParser::StreamSubTag(const XmlPullParser::Attributes &,
+                               std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  SubCell *sub = new SubCell(NULL, m_configuration);
+  sub->SetBase(HandleNullPointer(StreamTakeCell(slots, 0)));
+  auto index = HandleNullPointer(StreamTakeCell(slots, 1));
+  index->SetExponentFlag();
+  sub->SetIndex(std::move(index));
+  sub->SetType(m_ParserStyle);
+  sub->SetStyle(TS_VARIABLE);
+  return sub;
+}
+
+Cell *MathParser::StreamSubSupTag(const XmlPullParser::Attributes &,
+                                  std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  SubSupCell *subsup = new SubSupCell(NULL, m_configuration);
+  subsup->SetBase(HandleNullPointer(StreamTakeCell(slots, 0)));
+  if ((slots.size() > 1) && (slots[1]->attributes.Get(wxT("pos")) != wxEmptyString))
+  {
+    for (size_t i = 1; i < slots.size(); i++)
+    {
+      wxString pos = slots[i]->attributes.Get(wxT("pos"));
+      auto cell = HandleNullPointer(StreamTakeCell(slots, i));
+      if(pos == "presub")
+        subsup->SetPreSub(std::move(cell));
+      if(pos == "presup")
+        subsup->SetPreSup(std::move(cell));
+      if(pos == "postsup")
+        subsup->SetPostSup(std::move(cell));
+      if(pos == "postsub")
+        subsup->SetPostSub(std::move(cell));
+    }
+  }
+  else
+  {
+    auto index = HandleNullPointer(StreamTakeCell(slots, 1));
+    index->SetExponentFlag();
+    subsup->SetIndex(std::move(index));
+    auto power = HandleNullPointer(StreamTakeCell(slots, 2));
+    power->SetExponentFlag();
+    subsup->SetExponent(std::move(power));
+    subsup->SetType(m_ParserStyle);
+    subsup->SetStyle(TS_VARIABLE);
+  }
+  return subsup;
+}
+
+Cell *MathParser::StreamFunTag(const XmlPullParser::Attributes &attributes,
+                               std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  FunCell *fun = new FunCell(NULL, m_configuration);
+  fun->SetName(HandleNullPointer(StreamTakeCell(slots, 0)));
+  fun->SetType(m_ParserStyle);
+  fun->SetStyle(TS_FUNCTION);
+  fun->SetArg(HandleNullPointer(StreamTakeCell(slots, 1)));
+  ParseCommonAttrs(attributes, fun);
+  if (fun->ToString().Contains(")("))
+    fun->SetToolTip(&T_("If this isn't a function returning a lambda() "
+                        "expression a multiplication sign (*) between closing "
+                        "and opening parenthesis is missing here."));
+  return fun;
+}
+
+Cell *MathParser::StreamDiffTag(const XmlPullParser::Attributes &,
+                                std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  DiffCell *diff = new DiffCell(NULL, m_configuration);
+  if (!slots.empty())
+  {
+    // StreamParseChildren() has already parsed the first slot using FC_DIFF
+    diff->SetDiff(HandleNullPointer(StreamTakeCell(slots, 0)));
+    diff->SetBase(HandleNullPointer(StreamTakeCells(slots, 1)));
+    diff->SetType(m_ParserStyle);
+    diff->SetStyle(TS_VARIABLE);
+  }
+  return diff;
+}
+
+Cell *MathParser::StreamSumTag(const XmlPullParser::Attributes &attributes,
+                               std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  SumCell *sum = new SumCell(NULL, m_configuration);
+  wxString type = attributes.Get(wxT("type"), wxT("sum"));
+
+  if (type == wxT("prod"))
+    sum->SetSumStyle(SM_PROD);
+  sum->SetHighlight(m_highlight);
+  sum->SetUnder(HandleNullPointer(StreamTakeCell(slots, 0)));
+  if (type != wxT("lsum"))
+    sum->SetOver(HandleNullPointer(StreamTakeCell(slots, 1)));
+  sum->SetBase(HandleNullPointer(StreamTakeCell(slots, 2)));
+  sum->SetType(m_ParserStyle);
+  sum->SetStyle(TS_VARIABLE);
+  return sum;
+}
+
+Cell *MathParser::StreamIntTag(const XmlPullParser::Attributes &attributes,
+                               std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  IntCell *in = new IntCell(NULL, m_configuration);
+  in->SetHighlight(m_highlight);
+  if (attributes.Get(wxT("def"), wxT("true")) != wxT("true"))
+  {
+    in->SetBase(HandleNullPointer(StreamTakeCell(slots, 0)));
+    in->SetVar(HandleNullPointer(StreamTakeCells(slots, 1)));
+  }
+  else
+  {
+    // A Definite integral
+    in->SetIntStyle(IntCell::INT_DEF);
+    in->SetUnder(HandleNullPointer(StreamTakeCell(slots, 0)));
+    in->SetOver(HandleNullPointer(StreamTakeCell(slots, 1)));
+    in->SetBase(HandleNullPointer(StreamTakeCell(slots, 2)));
+    in->SetVar(HandleNullPointer(StreamTakeCells(slots, 3)));
+  }
+  in->SetType(m_ParserStyle);
+  in->SetStyle(TS_VARIABLE);
+  return in;
+}
+
+Cell *MathParser::StreamAtTag(const XmlPullParser::Attributes &,
+                              std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  AtCell *at = new AtCell(NULL, m_configuration);
+  at->SetBase(HandleNullPointer(StreamTakeCell(slots, 0)));
+  at->SetHighlight(m_highlight);
+  at->SetIndex(HandleNullPointer(StreamTakeCell(slots, 1)));
+  at->SetType(m_ParserStyle);
+  at->SetStyle(TS_VARIABLE);
+  return at;
+}
+
+Cell *MathParser::StreamLimitTag(const XmlPullParser::Attributes &,
+                                 std::vector<StreamNode> &children)
+{
+  auto slots = StreamSlots(children);
+  LimitCell *limit = new LimitCell(NULL, m_configuration);
+  limit->SetName(HandleNullPointer(StreamTakeCell(slots, 0)));
+  limit->SetUnder(HandleNullPointer(StreamTakeCell(slots, 1)));
+  limit->SetBase(HandleNullPointer(StreamTakeCell(slots, 2)));
+  limit->SetType(m_ParserStyle);
+  limit->SetStyle(TS_VARIABLE);
+  return limit;
+}
+
 wxRegEx MathParser::m_graphRegex(wxT("[[:cntrl:]]"));
-MathParser::MathCellFunctionHash MathParser::m_innerTags;
-MathParser::GroupCellFunctionHash MathParser::m_groupTags;
+MathParser::MathCellFunctionTable MathParser::m_innerTags;
+MathParser::StreamCellFunctionTable MathParser::m_streamTags;
+MathParser::GroupCellFunctionTable MathParser::m_groupTags;
 wxString MathParser::m_unknownXMLTagToolTip;
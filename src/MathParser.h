@@ -31,8 +31,6 @@ The header file for the xml cell parser
 #include "precomp.h"
 #include <wx/xml/xml.h>
 
-#include <wx/filesys.h>
-#include <wx/fs_arc.h>
 #include <wx/regex.h>
 #include <wx/hashmap.h>
 #include "Cell.h"
@@ -40,6 +38,12 @@ The header file for the xml cell parser
 #include "EditorCell.h"
 #include "FracCell.h"
 #include "GroupCell.h"
+#include "XmlPullParser.h"
+#include "MathTags.h"
+#include "ZipIndex.h"
+#include <vector>
+
+class MatrCell;
 
 /*! This class handles parsing the xml representation of a cell tree.
 
@@ -51,10 +55,10 @@ class MathParser
 public:
   /*! The constructor
 
-     \todo I guess we could increase the performance further by putting the 
-     most-frequently-used tags to the front of the list.
+    \param archive The .wxmx file the images the xml refers to are stored in.
+                    NULL = the images are files in the operating system's filesystem.
    */
-  explicit MathParser(Configuration **cfg, const wxString &zipfile = {});
+  explicit MathParser(Configuration **cfg, std::shared_ptr<ZipIndex> archive = {});
   //! This class doesn't have a copy constructor
   MathParser(const MathParser&) = delete;
   //! This class doesn't have a = operator
@@ -65,8 +69,19 @@ public:
   /***
    * Parse the string s, which is (correct) xml fragment.
    * Put the result in line.
+   *
+   * Tries ParseLineStreaming() first and falls back to a wxXmlDocument if that fails.
    */
   Cell *ParseLine(wxString s, CellType style = MC_TYPE_DEFAULT);
+  /*! Parse the xml fragment s without building a wxXmlDocument first
+
+    Creates the cells directly while reading s. Tags there is no streaming
+    parser for are converted to a small wxXmlNode tree and passed to the
+    handlers in m_innerTags.
+
+    \return false, if s isn't well-formed XML.
+   */
+  bool ParseLineStreaming(const wxString &s, std::unique_ptr<Cell> &cell);
   /***
    * Parse the node and return the corresponding tag.
    */
@@ -102,19 +117,43 @@ private:
 
   //! A pointer to a method that handles an XML tag for a type of Cell
   typedef Cell *(MathParser::*MathCellFunc)(wxXmlNode *node);
-  WX_DECLARE_STRING_HASH_MAP(MathCellFunc, MathCellFunctionHash);
+  typedef TagTable<MathTag, MathCellFunc> MathCellFunctionTable;
   //! A pointer to a method that handles an XML tag for a type of GroupCell
   typedef GroupCell *(MathParser::*GroupCellFunc)(wxXmlNode *node);
-  WX_DECLARE_STRING_HASH_MAP(GroupCellFunc, GroupCellFunctionHash);
+  typedef TagTable<GroupTag, GroupCellFunc> GroupCellFunctionTable;
 
   /*! Who you gonna call if you encounter any of these math cell tags?
+
+    Indexed by MathTagFromName() of the tag name.
    */
-  static MathCellFunctionHash m_innerTags;
+  static MathCellFunctionTable m_innerTags;
+
+  //! A child node of the element the streaming parser is reading
+  struct StreamNode
+  {
+    //! The tag name or, for text nodes, an empty string
+    wxString name;
+    XmlPullParser::Attributes attributes;
+    //! The contents of a text node
+    wxString text;
+    //! Is the text node inside a <hl> tag? Its cell is only made after that tag has ended.
+    bool highlight = false;
+    //! The cell generated from an element
+    std::unique_ptr<Cell> cell;
+  };
+  //! A pointer to a method that generates a Cell from a tag the streaming parser has read
+  typedef Cell *(MathParser::*StreamCellFunc)(const XmlPullParser::Attributes &attributes,
+                                               std::vector<StreamNode> &children);
+  typedef TagTable<MathTag, StreamCellFunc> StreamCellFunctionTable;
+  //! The math cell tags ParseLineStreaming() can handle without a wxXmlNode
+  static StreamCellFunctionTable m_streamTags;
   //! A list of functions to call on encountering all types of GroupCell tags
-  static GroupCellFunctionHash m_groupTags;
+  static GroupCellFunctionTable m_groupTags;
   //! Parses attributes that apply to nearly all types of cells
   static void ParseCommonAttrs(wxXmlNode *node, Cell *cell);
   //! Parses attributes that apply to nearly all types of cells
+  static void ParseCommonAttrs(const XmlPullParser::Attributes &attributes, Cell *cell);
+  //! Parses attributes that apply to nearly all types of cells
   static void ParseCommonGroupCellAttrs(wxXmlNode *node, GroupCell *group);
   //! Returns cell or, if cell==NULL, an empty text cell as a fallback.
   std::unique_ptr<Cell> HandleNullPointer(std::unique_ptr<Cell> &&cell);
@@ -204,6 +243,8 @@ private:
   Cell *ParseFracTag(wxXmlNode *node);
   //! Parse a text XML tag to a Cell. 
   Cell *ParseText(wxXmlNode *node, TextStyle style = TS_DEFAULT);
+  //! Convert a string to a list of TextCells, one for each line
+  Cell *ParseTextString(wxString str, TextStyle style = TS_DEFAULT);
   //! Parse a Variable name tag to a Cell. 
   Cell *ParseVariableNameTag(wxXmlNode *node){return ParseText(node->GetChildren(), TS_VARIABLE);}
   //! Parse an Operator name tag to a Cell. 
@@ -276,6 +317,77 @@ private:
   //! Parse an Matrix cell tag. 
   Cell *ParseMtdTag(wxXmlNode *node);
   // @}
+
+  /*! \defgroup StreamParsing Methods that generate Cell objects while reading XML
+    @{
+  */
+  /*! Reads the element whose start tag the reader has just returned
+
+    \return false, if the XML isn't well-formed.
+   */
+  bool StreamParseElement(XmlPullParser &reader, StreamNode &node);
+  /*! Reads all children of the current element, up to and including its end tag
+
+    \param diffStyle Parse the first child as the "d" in a derivative
+   */
+  bool StreamParseChildren(XmlPullParser &reader, std::vector<StreamNode> &children,
+                           bool diffStyle = false);
+  //! Reads a matrix
+  bool StreamParseTable(XmlPullParser &reader, StreamNode &node);
+  //! Reads a row of a matrix, keeping its entries as XML
+  bool StreamTableRowAsXML(XmlPullParser &reader, MatrCell &matrix);
+  //! Reads the current element into a wxXmlNode tree for the handlers in m_innerTags
+  static wxXmlNode *StreamToXmlNode(XmlPullParser &reader, const wxString &name,
+                                    const XmlPullParser::Attributes &attributes);
+  //! True if ParseTag_() would skip this text node as whitespace
+  static bool IsWhitespaceNode(const StreamNode &node);
+  //! The children the DOM-based parser would pass to ParseTag(): Everything but whitespace
+  static std::vector<StreamNode *> StreamSlots(std::vector<StreamNode> &children);
+  //! The text of the first child, if that is a text node
+  static wxString StreamLeafText(const std::vector<StreamNode> &children);
+  //! Take the cell for the slot number index, or NULL, if there is no such slot
+  std::unique_ptr<Cell> StreamTakeCell(const std::vector<StreamNode *> &slots, size_t index);
+  //! Take the cells for all slots, beginning at the slot number index, as one list
+  std::unique_ptr<Cell> StreamTakeCells(const std::vector<StreamNode *> &slots, size_t index);
+
+  Cell *StreamVariableNameTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_VARIABLE);}
+  Cell *StreamOperatorNameTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_FUNCTION);}
+  Cell *StreamNumberTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_NUMBER);}
+  Cell *StreamGreekTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_GREEK_CONSTANT);}
+  Cell *StreamSpecialConstantTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_SPECIAL_CONSTANT);}
+  Cell *StreamFunctionNameTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_FUNCTION);}
+  Cell *StreamStringTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &children)
+    {return ParseTextString(StreamLeafText(children), TS_STRING);}
+  Cell *StreamSpaceTag(const XmlPullParser::Attributes &, std::vector<StreamNode> &)
+    {return new TextCell(NULL, m_configuration, wxT(" "));}
+  Cell *StreamMiscTextTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamHiddenOperatorTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamOutputLabelTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  //! The streaming equivalent of ParseOutputTag, ParseMtdTag and ParseHighlightTag
+  Cell *StreamChildrenTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamRowTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamMthTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamParenTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamSqrtTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamAbsTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamConjugateTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamFracTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamSupTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamSubTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamSubSupTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamFunTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamDiffTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamSumTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamIntTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamAtTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  Cell *StreamLimitTag(const XmlPullParser::Attributes &attributes, std::vector<StreamNode> &children);
+  // @}
   //! The last user defined label
   wxString m_userDefinedLabel;
   //! A RegEx that catches the last graphics placeholder
@@ -285,7 +397,7 @@ private:
   FracCell::FracType m_FracStyle;
   Configuration **m_configuration;
   bool m_highlight;
-  std::shared_ptr<wxFileSystem> m_fileSystem; // used for loading pictures in <img> and <slide>
+  std::shared_ptr<ZipIndex> m_archive; // used for loading pictures in <img> and <slide>
   static wxString m_unknownXMLTagToolTip;
 };
 
@@ -0,0 +1,192 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the functions that convert XML tag names to MathTags.
+ */
+
+#include "MathTags.h"
+
+MathTag MathTagFromName(const wxString &name)
+{
+  if (name.IsEmpty())
+    return MathTag::unknown;
+
+  // All tags of the same length and with the same first character are
+  // compared in full. That is at most three comparisons.
+  switch (name.Length())
+  {
+  case 1:
+    switch (static_cast<wxChar>(name[0]))
+    {
+    case wxT('v'): return MathTag::v;
+    case wxT('t'): return MathTag::t;
+    case wxT('n'): return MathTag::n;
+    case wxT('p'): return MathTag::p;
+    case wxT('f'): return MathTag::f;
+    case wxT('e'): return MathTag::e;
+    case wxT('i'): return MathTag::i;
+    case wxT('g'): return MathTag::g;
+    case wxT('s'): return MathTag::s;
+    case wxT('q'): return MathTag::q;
+    case wxT('d'): return MathTag::d;
+    case wxT('a'): return MathTag::a;
+    case wxT('r'): return MathTag::r;
+    case wxT('h'): return MathTag::h;
+    }
+    break;
+  case 2:
+    switch (static_cast<wxChar>(name[0]))
+    {
+    case wxT('m'):
+      if (name == wxT("mi")) return MathTag::mi;
+      if (name == wxT("mo")) return MathTag::mo;
+      if (name == wxT("mn")) return MathTag::mn;
+      break;
+    case wxT('f'):
+      if (name == wxT("fn")) return MathTag::fn;
+      break;
+    case wxT('s'):
+      if (name == wxT("sm")) return MathTag::sm;
+      if (name == wxT("st")) return MathTag::st;
+      break;
+    case wxT('i'):
+      if (name == wxT("in")) return MathTag::in;
+      if (name == wxT("ie")) return MathTag::ie;
+      break;
+    case wxT('a'):
+      if (name == wxT("at")) return MathTag::at;
+      break;
+    case wxT('c'):
+      if (name == wxT("cj")) return MathTag::cj;
+      break;
+    case wxT('l'):
+      if (name == wxT("lm")) return MathTag::lm;
+      break;
+    case wxT('t'):
+      if (name == wxT("tb")) return MathTag::tb;
+      break;
+    case wxT('h'):
+      if (name == wxT("hl")) return MathTag::hl;
+      break;
+    }
+    break;
+  case 3:
+    switch (static_cast<wxChar>(name[0]))
+    {
+    case wxT('f'):
+      if (name == wxT("fnm")) return MathTag::fnm;
+      break;
+    case wxT('m'):
+      if (name == wxT("mth")) return MathTag::mth;
+      if (name == wxT("mtd")) return MathTag::mtd;
+      break;
+    case wxT('l'):
+      if (name == wxT("lbl")) return MathTag::lbl;
+      break;
+    case wxT('i'):
+      if (name == wxT("img")) return MathTag::img;
+      break;
+    }
+    break;
+  case 4:
+    switch (static_cast<wxChar>(name[0]))
+    {
+    case wxT('m'):
+      if (name == wxT("msup")) return MathTag::msup;
+      if (name == wxT("mrow")) return MathTag::mrow;
+      if (name == wxT("math")) return MathTag::math;
+      break;
+    case wxT('l'):
+      if (name == wxT("line")) return MathTag::line;
+      break;
+    case wxT('c'):
+      if (name == wxT("cell")) return MathTag::cell;
+      break;
+    }
+    break;
+  case 5:
+    switch (static_cast<wxChar>(name[0]))
+    {
+    case wxT('m'):
+      if (name == wxT("mfrac")) return MathTag::mfrac;
+      break;
+    case wxT('s'):
+      if (name == wxT("slide")) return MathTag::slide;
+      break;
+    case wxT('a'):
+      if (name == wxT("ascii")) return MathTag::ascii;
+      break;
+    }
+    break;
+  case 6:
+    switch (static_cast<wxChar>(name[0]))
+    {
+    case wxT('m'):
+      if (name == wxT("munder")) return MathTag::munder;
+      if (name == wxT("mspace")) return MathTag::mspace;
+      break;
+    case wxT('o'):
+      if (name == wxT("output")) return MathTag::output;
+      break;
+    case wxT('e'):
+      if (name == wxT("editor")) return MathTag::editor;
+      break;
+    }
+    break;
+  case 13:
+    if (name == wxT("mmultiscripts")) return MathTag::mmultiscripts;
+    break;
+  }
+  return MathTag::unknown;
+}
+
+GroupTag GroupTagFromName(const wxString &name)
+{
+  switch (name.Length())
+  {
+  case 4:
+    if (name == wxT("code")) return GroupTag::code;
+    if (name == wxT("text")) return GroupTag::text;
+    break;
+  case 5:
+    if (name == wxT("image")) return GroupTag::image;
+    if (name == wxT("title")) return GroupTag::title;
+    break;
+  case 7:
+    if (name == wxT("section")) return GroupTag::section;
+    break;
+  case 8:
+    if (name == wxT("heading5")) return GroupTag::heading5;
+    if (name == wxT("heading6")) return GroupTag::heading6;
+    break;
+  case 9:
+    if (name == wxT("pagebreak")) return GroupTag::pagebreak;
+    break;
+  case 10:
+    if (name == wxT("subsection")) return GroupTag::subsection;
+    break;
+  case 13:
+    if (name == wxT("subsubsection")) return GroupTag::subsubsection;
+    break;
+  }
+  return GroupTag::unknown;
+}
@@ -0,0 +1,83 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the XML tag names MathParser knows about.
+ */
+
+#ifndef MATHTAGS_H
+#define MATHTAGS_H
+
+#include <wx/string.h>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*! The tags maxima and the .wxmx format use for math cells
+
+  The names are the XML tag names.
+ */
+enum class MathTag : uint8_t
+{
+  unknown,
+  v, mi, mo, t, n, mn, p, f, mfrac, e, msup, i, munder, fn, g, s, fnm, q, d, sm,
+  in, mspace, at, a, cj, ie, mmultiscripts, lm, r, mrow, tb, mth, line, lbl, st,
+  hl, h, img, slide, editor, cell, ascii, output, mtd, math,
+  count
+};
+
+//! The values the "type" attribute of a <cell> tag can have
+enum class GroupTag : uint8_t
+{
+  unknown,
+  code, image, pagebreak, text, title, section, subsection, subsubsection,
+  heading5, heading6,
+  count
+};
+
+/*! Returns the MathTag for an XML tag name, or MathTag::unknown
+
+  Switches over the name's length and first character and needs at most a
+  few string comparisons, which is cheaper than hashing the wide string.
+ */
+MathTag MathTagFromName(const wxString &name);
+//! Returns the GroupTag for a cell type, or GroupTag::unknown
+GroupTag GroupTagFromName(const wxString &name);
+
+//! An array with one entry per MathTag or GroupTag
+template <typename Tag, typename T>
+class TagTable
+{
+public:
+  T &operator[](Tag tag) { return m_entries[static_cast<std::size_t>(tag)]; }
+  const T &operator[](Tag tag) const { return m_entries[static_cast<std::size_t>(tag)]; }
+  //! True, if no entry has been set, yet
+  bool empty() const
+    {
+      return std::all_of(m_entries.begin(), m_entries.end(),
+                         [](const T &entry){ return entry == T(); });
+    }
+private:
+  std::array<T, static_cast<std::size_t>(Tag::count)> m_entries = {};
+};
+
+#endif // MATHTAGS_H
@@ -28,6 +28,11 @@
 */
 
 #include "MatrCell.h"
+#include "CellPointers.h"
+#include "GroupCell.h"
+#include "MathParser.h"
+#include "VisiblyInvalidCell.h"
+#include <algorithm>
 
 MatrCell::MatrCell(GroupCell *parent, Configuration **config) :
     Cell(parent, config)
@@ -48,7 +53,15 @@ MatrCell::MatrCell(const MatrCell &cell):
   m_matHeight = cell.m_matHeight;
   for (unsigned int i = 0; i < cell.m_matWidth * cell.m_matHeight; i++)
     if (i < cell.m_cells.size())
-      m_cells.emplace_back(cell.m_cells[i]->CopyList());
+    {
+      if (cell.m_cells[i])
+        m_cells.emplace_back(cell.m_cells[i]->CopyList());
+      else
+        m_cells.emplace_back();
+    }
+  m_entryXML = cell.m_entryXML;
+  m_estimatedLengths = cell.m_estimatedLengths;
+  m_estimatedRows = cell.m_estimatedRows;
 }
 
 std::unique_ptr<Cell> MatrCell::Copy() const
@@ -62,39 +75,44 @@ void MatrCell::Recalculate(AFontSize const fontsize)
     return;
 
   AFontSize const fontsize_entry{ MC_MIN_SIZE, fontsize - 2 };
-  for (unsigned int i = 0; i < m_cells.size(); i++)
-    m_cells[i]->RecalculateList(fontsize_entry);
-
-  m_width = 0;
-  m_widths.clear();
-  for (unsigned int i = 0; i < m_matWidth; i++)
-  {
-    int width = 0;
-    for (unsigned int j = 0; j < m_matHeight; j++)
-    {
-      if((m_matWidth * j + i)<m_cells.size())
-        width = wxMax(width, m_cells[m_matWidth * j + i]->GetFullWidth());
-    }
-    m_widths.emplace_back(width);
-    m_width += (width + Scale_Px(10));
-  }
-  if (m_width < Scale_Px(14))
-    m_width = Scale_Px(14);
-
-  m_height = 0;
-  m_dropCenters.clear();
+  for (auto const &cell : m_cells)
+    if (cell)
+      cell->RecalculateList(fontsize_entry);
+
+  // Entries that haven't been built, yet, get a size estimated from the length
+  // of their text. Draw() tells if the cell it builds needs more room.
+  m_widths.assign(m_matWidth, 0);
+  m_dropCenters.assign(m_matHeight, {});
+  int const charWidth = Scale_Px(0.6 * fontsize_entry.Get());
+  int const lineCenter = Scale_Px(0.6 * fontsize_entry.Get());
+  for (unsigned int j = 0; j < m_matWidth && j < m_estimatedLengths.size(); j++)
+    m_widths[j] = m_estimatedLengths[j] * charWidth;
+  for (unsigned int i = 0; i < m_matHeight && i < m_estimatedRows.size(); i++)
+    if (m_estimatedRows[i])
+      m_dropCenters[i] = DropCenter(lineCenter, lineCenter);
+
+  // Collect the column widths and row heights in one pass over the entries
   for (unsigned int i = 0; i < m_matHeight; i++)
-  {
-    int center = 0, drop = 0;
     for (unsigned int j = 0; j < m_matWidth; j++)
-      if(m_matWidth * i + j < m_cells.size())
+      if ((m_matWidth * i + j < m_cells.size()) && m_cells[m_matWidth * i + j])
       {
-        center = wxMax(center, m_cells[m_matWidth * i + j]->GetCenterList());
-        drop = wxMax(drop, m_cells[m_matWidth * i + j]->GetMaxDrop());
+        const Cell *cell = m_cells[m_matWidth * i + j].get();
+        m_widths[j] = wxMax(m_widths[j], cell->GetFullWidth());
+        m_dropCenters[i].center = wxMax(m_dropCenters[i].center, cell->GetCenterList());
+        m_dropCenters[i].drop = wxMax(m_dropCenters[i].drop, cell->GetMaxDrop());
       }
-    m_dropCenters.emplace_back(drop, center);
-    m_height += (center + drop + Scale_Px(10));
-  }
+
+  m_colOffsets.assign(1, 0);
+  for (auto width : m_widths)
+    m_colOffsets.emplace_back(m_colOffsets.back() + width + Scale_Px(10));
+  m_width = m_colOffsets.back();
+  if (m_width < Scale_Px(14))
+    m_width = Scale_Px(14);
+
+  m_rowOffsets.assign(1, 0);
+  for (auto const &dropCenter : m_dropCenters)
+    m_rowOffsets.emplace_back(m_rowOffsets.back() + dropCenter.Sum() + Scale_Px(10));
+  m_height = m_rowOffsets.back();
   if (m_height == 0)
     m_height = fontsize + Scale_Px(10);
   m_center = m_height / 2;
@@ -102,6 +120,19 @@ void MatrCell::Recalculate(AFontSize const fontsize)
   Cell::Recalculate(fontsize);
 }
 
+void MatrCell::VisibleRange(const std::vector<int> &offsets, int from, int to,
+                            unsigned int &first, unsigned int &last)
+{
+  first = last = 0;
+  if (offsets.size() < 2)
+    return;
+  // The first row that ends after from and the first one that starts after to
+  first = std::upper_bound(offsets.begin() + 1, offsets.end(), from) - (offsets.begin() + 1);
+  last = std::upper_bound(offsets.begin(), offsets.end() - 1, to) - offsets.begin();
+  if (last < first)
+    last = first;
+}
+
 void MatrCell::Draw(wxPoint point)
 {
   Cell::Draw(point);
@@ -109,24 +140,47 @@ void MatrCell::Draw(wxPoint point)
   {
     Configuration *configuration = (*m_configuration);
     wxDC *dc = configuration->GetDC();
-    wxPoint mp;
-    mp.x = point.x + Scale_Px(5);
-    mp.y = point.y - m_center;
-    for (unsigned int i = 0; i < m_matWidth; i++)
+    wxPoint origin(point.x + Scale_Px(5), point.y - m_center + Scale_Px(5));
+
+    // In a big matrix most entries are off-screen => draw only the rows and
+    // columns that intersect the region we are asked to redraw.
+    unsigned int firstCol = 0, lastCol = m_matWidth;
+    unsigned int firstRow = 0, lastRow = m_matHeight;
+    if (configuration->ClipToDrawRegion())
     {
-      mp.y = point.y - m_center + Scale_Px(5);
-      for (unsigned int j = 0; j < m_matHeight; j++)
-      {
-        if((j * m_matWidth + i) < m_cells.size())
+      wxRect region = configuration->GetUpdateRegion();
+      VisibleRange(m_colOffsets, region.GetLeft() - origin.x, region.GetRight() - origin.x,
+                   firstCol, lastCol);
+      VisibleRange(m_rowOffsets, region.GetTop() - origin.y, region.GetBottom() - origin.y,
+                   firstRow, lastRow);
+    }
+    AFontSize const fontsize_entry{ MC_MIN_SIZE, m_fontSize - 2 };
+    bool sizeChanged = false;
+    for (unsigned int i = firstCol; i < lastCol; i++)
+      for (unsigned int j = firstRow; j < lastRow; j++)
+        if ((j * m_matWidth + i) < m_cells.size())
+        {
+          Cell *cell;
+          if (IsUnbuilt(j * m_matWidth + i))
           {
-            mp.y += m_dropCenters[j].center;
-            wxPoint mp1(mp);
-            mp1.x = mp.x + (m_widths[i] - m_cells[j * m_matWidth + i]->GetFullWidth()) / 2;
-            m_cells[j * m_matWidth + i]->DrawList(mp1);
-            mp.y += (m_dropCenters[j].drop + Scale_Px(10));
+            cell = GetEntry(j * m_matWidth + i);
+            cell->RecalculateList(fontsize_entry);
+            if ((cell->GetFullWidth() > m_widths[i]) ||
+                (cell->GetCenterList() > m_dropCenters[j].center) ||
+                (cell->GetMaxDrop() > m_dropCenters[j].drop))
+              sizeChanged = true;
           }
-      }
-      mp.x += (m_widths[i] + Scale_Px(10));
+          else
+            cell = m_cells[j * m_matWidth + i].get();
+          wxPoint mp(origin.x + m_colOffsets[i] + (m_widths[i] - cell->GetFullWidth()) / 2,
+                     origin.y + m_rowOffsets[j] + m_dropCenters[j].center);
+          cell->DrawList(mp);
+        }
+    // The estimated size of an entry we just have built was too small
+    if (sizeChanged)
+    {
+      ResetSize();
+      GetCellPointers()->m_groupsToRecalculate.emplace_back(GetGroup());
     }
     SetPen(1.5);
     if (m_specialMatrix)
@@ -232,17 +286,81 @@ void MatrCell::Draw(wxPoint point)
 void MatrCell::AddNewCell(std::unique_ptr<Cell> &&cell)
 {
   m_cells.emplace_back(std::move(cell));
+  if (!m_entryXML.empty())
+    m_entryXML.emplace_back();
+}
+
+void MatrCell::AddNewEntry(const wxString &xml)
+{
+  m_entryXML.resize(m_cells.size());
+  m_cells.emplace_back();
+  m_entryXML.emplace_back(xml);
+}
+
+std::unique_ptr<Cell> MatrCell::ParseEntry(size_t index) const
+{
+  wxString xml = m_entryXML[index];
+  if (GetHighlight())
+    xml = wxT("<hl>") + xml + wxT("</hl>");
+  MathParser parser(m_configuration);
+  std::unique_ptr<Cell> cell(parser.ParseLine(wxT("<mth>") + xml + wxT("</mth>"), GetType()));
+  // The same the parser does for empty entries it parses right away
+  if (!cell)
+    cell = std::make_unique<VisiblyInvalidCell>(nullptr, m_configuration);
+  cell->SetGroupList(m_group);
+  return cell;
+}
+
+Cell *MatrCell::GetEntry(size_t index)
+{
+  if (IsUnbuilt(index))
+  {
+    m_cells[index] = ParseEntry(index);
+    wxString().swap(m_entryXML[index]);
+  }
+  return m_cells[index].get();
+}
+
+const Cell *MatrCell::GetEntry(size_t index, std::unique_ptr<Cell> &temporary) const
+{
+  if (!IsUnbuilt(index))
+    return m_cells[index].get();
+  temporary = ParseEntry(index);
+  return temporary.get();
+}
+
+int MatrCell::EstimatedLength(const wxString &xml)
+{
+  int length = 0;
+  bool inTag = false;
+  bool inEntity = false;
+  for (auto const &ch : xml)
+  {
+    if (inTag)
+      inTag = (ch != wxT('>'));
+    else if (ch == wxT('<'))
+      inTag = true;
+    else if (inEntity)
+      inEntity = (ch != wxT(';'));
+    else
+    {
+      inEntity = (ch == wxT('&'));
+      length++;
+    }
+  }
+  return length;
 }
 
 wxString MatrCell::ToString() const
 {
   wxString s = wxT("matrix(\n");
+  std::unique_ptr<Cell> temporary;
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
     s += wxT("\t\t[");
     for (unsigned int j = 0; j < m_matWidth; j++)
     {
-	  s += m_cells[i * m_matWidth + j]->ListToString();
+	  s += GetEntry(i * m_matWidth + j, temporary)->ListToString();
       if (j < m_matWidth - 1)
         s += wxT(",\t");
     }
@@ -261,11 +379,12 @@ wxString MatrCell::ToMatlab() const
 	wxString s;
 
 	s = wxT("[");
+	std::unique_ptr<Cell> temporary;
 	for (unsigned int i = 0; i < m_matHeight; i++)
 	{
 	  for (unsigned int j = 0; j < m_matWidth; j++)
 	  {
-		s += m_cells[i * m_matWidth + j]->ListToMatlab();
+		s += GetEntry(i * m_matWidth + j, temporary)->ListToMatlab();
 		if (j < m_matWidth - 1)
 		  s += wxT(", ");
 	  }
@@ -297,11 +416,12 @@ wxString MatrCell::ToTeX() const
       s += wxT("c");
     s += wxT("}");
   }
+  std::unique_ptr<Cell> temporary;
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
     for (unsigned int j = 0; j < m_matWidth; j++)
     {
-      s += m_cells[i * m_matWidth + j]->ListToTeX();
+      s += GetEntry(i * m_matWidth + j, temporary)->ListToTeX();
       if (j < m_matWidth - 1)
         s += wxT(" & ");
     }
@@ -327,11 +447,12 @@ wxString MatrCell::ToMathML() const
     retval = wxT("<mrow><mo>(</mo><mrow>");
   retval += wxT("<mtable>");
 
+  std::unique_ptr<Cell> temporary;
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
     retval += wxT("<mtr>");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      retval += wxT("<mtd>") + m_cells[i * m_matWidth + j]->ListToMathML() + wxT("</mtd>");
+      retval += wxT("<mtd>") + GetEntry(i * m_matWidth + j, temporary)->ListToMathML() + wxT("</mtd>");
     retval += wxT("</mtr>");
   }
   retval += wxT("</mtable>\n");
@@ -355,11 +476,12 @@ wxString MatrCell::ToOMML() const
   
   retval += wxT("<m:e><m:m>");
 
+  std::unique_ptr<Cell> temporary;
   for (unsigned int i = 0; i < m_matHeight; i++)
   {
     retval += wxT("<m:mr>");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      retval += wxT("<m:e>") + m_cells[i * m_matWidth + j]->ListToOMML() + wxT("</m:e>");
+      retval += wxT("<m:e>") + GetEntry(i * m_matWidth + j, temporary)->ListToOMML() + wxT("</m:e>");
     retval += wxT("</m:mr>");
   }
 
@@ -389,7 +511,10 @@ wxString MatrCell::ToXML() const
   {
     s += wxT("<mtr>");
     for (unsigned int j = 0; j < m_matWidth; j++)
-      s += wxT("<mtd>") + m_cells[i * m_matWidth + j]->ListToXML() + wxT("</mtd>");
+      if (IsUnbuilt(i * m_matWidth + j))
+        s += m_entryXML[i * m_matWidth + j];
+      else
+        s += wxT("<mtd>") + m_cells[i * m_matWidth + j]->ListToXML() + wxT("</mtd>");
     s += wxT("</mtr>");
   }
   s += wxT("</tb>");
@@ -401,4 +526,17 @@ void MatrCell::SetDimension()
 {
   if (m_matHeight != 0)
     m_matWidth = m_matWidth / m_matHeight;
+
+  if (m_entryXML.empty())
+    return;
+  m_estimatedLengths.assign(m_matWidth, 0);
+  m_estimatedRows.assign(m_matHeight, false);
+  for (unsigned int i = 0; i < m_matHeight; i++)
+    for (unsigned int j = 0; j < m_matWidth; j++)
+      if (IsUnbuilt(m_matWidth * i + j))
+      {
+        m_estimatedLengths[j] = wxMax(m_estimatedLengths[j],
+                                      EstimatedLength(m_entryXML[m_matWidth * i + j]));
+        m_estimatedRows[i] = true;
+      }
 }
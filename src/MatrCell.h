@@ -27,6 +27,17 @@
 
 #include <vector>
 
+/*! A matrix or a matrix-like element like the output of table_form
+
+  Draw() visits just the rows and columns that intersect the update region.
+  The first maxEagerEntries entries are parsed into cells right away. The
+  parser hands the rest to AddNewEntry() as XML, and Draw() builds their cells
+  when they are drawn for the first time. Until then Recalculate() estimates
+  the size of these entries from the length of their text. If a cell turns out
+  to be bigger than its estimate the GroupCell is laid out again, so both
+  memory and the time a frame takes depend on the visible part of the matrix,
+  not on its size.
+ */
 class MatrCell final : public Cell
 {
 public:
@@ -44,6 +55,15 @@ public:
   void Draw(wxPoint point) override;
 
   void AddNewCell(std::unique_ptr<Cell> &&cell);
+  /*! Adds an entry whose cell is only built when it is drawn for the first time
+
+    \param xml The entry's \<mtd\> element
+   */
+  void AddNewEntry(const wxString &xml);
+  //! The number of entries that have been added, yet
+  size_t GetEntries() const { return m_cells.size(); }
+  //! The parser adds the entries after these ones by AddNewEntry()
+  static constexpr size_t maxEagerEntries = 2500;
 
   void NewRow() { m_matHeight++; }
   void NewColumn() { m_matWidth++; }
@@ -83,11 +103,43 @@ private:
     constexpr DropCenter(int drop, int center) : drop(drop), center(center) {}
   };
 
-  //! Collection of pointers to inner cells.
+  /*! The rows (or columns) [first, last) that intersect the interval [from, to]
+
+    offsets are the ones from m_rowOffsets or m_colOffsets.
+   */
+  static void VisibleRange(const std::vector<int> &offsets, int from, int to,
+                           unsigned int &first, unsigned int &last);
+
+  //! Does entry number index only exist as XML?
+  bool IsUnbuilt(size_t index) const
+  { return (index < m_entryXML.size()) && !m_entryXML[index].IsEmpty(); }
+  //! Generates a cell for entry number index from its XML
+  std::unique_ptr<Cell> ParseEntry(size_t index) const;
+  //! Returns the cell for entry number index, building it if necessary
+  Cell *GetEntry(size_t index);
+  /*! Returns the cell for entry number index without keeping the cell it needs to build
+
+    \param temporary Holds the cell this function had to build
+   */
+  const Cell *GetEntry(size_t index, std::unique_ptr<Cell> &temporary) const;
+  //! The number of characters the XML of an entry displays, roughly
+  static int EstimatedLength(const wxString &xml);
+
+  //! Collection of pointers to inner cells. NULL for entries that aren't built, yet.
   std::vector<std::unique_ptr<Cell>> m_cells;
+  //! The XML of the entries whose cell isn't built, yet, and empty strings for the others
+  std::vector<wxString> m_entryXML;
+  //! For each column: The estimated length of the entries that were added as XML
+  std::vector<int> m_estimatedLengths;
+  //! For each row: Does it contain entries that were added as XML?
+  std::vector<bool> m_estimatedRows;
 
   std::vector<int> m_widths;
   std::vector<DropCenter> m_dropCenters;
+  //! The x offset of each column and, as the last element, the width of all columns
+  std::vector<int> m_colOffsets;
+  //! The y offset of each row and, as the last element, the height of all rows
+  std::vector<int> m_rowOffsets;
   CellPtr<Cell> m_nextToDraw;
 
   unsigned int m_matWidth = 0;
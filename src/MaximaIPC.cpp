@@ -84,18 +84,14 @@ static void LookupName(Val &val, const wxString &name, const T& names)
     val = it->second;
 }
 
-void MaximaIPC::ReadInputData(wxString &data)
+const wxString &MaximaIPC::GetPrefix() { return ipcPrefix; }
+
+const wxString &MaximaIPC::GetSuffix() { return ipcSuffix; }
+
+void MaximaIPC::ReadInputData(const wxString &xml)
 {
   if (!m_enabled)
     return;
-  if (!data.StartsWith(ipcPrefix))
-    return;
-  int end = m_wxMaxima->FindTagEnd(data, ipcSuffix);
-  if (end == wxNOT_FOUND)
-    return;
-  auto const ipcSize = end + ipcSuffix.size();
-  wxString xml = data.Left(ipcSize);
-  data.Remove(0, ipcSize);
 
   wxXmlDocument xmldoc;
   wxStringInputStream xmlStream(xml);
@@ -42,9 +42,16 @@ public:
    * etc.
    *
    * Since it may be unsafe, it must be enabled via command line.
+   *
+   * \param xml The complete tag, from \<ipc\> to \</ipc\>.
    */
-  void ReadInputData(wxString &data);
+  void ReadInputData(const wxString &xml);
   static void EnableIPC() { m_enabled = true; }
+  static bool IsEnabled() { return m_enabled; }
+  //! The marker the interprocess communication tag starts with
+  static const wxString &GetPrefix();
+  //! The marker the interprocess communication tag ends with
+  static const wxString &GetSuffix();
 
 private:
   wxMaxima *m_wxMaxima = nullptr;
@@ -0,0 +1,179 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class MaximaSocketReader that reads maxima's output
+  from the network socket.
+ */
+
+#include "MaximaSocketReader.h"
+#include <wx/stopwatch.h>
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t MaximaSocketReader::BLOCKSIZE;
+
+MaximaSocketReader::MaximaSocketReader(wxSocketBase *socket) :
+  m_socket(socket)
+{
+  m_buffer.resize(BLOCKSIZE + 4);
+}
+
+size_t MaximaSocketReader::ReadAvailable(wxString &output, size_t maxBytes)
+{
+  wxStopWatch stopwatch;
+  size_t bytesRead = 0;
+  m_moreDataPending = false;
+
+  while (m_socket->IsConnected() && m_socket->IsData())
+  {
+    char *const buffer = m_buffer.data();
+    m_socket->Read(buffer + m_carry, BLOCKSIZE);
+    size_t newBytes = m_socket->LastReadCount();
+    if (newBytes == 0)
+      break;
+    bytesRead += newBytes;
+
+    // Maxima sometimes sends NUL characters, and a EOT isn't meant to be displayed.
+    char *end = std::remove_if(buffer + m_carry, buffer + m_carry + newBytes,
+                               [](char ch){ return (ch == '\0') || (ch == '\x04'); });
+    size_t length = end - buffer;
+
+    // Decode everything but an incomplete UTF-8 sequence at the end of the block
+    // and move that sequence to the start of the buffer for the next read.
+    size_t tail = IncompleteUTF8Tail(buffer, length);
+    Decode(buffer, length - tail, output);
+    std::memmove(buffer, buffer + length - tail, tail);
+    m_carry = tail;
+
+    if (bytesRead >= maxBytes)
+    {
+      m_moreDataPending = true;
+      break;
+    }
+  }
+
+  m_bytesRead += bytesRead;
+  m_microsecondsSpent += stopwatch.TimeInMicro().GetValue();
+  return bytesRead;
+}
+
+double MaximaSocketReader::GetMBPerSecond() const
+{
+  // Below one millisecond of measurement the timer resolution makes the
+  // result meaningless.
+  if (m_microsecondsSpent < 1000)
+    return -1;
+  // Bytes per microsecond are megabytes per second.
+  return static_cast<double>(m_bytesRead) / m_microsecondsSpent;
+}
+
+size_t MaximaSocketReader::IncompleteUTF8Tail(const char *data, size_t length)
+{
+  for (size_t back = 1; (back <= 3) && (back <= length); back++)
+  {
+    unsigned char ch = data[length - back];
+    // A continuation byte: The start of the sequence is further in front.
+    if ((ch & 0xC0) == 0x80)
+      continue;
+    size_t sequenceLength = 1;
+    if (ch >= 0xF0)
+      sequenceLength = 4;
+    else if (ch >= 0xE0)
+      sequenceLength = 3;
+    else if (ch >= 0xC0)
+      sequenceLength = 2;
+    return (sequenceLength > back) ? back : 0;
+  }
+  return 0;
+}
+
+size_t MaximaSocketReader::UTF8SequenceLength(const char *data, size_t length)
+{
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  if (length == 0)
+    return 0;
+  if (bytes[0] < 0x80)
+    return 1;
+  size_t sequenceLength;
+  // The range the 2nd byte has to be in: Excludes overlong forms, surrogates
+  // and code points above U+10FFFF.
+  unsigned char min = 0x80;
+  unsigned char max = 0xBF;
+  if ((bytes[0] >= 0xC2) && (bytes[0] <= 0xDF))
+    sequenceLength = 2;
+  else if ((bytes[0] >= 0xE0) && (bytes[0] <= 0xEF))
+  {
+    sequenceLength = 3;
+    if (bytes[0] == 0xE0)
+      min = 0xA0;
+    if (bytes[0] == 0xED)
+      max = 0x9F;
+  }
+  else if ((bytes[0] >= 0xF0) && (bytes[0] <= 0xF4))
+  {
+    sequenceLength = 4;
+    if (bytes[0] == 0xF0)
+      min = 0x90;
+    if (bytes[0] == 0xF4)
+      max = 0x8F;
+  }
+  else
+    return 0;
+  if ((length < sequenceLength) || (bytes[1] < min) || (bytes[1] > max))
+    return 0;
+  for (size_t i = 2; i < sequenceLength; i++)
+    if ((bytes[i] & 0xC0) != 0x80)
+      return 0;
+  return sequenceLength;
+}
+
+void MaximaSocketReader::Decode(const char *data, size_t length, wxString &output)
+{
+  if (length == 0)
+    return;
+  wxString decoded = wxString::FromUTF8(data, length);
+  if (!decoded.IsEmpty())
+  {
+    output += decoded;
+    return;
+  }
+
+  // Invalid UTF-8 makes FromUTF8 fail completely. Most probably a lisp that
+  // doesn't speak UTF-8 has sent us 8-bit text => Decode the valid UTF-8
+  // sequences as UTF-8 and only the bytes between them as ISO-8859-1.
+  size_t start = 0;
+  while (start < length)
+  {
+    size_t end = start;
+    size_t sequenceLength;
+    while ((sequenceLength = UTF8SequenceLength(data + end, length - end)) > 0)
+      end += sequenceLength;
+    if (end > start)
+      output += wxString::FromUTF8(data + start, end - start);
+    if (end < length)
+    {
+      output += wxUniChar(static_cast<unsigned int>(static_cast<unsigned char>(data[end])));
+      end++;
+    }
+    start = end;
+  }
+}
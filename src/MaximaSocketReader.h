@@ -0,0 +1,92 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class MaximaSocketReader that reads maxima's output
+  from the network socket.
+ */
+
+#ifndef WXMAXIMA_MAXIMASOCKETREADER_H
+#define WXMAXIMA_MAXIMASOCKETREADER_H
+
+#include <wx/socket.h>
+#include <wx/string.h>
+#include <vector>
+
+/*! Reads maxima's output from the socket in big blocks
+
+  Pulling one wxChar at a time through a wxTextInputStream makes wxMaxima
+  stall if maxima outputs megabytes of data. This class instead drains the
+  socket into a reusable byte buffer and converts each block from UTF-8 only
+  once. A multi-byte sequence that has been split between two blocks is kept
+  at the start of the buffer until the rest of it arrives.
+ */
+class MaximaSocketReader
+{
+public:
+  explicit MaximaSocketReader(wxSocketBase *socket);
+
+  /*! Appends everything maxima has sent until now to output
+
+    \param output The string the decoded text is appended to
+    \param maxBytes Stop after reading this many bytes so the GUI stays responsive
+    \return The number of bytes that have been read from the socket
+  */
+  size_t ReadAvailable(wxString &output, size_t maxBytes = 1048576);
+
+  //! True, if the last ReadAvailable() stopped because it hit maxBytes
+  bool MoreDataPending() const { return m_moreDataPending; }
+
+  //! The number of bytes we have read since the last ResetStatistics()
+  long long GetBytesRead() const { return m_bytesRead; }
+  //! The number of microseconds spent reading and decoding since the last ResetStatistics()
+  long long GetMicrosecondsSpent() const { return m_microsecondsSpent; }
+  //! The read throughput in MB/s, or -1, if we don't have enough data for a guess
+  double GetMBPerSecond() const;
+  //! Restart the throughput statistics
+  void ResetStatistics() { m_bytesRead = 0; m_microsecondsSpent = 0; }
+
+private:
+  //! The number of bytes we try to read from the socket at once
+  static constexpr size_t BLOCKSIZE = 65536;
+  /*! Returns the number of bytes at the end of the buffer that belong to an
+      incomplete UTF-8 sequence
+   */
+  static size_t IncompleteUTF8Tail(const char *data, size_t length);
+  //! Returns the length of the valid UTF-8 sequence at the start of data, or 0
+  static size_t UTF8SequenceLength(const char *data, size_t length);
+  /*! Converts length bytes from the buffer, tolerating invalid UTF-8
+
+    Bytes that aren't part of a valid UTF-8 sequence are read as ISO-8859-1.
+   */
+  static void Decode(const char *data, size_t length, wxString &output);
+
+  wxSocketBase *m_socket;
+  //! The buffer we read into. Only grows, and is re-used for every read.
+  std::vector<char> m_buffer;
+  //! Bytes of an incomplete UTF-8 sequence at the start of m_buffer
+  size_t m_carry = 0;
+  bool m_moreDataPending = false;
+  long long m_bytesRead = 0;
+  long long m_microsecondsSpent = 0;
+};
+
+#endif // WXMAXIMA_MAXIMASOCKETREADER_H
@@ -29,10 +29,149 @@
 #include "MaximaTokenizer.h"
 #include <wx/wx.h>
 #include <wx/string.h>
+#include <algorithm>
 #include <vector>
 
+//! How many chars the tokenizer reads after a ":" in order to find out if it is a ":lisp"
+static constexpr size_t lispCommandLookahead = 14;
 
 MaximaTokenizer::MaximaTokenizer(wxString commands, Configuration *configuration)
+{
+  InitHardcodedFunctions();
+
+  // ----------------------------------------------------------------
+  // --------------------- Step one:                -----------------
+  // --------------------- Break a line into tokens -----------------
+  // ----------------------------------------------------------------
+  wxString::const_iterator it = commands.begin();
+      
+  if(configuration->InLispMode())
+  {
+    wxString token;
+    while(
+      (it < commands.end()) &&
+      ((!token.EndsWith("(to-maxima)"))) &&
+      ((!token.EndsWith(wxString("(to")+wxT("\u2212")+"maxima)"))))
+    {
+      token +=*it;
+      ++it;
+    }
+    token.Trim(true);
+    if(!token.IsEmpty())
+      m_tokens.emplace_back(token, TS_CODE_LISP);
+  }
+  Tokenize(commands, it, configuration);
+}
+
+MaximaTokenizer::MaximaTokenizer(wxString commands, Configuration *configuration,
+                                 const wxString &oldCommands, TokenList &&oldTokens)
+{
+  InitHardcodedFunctions();
+
+  // In lisp mode the first token is shorter than the text it was made from
+  // which means we cannot tell where the other tokens start.
+  if (configuration->InLispMode() || oldTokens.empty())
+  {
+    m_tokens = MaximaTokenizer(commands, configuration).PopTokens();
+    return;
+  }
+
+  // Where does each of the old tokens start?
+  std::vector<size_t> oldStarts;
+  oldStarts.reserve(oldTokens.size());
+  size_t oldLength = 0;
+  for (auto const &token : oldTokens)
+  {
+    oldStarts.push_back(oldLength);
+    oldLength += token.GetText().Length();
+  }
+  if (oldLength != oldCommands.Length())
+  {
+    m_tokens = MaximaTokenizer(commands, configuration).PopTokens();
+    return;
+  }
+
+  // Which part of the text has changed?
+  size_t newLength = commands.Length();
+  size_t prefix = 0;
+  {
+    wxString::const_iterator oldIt = oldCommands.begin();
+    wxString::const_iterator newIt = commands.begin();
+    while ((oldIt != oldCommands.end()) && (newIt != commands.end()) && (*oldIt == *newIt))
+    {
+      ++oldIt;
+      ++newIt;
+      ++prefix;
+    }
+  }
+  if ((prefix == oldLength) && (prefix == newLength))
+  {
+    m_tokens = std::move(oldTokens);
+    return;
+  }
+  size_t suffix = 0;
+  {
+    size_t maxSuffix = std::min(oldLength, newLength) - prefix;
+    wxString::const_iterator oldIt = oldCommands.end();
+    wxString::const_iterator newIt = commands.end();
+    while (suffix < maxSuffix)
+    {
+      --oldIt;
+      --newIt;
+      if (*oldIt != *newIt)
+        break;
+      ++suffix;
+    }
+  }
+
+  // Lexing restarts at the token the first changed char belongs to - or
+  // earlier, if a token before it looks ahead into the change: Names look past
+  // whitespace for a "(" that makes them a function and ":" looks for ":lisp".
+  // Strings and comments are single tokens => We never restart inside them.
+  size_t restart = 0;
+  if (prefix > 0)
+    restart = std::upper_bound(oldStarts.begin(), oldStarts.end(), prefix - 1) - oldStarts.begin() - 1;
+  while ((restart > 0) &&
+         (IsWhitespace(oldTokens[restart]) || (oldStarts[restart - 1] + lispCommandLookahead > prefix)))
+    restart--;
+
+  // From the end of the change on the old and the new text are identical. The
+  // tokenizer doesn't look back => once a new token starts where an old one
+  // did all following tokens will be the same as before.
+  size_t changeEnd = newLength - suffix;
+  size_t resync = oldTokens.size();
+  auto isSyncPoint = [&](size_t pos) {
+    if (pos < changeEnd)
+      return false;
+    size_t oldPos = pos + oldLength - newLength;
+    // A name that ends in a line continuation is followed by an empty token
+    // that starts where the next token does. We have already re-created that
+    // one => pick the last token that starts at oldPos.
+    auto next = std::upper_bound(oldStarts.begin() + restart, oldStarts.end(), oldPos);
+    if ((next == oldStarts.begin() + restart) || (*(next - 1) != oldPos))
+      return false;
+    resync = next - 1 - oldStarts.begin();
+    return true;
+  };
+  Tokenize(commands, commands.begin() + oldStarts[restart], configuration,
+           oldStarts[restart], isSyncPoint);
+
+  // Splice the new tokens into the old ones
+  TokenList relexed = std::move(m_tokens);
+  m_tokens.clear();
+  m_tokens.reserve(restart + relexed.size() + oldTokens.size() - resync);
+  std::move(oldTokens.begin(), oldTokens.begin() + restart, std::back_inserter(m_tokens));
+  std::move(relexed.begin(), relexed.end(), std::back_inserter(m_tokens));
+  std::move(oldTokens.begin() + resync, oldTokens.end(), std::back_inserter(m_tokens));
+}
+
+bool MaximaTokenizer::IsWhitespace(const Token &token)
+{
+  const wxString &text = token.GetText();
+  return text.IsEmpty() || IsSpace(text[0]) || (m_linebreaks.Find(text[0]) != wxNOT_FOUND);
+}
+
+void MaximaTokenizer::InitHardcodedFunctions()
 {
   if(m_hardcodedFunctions.empty())
   {
@@ -55,30 +194,24 @@ MaximaTokenizer::MaximaTokenizer(wxString commands, Configuration *configuration
     m_hardcodedFunctions["true"] = 1;
     m_hardcodedFunctions["false"] = 1;
   }
-  
-  // ----------------------------------------------------------------
-  // --------------------- Step one:                -----------------
-  // --------------------- Break a line into tokens -----------------
-  // ----------------------------------------------------------------
-  wxString::const_iterator it = commands.begin();
-      
-  if(configuration->InLispMode())
+}
+
+void MaximaTokenizer::Tokenize(const wxString &commands, wxString::const_iterator it,
+                               Configuration *configuration, size_t pos,
+                               const std::function<bool(size_t pos)> &isSyncPoint)
+{
+  // The tokens we haven't added to pos, yet
+  size_t counted = m_tokens.size();
+  while (it < commands.end())
   {
-    wxString token;
-    while(
-      (it < commands.end()) &&
-      ((!token.EndsWith("(to-maxima)"))) &&
-      ((!token.EndsWith(wxString("(to")+wxT("\u2212")+"maxima)"))))
+    if (isSyncPoint)
     {
-      token +=*it;
-      ++it;
+      for (; counted < m_tokens.size(); ++counted)
+        pos += m_tokens[counted].GetText().Length();
+      if (isSyncPoint(pos))
+        break;
     }
-    token.Trim(true);
-    if(!token.IsEmpty())
-      m_tokens.emplace_back(token, TS_CODE_LISP);
-  }
-  while (it < commands.end())
-  {
+
     // Determine the current char and the one that will follow it
     wxChar Ch = *it;
     wxString::const_iterator it2(it);
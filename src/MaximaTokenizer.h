@@ -31,6 +31,7 @@
 #include "Configuration.h"
 #include <vector>
 #include <memory>
+#include <functional>
 
 /*!\file
 
@@ -80,7 +81,35 @@ public:
   MaximaTokenizer(wxString commands, Configuration *configuration,
                   const TokenList &initialTokens);
 
+  /*! A constructor that only re-tokenizes the part of the text that has changed
+
+    \param commands The new text
+    \param configuration The configuration. Must be the same as for oldTokens.
+    \param oldCommands The text oldTokens has been made from
+    \param oldTokens The tokens for oldCommands. Unchanged tokens are moved from here.
+
+    Tokenizing starts again at the last token that cannot have been influenced by
+    the change and stops as soon as a new token starts at a place in the unchanged
+    end of the text an old token started at. The result is the same as tokenizing
+    all of commands.
+  */
+  MaximaTokenizer(wxString commands, Configuration *configuration,
+                  const wxString &oldCommands, TokenList &&oldTokens);
+
 protected:
+  /*! Breaks commands into tokens, starting at the char it points to
+
+    \param pos The position it points to. Only needed if isSyncPoint is set.
+    \param isSyncPoint Called before each token with the position the token
+    would start at. If it returns true we stop tokenizing.
+  */
+  void Tokenize(const wxString &commands, wxString::const_iterator it,
+                Configuration *configuration, size_t pos = 0,
+                const std::function<bool(size_t pos)> &isSyncPoint = {});
+  //! Fills m_hardcodedFunctions, if this hasn't been done before
+  static void InitHardcodedFunctions();
+  //! True if token is a space or a line break
+  static bool IsWhitespace(const Token &token);
   //! The tokens the string is divided into
   TokenList m_tokens;
   //! ASCII symbols that wxIsalnum() doesn't see as chars, but maxima does.
@@ -0,0 +1,154 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#include "RenderTimings.h"
+#include <wx/intl.h>
+#include <wx/thread.h>
+#include <wx/wfstream.h>
+#include <wx/txtstrm.h>
+#include <chrono>
+
+constexpr size_t RenderTimings::bufferSize;
+std::atomic<bool> RenderTimings::m_enabled(false);
+
+RenderTimings::RenderTimings() :
+  m_events(bufferSize),
+  m_written(0)
+{
+}
+
+RenderTimings &RenderTimings::Get()
+{
+  static RenderTimings timings;
+  return timings;
+}
+
+int64_t RenderTimings::Now()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+wxString RenderTimings::GetName(Section section)
+{
+  switch (section)
+  {
+  case paint:
+    return wxT("Worksheet::OnPaint");
+  case layout:
+    return wxT("Worksheet::RecalculateIfNeeded");
+  case drawGroup:
+    return wxT("GroupCell::Draw");
+  case parse:
+    return wxT("MathParser::ParseLine");
+  default:
+    return wxT("?");
+  }
+}
+
+void RenderTimings::Record(Section section, int64_t start, int64_t end)
+{
+  Event &event = m_events[m_written.fetch_add(1, std::memory_order_relaxed) % bufferSize];
+  event.start = start;
+  event.duration = end - start;
+  event.thread = wxThread::GetCurrentId();
+  event.section = section;
+}
+
+void RenderTimings::Clear()
+{
+  m_written = 0;
+}
+
+std::vector<RenderTimings::Event> RenderTimings::GetEvents() const
+{
+  size_t written = m_written.load(std::memory_order_relaxed);
+  size_t count = wxMin(written, bufferSize);
+  std::vector<Event> events;
+  events.reserve(count);
+  for (size_t i = written - count; i < written; i++)
+    events.push_back(m_events[i % bufferSize]);
+  return events;
+}
+
+wxString RenderTimings::GetSummary() const
+{
+  struct Statistics
+  {
+    int64_t last = 0;
+    int64_t sum = 0;
+    int64_t max = 0;
+    long count = 0;
+  };
+  Statistics statistics[numberOfSections];
+  for (auto const &event : GetEvents())
+  {
+    Statistics &stat = statistics[event.section];
+    stat.last = event.duration;
+    stat.sum += event.duration;
+    stat.max = wxMax(stat.max, event.duration);
+    stat.count++;
+  }
+
+  wxString summary;
+  for (int section = 0; section < numberOfSections; section++)
+  {
+    Statistics const &stat = statistics[section];
+    if (stat.count == 0)
+      continue;
+    if (!summary.IsEmpty())
+      summary += wxT("\n");
+    summary += wxString::Format(_("%s: last %.1f ms, average %.1f ms, max %.1f ms (%li calls)"),
+                                GetName(static_cast<Section>(section)),
+                                stat.last / 1000.0,
+                                stat.sum / 1000.0 / stat.count,
+                                stat.max / 1000.0,
+                                stat.count);
+  }
+  return summary;
+}
+
+bool RenderTimings::WriteChromeTrace(const wxString &file) const
+{
+  wxFileOutputStream output(file);
+  if (!output.IsOk())
+    return false;
+  wxTextOutputStream text(output);
+
+  text << wxT("{\"traceEvents\":[\n");
+  bool first = true;
+  for (auto const &event : GetEvents())
+  {
+    if (!first)
+      text << wxT(",\n");
+    first = false;
+    // Complete events ("ph":"X") carry their start and duration in microseconds
+    text << wxString::Format(
+      wxT("{\"name\":\"%s\",\"cat\":\"wxMaxima\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%lu}"),
+      GetName(event.section),
+      static_cast<long long>(event.start),
+      static_cast<long long>(event.duration),
+      event.thread);
+  }
+  text << wxT("\n]}\n");
+  text.Flush();
+  return output.IsOk() && output.Close();
+}
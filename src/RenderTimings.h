@@ -0,0 +1,124 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#ifndef RENDERTIMINGS_H
+#define RENDERTIMINGS_H
+
+#include "precomp.h"
+#include <wx/string.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/*! \file
+ * This file declares the class that records how long drawing, layout and parsing take.
+ */
+
+/*! Records how long the hot paths of drawing, layout and parsing take
+
+  Tells if a slow worksheet is slow because of the layout, the drawing or
+  the parsing of maxima's output. While disabled a Scope costs one check of
+  an atomic flag.
+
+  The measurements are kept in a ring buffer that holds the last bufferSize of
+  them. Recording one only takes one atomic increment of the write position
+  and therefore doesn't need a lock. Reading the buffer while another thread
+  writes to it might yield a garbled entry, which is acceptable for debug
+  output: Currently all measured sections run in the GUI thread, anyway.
+ */
+class RenderTimings final
+{
+public:
+  //! The parts of wxMaxima we measure
+  enum Section
+  {
+    paint,       //!< Worksheet::OnPaint()
+    layout,      //!< Worksheet::RecalculateIfNeeded()
+    drawGroup,   //!< GroupCell::Draw()
+    parse,       //!< MathParser::ParseLine()
+    numberOfSections
+  };
+
+  //! Measures the time between its creation and its destruction
+  class Scope
+  {
+  public:
+    explicit Scope(Section section) :
+      m_section(section),
+      m_start(Enabled() ? Now() : -1)
+      {}
+    ~Scope()
+      {
+        if (m_start >= 0)
+          Get().Record(m_section, m_start, Now());
+      }
+  private:
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    Section m_section;
+    int64_t m_start;
+  };
+
+  static RenderTimings &Get();
+  //! Are timings being recorded?
+  static bool Enabled() { return m_enabled.load(std::memory_order_relaxed); }
+  //! Start or stop recording timings
+  static void Enable(bool enable) { m_enabled.store(enable, std::memory_order_relaxed); }
+  //! The current time in microseconds
+  static int64_t Now();
+  //! The name a section is shown as
+  static wxString GetName(Section section);
+
+  //! Add a measurement to the ring buffer
+  void Record(Section section, int64_t start, int64_t end);
+  //! Forget all measurements
+  void Clear();
+  //! One line per section with the last, the average and the maximum duration
+  wxString GetSummary() const;
+  /*! Saves all measurements in the "Trace Event Format" chrome://tracing understands
+
+    \return false, if the file could not be written.
+   */
+  bool WriteChromeTrace(const wxString &file) const;
+
+private:
+  static constexpr size_t bufferSize = 16384;
+  RenderTimings();
+  RenderTimings(const RenderTimings &) = delete;
+  RenderTimings &operator=(const RenderTimings &) = delete;
+
+  struct Event
+  {
+    int64_t start = 0;
+    int64_t duration = 0;
+    unsigned long thread = 0;
+    Section section = paint;
+  };
+  //! Returns a copy of the measurements in the ring buffer, oldest first
+  std::vector<Event> GetEvents() const;
+
+  static std::atomic<bool> m_enabled;
+  std::vector<Event> m_events;
+  //! How many events have been recorded since the last Clear()
+  std::atomic<size_t> m_written;
+};
+
+#endif // RENDERTIMINGS_H
@@ -0,0 +1,132 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file defines the class SearchIndex that Find/Replace searches the worksheet with.
+ */
+
+#include "SearchIndex.h"
+#include <algorithm>
+
+std::uint32_t SearchIndex::TrigramHash(const wxString &text, size_t pos)
+{
+  std::uint32_t hash = 2166136261u;
+  for (size_t i = pos; i < pos + 3; i++)
+    hash = (hash ^ static_cast<std::uint32_t>(Folded(text[i]).GetValue())) * 16777619u;
+  return hash;
+}
+
+SearchIndex::Entry &SearchIndex::Update(const EditorCell *cell, unsigned long revision,
+                                        const wxString &text)
+{
+  Entry &entry = m_entries[cell];
+  entry.sweep = m_sweep;
+  // Comparing the lengths is cheap and protects against a change that hasn't
+  // led to a new revision.
+  if ((entry.revision == revision) && (entry.length == text.Length()))
+    return entry;
+
+  entry.revision = revision;
+  entry.length = text.Length();
+  entry.trigrams.clear();
+  if (text.Length() >= 3)
+  {
+    entry.trigrams.reserve(text.Length() - 2);
+    for (size_t pos = 0; pos + 3 <= text.Length(); pos++)
+      entry.trigrams.push_back((static_cast<std::uint64_t>(TrigramHash(text, pos)) << 32) | pos);
+    std::sort(entry.trigrams.begin(), entry.trigrams.end());
+  }
+  return entry;
+}
+
+void SearchIndex::Find(const EditorCell *cell, unsigned long revision, const wxString &text,
+                       const wxString &str, bool ignoreCase, std::vector<size_t> &starts)
+{
+  starts.clear();
+  Entry &entry = Update(cell, revision, text);
+  if (str.IsEmpty() || (str.Length() > text.Length()))
+    return;
+
+  wxString lowerStr = str;
+  lowerStr.MakeLower();
+
+  // Does the text at pos match str?
+  auto matches = [&](size_t pos) {
+    for (size_t i = 0; i < str.Length(); i++)
+    {
+      wxUniChar ch = text[pos + i];
+      if (ignoreCase ? (Folded(ch) != lowerStr[i]) :
+          (((ch == wxT('\r')) ? wxUniChar(wxT(' ')) : ch) != str[i]))
+        return false;
+    }
+    return true;
+  };
+
+  // Strings this short will be found nearly everywhere => A linear scan is as fast.
+  if (lowerStr.Length() < 3)
+  {
+    for (size_t pos = 0; pos + lowerStr.Length() <= text.Length(); pos++)
+      if (matches(pos))
+        starts.push_back(pos);
+    return;
+  }
+
+  // Find the trigram of str that occurs the least often in the text
+  auto rarest = std::make_pair(entry.trigrams.end(), entry.trigrams.end());
+  size_t rarestOffset = 0;
+  for (size_t offset = 0; offset + 3 <= lowerStr.Length(); offset++)
+  {
+    std::uint64_t hash = static_cast<std::uint64_t>(TrigramHash(lowerStr, offset)) << 32;
+    auto range = std::make_pair(
+      std::lower_bound(entry.trigrams.begin(), entry.trigrams.end(), hash),
+      std::lower_bound(entry.trigrams.begin(), entry.trigrams.end(), hash + (std::uint64_t(1) << 32)));
+    if (range.first == range.second)
+      return;
+    if ((offset == 0) || (range.second - range.first < rarest.second - rarest.first))
+    {
+      rarest = range;
+      rarestOffset = offset;
+    }
+  }
+
+  // The positions are sorted => so are the matches.
+  for (auto it = rarest.first; it != rarest.second; ++it)
+  {
+    size_t pos = static_cast<size_t>(*it & 0xFFFFFFFFu);
+    if (pos < rarestOffset)
+      continue;
+    pos -= rarestOffset;
+    if ((pos + lowerStr.Length() <= text.Length()) && matches(pos))
+      starts.push_back(pos);
+  }
+}
+
+void SearchIndex::EndSweep()
+{
+  for (auto it = m_entries.begin(); it != m_entries.end();)
+  {
+    if (it->second.sweep != m_sweep)
+      it = m_entries.erase(it);
+    else
+      ++it;
+  }
+}
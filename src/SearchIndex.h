@@ -0,0 +1,104 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+/*! \file
+  This file declares the class SearchIndex that Find/Replace searches the worksheet with.
+ */
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <wx/string.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class EditorCell;
+
+/*! An index of the text of all EditorCells of a worksheet
+
+  Searching every cell for a string with a linear scan means that "find next"
+  in a big worksheet reads every cell, and that counting or highlighting all
+  matches does so once per cell and redraw. This index remembers the positions
+  of all trigrams (groups of 3 consecutive chars) of the lower-case text of each
+  cell, but not the text itself. A search looks up the rarest trigram of the
+  search string and only compares the text at the places that trigram occurs at.
+
+  The index of a cell is updated the next time the cell is searched in after
+  its text has changed. Cells are identified by their address and
+  EditorCell::GetTextRevision(), which no two texts share. This means that a
+  deleted cell's index is never used for a new cell at the same address and
+  that finding out if a cell has changed doesn't need to compare its text.
+  Entries no search has asked for since the last StartSweep() are removed by
+  EndSweep().
+ */
+class SearchIndex
+{
+public:
+  /*! Finds all places str occurs at in the text of a cell
+
+    \param cell The cell the text belongs to
+    \param revision The cell's EditorCell::GetTextRevision()
+    \param text The text of the cell
+    \param str The string to search for
+    \param ignoreCase true = Case-insensitive search
+    \param starts Receives the positions of all matches in ascending order.
+           Matches may overlap.
+  */
+  void Find(const EditorCell *cell, unsigned long revision, const wxString &text,
+            const wxString &str, bool ignoreCase, std::vector<size_t> &starts);
+
+  //! Start recording which cells are searched in
+  void StartSweep() { m_sweep++; }
+  //! Forget about all cells that haven't been searched in since StartSweep()
+  void EndSweep();
+  //! Forget about all cells
+  void Clear() { m_entries.clear(); }
+  //! The number of cells we hold an index for
+  size_t GetSize() const { return m_entries.size(); }
+
+private:
+  struct Entry
+  {
+    //! The revision of the text the index was made from
+    unsigned long revision = 0;
+    //! The length of the text the index was made from
+    size_t length = 0;
+    //! The hash of each trigram in the upper and its position in the lower half, sorted
+    std::vector<std::uint64_t> trigrams;
+    //! The value of m_sweep at the time this entry has last been used
+    unsigned long sweep = 0;
+  };
+
+  //! Returns the index for text, after updating it, if necessary
+  Entry &Update(const EditorCell *cell, unsigned long revision, const wxString &text);
+  //! A char as Find() compares it: Soft line breaks are spaces and all chars are lower case
+  static wxUniChar Folded(wxUniChar ch)
+    { return (ch == wxT('\r')) ? wxUniChar(wxT(' ')) : wxUniChar(wxTolower(ch)); }
+  //! The hash of the folded trigram that starts at pos
+  static std::uint32_t TrigramHash(const wxString &text, size_t pos);
+
+  std::unordered_map<const EditorCell *, Entry> m_entries;
+  unsigned long m_sweep = 0;
+};
+
+#endif // SEARCHINDEX_H
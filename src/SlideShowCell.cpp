@@ -47,13 +47,13 @@
 #include <wx/wfstream.h>
 #include <wx/anidecod.h>
 
-// filesystem cannot be passed by const reference as we want to keep the
-// pointer to the file system alive in a background task
-// cppcheck-suppress performance symbolName=filesystem
-SlideShow::SlideShow(GroupCell *parent, Configuration **config, std::shared_ptr <wxFileSystem> filesystem, int framerate) :
+// archive cannot be passed by const reference as we want to keep the
+// pointer to the archive alive in a background task
+// cppcheck-suppress performance symbolName=archive
+SlideShow::SlideShow(GroupCell *parent, Configuration **config, std::shared_ptr<ZipIndex> archive, int framerate) :
     Cell(parent, config),
     m_timer(m_cellPointers->GetWorksheet(), wxNewId()),
-    m_fileSystem(filesystem),
+    m_archive(archive),
     m_framerate(framerate),
     m_imageBorderWidth(Scale_Px(1))
 {
@@ -134,10 +134,12 @@ void SlideShow::AnimationRunning(bool run)
   else
     StopTimer();
   m_animationRunning = run;
+  m_cellPointers->XMLChanged(this);
 }
 
 int SlideShow::SetFrameRate(int Freq)
 {
+  m_cellPointers->XMLChanged(this);
 
   m_framerate = Freq;
 
@@ -207,7 +209,7 @@ void SlideShow::LoadImages(wxArrayString images, bool deleteRead)
         else
         {
           m_images.push_back(
-            std::make_shared<Image>(m_configuration, images[i], m_fileSystem, deleteRead));
+            std::make_shared<Image>(m_configuration, images[i], m_archive, deleteRead));
           if(gnuplotFilename != wxEmptyString)
           {
             if(m_images.back())
@@ -217,7 +219,7 @@ void SlideShow::LoadImages(wxArrayString images, bool deleteRead)
         }
       }
     }
-  m_fileSystem = NULL;
+  m_archive = NULL;
   m_displayed = 0;
 }
 
@@ -248,6 +250,7 @@ void SlideShow::SetDisplayedIndex(int ind)
     m_displayed = ind;
   else
     m_displayed = m_size - 1;
+  m_cellPointers->XMLChanged(this);
 }
 
 void SlideShow::Recalculate(AFontSize fontsize)
@@ -390,10 +393,7 @@ wxString SlideShow::ToXML() const
         wxMemoryBuffer data = m_images[i]->GetGnuplotSource();
         if(data.GetDataLen() > 0)
         {
-          wxMemoryFSHandler::AddFile(gnuplotSource,
-                                     data.GetData(),
-                                     data.GetDataLen()
-            );
+          m_cellPointers->WXMXAddFile(gnuplotSource, data);
         }
       }
       if(gnuplotData != wxEmptyString)
@@ -402,18 +402,13 @@ wxString SlideShow::ToXML() const
         wxMemoryBuffer data = m_images[i]->GetGnuplotData();
         if(data.GetDataLen() > 0)
         {
-          wxMemoryFSHandler::AddFile(gnuplotData,
-                                     data.GetData(),
-                                     data.GetDataLen()
-            );
+          m_cellPointers->WXMXAddFile(gnuplotData, data);
         }
       }
       
       if (m_images[i]->GetCompressedImage())
-        wxMemoryFSHandler::AddFile(basename + m_images[i]->GetExtension(),
-                                   m_images[i]->GetCompressedImage().GetData(),
-                                   m_images[i]->GetCompressedImage().GetDataLen()
-        );
+        m_cellPointers->WXMXAddFile(basename + m_images[i]->GetExtension(),
+                                    m_images[i]->GetCompressedImage());
     }
 
     images += basename + m_images[i]->GetExtension() + wxT(";");
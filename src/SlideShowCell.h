@@ -51,11 +51,11 @@ public:
     has to be set to -1.
     \param config A pointer to the pointer to the configuration storage of the 
                   worksheet this cell belongs to.
-    \param filesystem The filesystem the contents of this slideshow can be found in.
+    \param archive   The .wxmx file the contents of this slideshow can be found in.
                       NULL = the operating system's filesystem
     \param parent     The parent GroupCell this cell belongs to.
    */
-  SlideShow(GroupCell *parent, Configuration **config, std::shared_ptr<wxFileSystem> filesystem, int framerate = -1);
+  SlideShow(GroupCell *parent, Configuration **config, std::shared_ptr<ZipIndex> archive, int framerate = -1);
   SlideShow(GroupCell *parent, Configuration **config, int framerate = -1);
   SlideShow(const SlideShow &cell);
   //! A constructor that loads the compressed file from a wxMemoryBuffer
@@ -149,8 +149,8 @@ public:
   bool CanPopOut() const override
   { return (!m_images[m_displayed]->GnuplotSource().empty()); }
 
-  void GnuplotSource(int image, wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<wxFileSystem> filesystem)
-  { m_images[image]->GnuplotSource(gnuplotFilename, dataFilename, filesystem); }
+  void GnuplotSource(int image, wxString gnuplotFilename, wxString dataFilename, std::shared_ptr<ZipIndex> archive)
+  { m_images[image]->GnuplotSource(gnuplotFilename, dataFilename, archive); }
 
   wxString GnuplotSource() const override
   {
@@ -177,7 +177,7 @@ public:
 private:
   wxTimer m_timer;
   std::vector<std::shared_ptr<Image>> m_images;
-  std::shared_ptr<wxFileSystem> m_fileSystem;
+  std::shared_ptr<ZipIndex> m_archive;
   CellPtr<Cell> m_nextToDraw;
 
   /*! The framerate of this cell.
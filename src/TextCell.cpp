@@ -30,6 +30,7 @@
 
 #include "TextCell.h"
 #include "StringUtils.h"
+#include "TextExtentCache.h"
 #include "wx/config.h"
 
 TextCell::TextCell(GroupCell *parent, Configuration **config,
@@ -316,13 +317,14 @@ bool TextCell::NeedsRecalculation(AFontSize fontSize) const
   return Cell::NeedsRecalculation(fontSize);
 }
 
-wxSize TextCell::GetTextSize(wxDC *const dc, const wxString &text, TextCell::TextIndex const index)
+wxSize TextCell::GetTextSize(wxDC *const dc, const Style &style, const wxString &text,
+                             TextCell::TextIndex const index)
 {
   AFontSize const fontSize = GetScaledTextSize();
   if (text.empty())
     return {};
 
-  auto const size = dc->GetTextExtent(text);
+  auto const size = TextExtentCache::GetATextExtent(dc, style, text);
   m_sizeCache.emplace_back(size, fontSize, index);
   return size;
 }
@@ -379,10 +381,9 @@ void TextCell::Recalculate(AFontSize fontsize)
   {      
     Cell::Recalculate(fontsize);
     m_fontSize = fontsize;
-    SetFont(fontsize);
+    auto const style = SetFont(fontsize);
 
-
-    wxSize sz = GetTextSize((*m_configuration)->GetDC(), m_displayedText, cellText);
+    wxSize sz = GetTextSize((*m_configuration)->GetDC(), style, m_displayedText, cellText);
     m_width = sz.GetWidth();
     m_height = sz.GetHeight();
     
@@ -423,7 +424,7 @@ void TextCell::Draw(wxPoint point)
   }
 }
 
-void TextCell::SetFont(AFontSize fontsize)
+Style TextCell::SetFont(AFontSize fontsize)
 {
   Configuration *configuration = (*m_configuration);
   wxDC *dc = configuration->GetDC();
@@ -465,6 +466,7 @@ void TextCell::SetFont(AFontSize fontsize)
   style.SetFontSize(Scale_Px(m_fontSize));
 
   dc->SetFont(style.GetFont());
+  return style;
 }
 
 bool TextCell::IsOperator() const
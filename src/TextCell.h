@@ -52,7 +52,8 @@ public:
 
   virtual void Draw(wxPoint point) override;
 
-  void SetFont(AFontSize fontsize);
+  //! Sets the DC's font for this cell and returns the style the font was made from
+  Style SetFont(AFontSize fontsize);
 
   /*! Calling this function signals that the "(" this cell ends in isn't part of the function name
 
@@ -72,7 +73,7 @@ public:
 
   bool IsOperator() const override;
 
-  const wxString &GetValue() const override { return m_text; }
+  wxString GetValue() const override { return m_text; }
 
   wxString GetGreekStringTeX() const;
 
@@ -132,7 +133,8 @@ protected:
     SizeEntry() = default;
   };
 
-  wxSize GetTextSize(wxDC *dc, const wxString &text, TextCell::TextIndex const index);
+  //! Returns the size of text in the font style describes, see TextExtentCache
+  wxSize GetTextSize(wxDC *dc, const Style &style, const wxString &text, TextCell::TextIndex const index);
 
   static wxRegEx m_unescapeRegEx;
   static wxRegEx m_roundingErrorRegEx1;
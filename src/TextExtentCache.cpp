@@ -0,0 +1,70 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#include "TextExtentCache.h"
+#include <wx/hashmap.h>
+#include <wx/log.h>
+
+constexpr size_t TextExtentCache::maxEntries;
+
+TextExtentCache::~TextExtentCache()
+{
+  wxLogMessage("~TextExtentCache: hits=%d misses=%d h:m ratio=%.2f",
+               m_hits, m_misses, double(m_hits)/m_misses);
+}
+
+size_t TextExtentCache::KeyHasher::operator()(const Key &key) const
+{
+  size_t hash = key.style.GetFontHash();
+  hash ^= wxStringHash()(key.text) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  hash ^= static_cast<size_t>(key.ppi) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+wxSize TextExtentCache::GetTextExtent(wxDC *dc, const Style &style, const wxString &text)
+{
+  if (text.empty())
+    return {};
+
+  Key key(style, text, dc->GetPPI().y);
+  auto it = m_cache.find(key);
+  if (it != m_cache.end())
+  {
+    ++ m_hits;
+    return it->second;
+  }
+
+  ++ m_misses;
+  wxSize size;
+  dc->GetTextExtent(text, &size.x, &size.y, NULL, NULL, &style.GetFont());
+
+  if (m_cache.size() >= maxEntries)
+    m_cache.clear();
+  m_cache.emplace(std::move(key), size);
+  return size;
+}
+
+void TextExtentCache::Clear()
+{
+  m_cache.clear();
+  m_hits = 0;
+  m_misses = 0;
+}
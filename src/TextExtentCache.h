@@ -0,0 +1,93 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#ifndef TEXTEXTENTCACHE_H
+#define TEXTEXTENTCACHE_H
+
+#include "precomp.h"
+#include "TextStyle.h"
+#include <wx/dc.h>
+#include <unordered_map>
+
+/*! \file
+ * This file declares the cache for the sizes of text snippets.
+ */
+
+/*! A cache for the sizes wxDC::GetTextExtent() returns
+
+  Asking the OS for the size of a text is slow. But most worksheets contain the
+  same operators, digits and variable names in thousands of cells, which means
+  that we can measure each of them once per font.
+
+  The size of a text also depends on the resolution of the device it is drawn
+  on, which is why the cache distinguishes between DCs with different PPI values.
+  Once the cache reaches maxEntries entries it is emptied.
+ */
+class TextExtentCache final
+{
+  static constexpr size_t maxEntries = 65536;
+  TextExtentCache(const TextExtentCache &) = delete;
+  TextExtentCache &operator=(const TextExtentCache &) = delete;
+
+  struct Key
+  {
+    Style style;
+    wxString text;
+    int ppi;
+    Key(const Style &style, const wxString &text, int ppi) : style(style), text(text), ppi(ppi) {}
+  };
+  struct KeyHasher
+  {
+    size_t operator()(const Key &key) const;
+  };
+  struct KeyEquals
+  {
+    bool operator()(const Key &l, const Key &r) const
+    { return (l.ppi == r.ppi) && (l.text == r.text) && l.style.IsFontEqualTo(r.style); }
+  };
+  std::unordered_map<Key, wxSize, KeyHasher, KeyEquals> m_cache;
+  int m_hits = 0;
+  int m_misses = 0;
+
+public:
+  TextExtentCache() = default;
+  ~TextExtentCache();
+  //! Returns the size text has if drawn on dc in the font style describes
+  wxSize GetTextExtent(wxDC *dc, const Style &style, const wxString &text);
+  int GetHits() const { return m_hits; }
+  int GetMisses() const { return m_misses; }
+  size_t GetSize() const { return m_cache.size(); }
+  void Clear();
+  static TextExtentCache &Get()
+  {
+#ifdef _WIN32
+    // The fonts we measure with are thread-local, as well.
+    static thread_local TextExtentCache globalCache;
+#else
+    static TextExtentCache globalCache;
+#endif // _WIN32
+    return globalCache;
+  }
+  static wxSize GetATextExtent(wxDC *dc, const Style &style, const wxString &text)
+  { return Get().GetTextExtent(dc, style, text); }
+};
+
+#endif  // TEXTEXTENTCACHE_H
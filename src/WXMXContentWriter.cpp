@@ -0,0 +1,230 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class WXMXContentWriter that streams the XML of a .wxmx file.
+ */
+
+#include "WXMXContentWriter.h"
+#include "Version.h"
+#include "XmlPullParser.h"
+#include <wx/filefn.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/txtstrm.h>
+#include <wx/wfstream.h>
+#include <set>
+
+constexpr size_t WXMXContentWriter::bufferSize;
+
+void WXMXContentWriter::Write(const wxString &text)
+{
+  wxScopedCharBuffer utf8 = text.utf8_str();
+  m_buffer.append(utf8.data(), utf8.length());
+  if (m_buffer.size() >= bufferSize)
+    Flush();
+}
+
+bool WXMXContentWriter::WriteElements(const wxString &xml)
+{
+  if (!IsWellFormed(xml))
+  {
+    if (m_ok)
+      m_invalidXML = xml;
+    m_ok = false;
+    return false;
+  }
+  Write(xml);
+  return true;
+}
+
+bool WXMXContentWriter::WriteGroupCell(const wxString &xml, bool highlight)
+{
+  if (highlight != m_highlight)
+  {
+    m_highlight = highlight;
+    Write(highlight ? wxT("<hl>\n") : wxT("</hl>\n"));
+  }
+  return WriteElements(xml);
+}
+
+void WXMXContentWriter::WriteDocumentEnd()
+{
+  if (m_highlight)
+    Write(wxT("</hl>\n"));
+  m_highlight = false;
+  Write(wxT("\n</wxMaximaDocument>"));
+}
+
+bool WXMXContentWriter::Flush()
+{
+  if (!m_buffer.empty())
+  {
+    m_out.Write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+  }
+  return IsOk();
+}
+
+bool WXMXContentWriter::IsWellFormed(const wxString &xml)
+{
+  // expat, which wxXmlDocument uses, refuses these characters
+  for (auto ch : xml)
+  {
+    wxUint32 c = ch.GetValue();
+    if (((c < 0x20) && (c != wxT('\t')) && (c != wxT('\n')) && (c != wxT('\r'))) ||
+        (c == 0xFFFE) || (c == 0xFFFF))
+      return false;
+  }
+
+  // XmlPullParser expects exactly one root element => Give the elements one.
+  wxString document = wxT("<r>") + xml + wxT("</r>");
+  XmlPullParser parser(document);
+  while (true)
+  {
+    switch (parser.Next())
+    {
+    case XmlPullParser::EndOfDocument:
+      return true;
+    case XmlPullParser::Error:
+      return false;
+    default:
+      break;
+    }
+  }
+}
+
+void WXMXContentWriter::WriteZipPreamble(wxZipOutputStream &zip)
+{
+  wxTextOutputStream output(zip);
+
+  /* The first zip entry is a file named "mimetype": This makes sure that the mimetype
+     is always stored at the same position in the file. This is common practice. One
+     example from an ePub file:
+
+     00000000  50 4b 03 04 14 00 00 08  00 00 cd bd 0a 43 6f 61  |PK...........Coa|
+     00000010  ab 2c 14 00 00 00 14 00  00 00 08 00 00 00 6d 69  |.,............mi|
+     00000020  6d 65 74 79 70 65 61 70  70 6c 69 63 61 74 69 6f  |metypeapplicatio|
+     00000030  6e 2f 65 70 75 62 2b 7a  69 70 50 4b 03 04 14 00  |n/epub+zipPK....|
+
+  */
+
+  // Make sure that the mime type is stored as plain text.
+  //
+  // We will keep that setting for the rest of the file for the following reasons:
+  //  - Compression of the .zip file won't improve compression of the embedded .png images
+  //  - The text part of the file is too small to justify compression
+  //  - not compressing the text part of the file allows version control systems to
+  //    determine which lines have changed and to track differences between file versions
+  //    efficiently (in a compressed text virtually every byte might change when one
+  //    byte at the start of the uncompressed original is)
+  //  - and if anything crashes in a bad way chances are high that the uncompressed
+  //    contents of the .wxmx file can be rescued using a text editor.
+  //  Who would - under these circumstances - care about a kilobyte?
+  zip.SetLevel(0);
+  zip.PutNextEntry(wxT("mimetype"));
+  output << wxT("text/x-wxmathml");
+  zip.CloseEntry();
+  zip.PutNextEntry(wxT("format.txt"));
+  output << wxT(
+    "\n\nThis file contains a wxMaxima session in the .wxmx format.\n"
+    ".wxmx files are .xml-based files contained in a .zip container like .odt\n"
+    "or .docx files. After changing their name to end in .zip the .xml and\n"
+    "eventual bitmap files inside them can be extracted using any .zip file\n"
+    "viewer.\n"
+    "The reason why part of a .wxmx file still might still seem to make sense in a\n"
+    "ordinary text viewer is that the text portion of .wxmx by default\n"
+    "isn't compressed: The text is typically small and compressing it would\n"
+    "mean that changing a single character would (with a high probability) change\n"
+    "big parts of the  whole contents of the compressed .zip archive.\n"
+    "Even if version control tools like git and svn that remember all changes\n"
+    "that were ever made to a file can handle binary files compression would\n"
+    "make the changed part of the file bigger and therefore seriously reduce\n"
+    "the efficiency of version control\n\n"
+    "wxMaxima can be downloaded from https://github.com/wxMaxima-developers/wxmaxima.\n"
+    "It also is part of the windows installer for maxima\n"
+    "(https://wxmaxima-developers.github.io/wxmaxima/).\n\n"
+    "If a .wxmx file is broken but the content.xml portion of the file can still be\n"
+    "viewed using a text editor just save the xml's text as \"content.xml\"\n"
+    "and try to open it using a recent version of wxMaxima.\n"
+    "If it is valid XML (the XML header is intact, all opened tags are closed again,\n"
+    "the text is saved with the text encoding \"UTF8 without BOM\" and the few\n"
+    "special characters XML requires this for are properly escaped)\n"
+    "chances are high that wxMaxima will be able to recover all code and text\n"
+    "from the XML file.\n\n"
+    );
+  zip.CloseEntry();
+}
+
+wxString WXMXContentWriter::XMLHeader()
+{
+  return wxString(wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n")) +
+    wxT("\n<!--   Created using wxMaxima ") + wxT(GITVERSION) + wxT("   -->") +
+    wxT("\n<!--https://wxMaxima-developers.github.io/wxmaxima/-->\n");
+}
+
+bool WXMXSnapshot::Write(const wxString &file)
+{
+  wxString tempfile = file + wxT("~");
+  bool ok = false;
+  {
+    wxFFileOutputStream out(tempfile);
+    if (out.IsOk())
+    {
+      wxZipOutputStream zip(out);
+      WXMXContentWriter::WriteZipPreamble(zip);
+      zip.PutNextEntry(wxT("content.xml"));
+      {
+        WXMXContentWriter content(zip);
+        content.Write(WXMXContentWriter::XMLHeader());
+        content.Write(documentTag);
+        for (auto const &cell : cells)
+          if (!content.WriteGroupCell(cell.xml, cell.highlight))
+            break;
+        content.WriteDocumentEnd();
+        ok = content.Flush();
+        if (!content.GetInvalidXML().IsEmpty())
+          wxLogMessage(_("Produced invalid XML. The file %s has therefore not been saved."), file);
+      }
+
+      // Two cells might refer to the same gnuplot file.
+      std::set<wxString> names;
+      for (auto const &entry : files)
+      {
+        if (!names.insert(entry.name).second)
+          continue;
+        // The data for gnuplot is likely to change in its entirety if it
+        // ever changes => We can store it in a compressed form.
+        zip.SetLevel(entry.name.EndsWith(wxT(".data")) ? 9 : 0);
+        zip.PutNextEntry(entry.name);
+        zip.Write(entry.data.GetData(), entry.data.GetDataLen());
+      }
+      ok = zip.Close() && ok;
+      ok = out.Close() && ok;
+    }
+  }
+  if (ok)
+    ok = wxRenameFile(tempfile, file, true);
+  else if (wxFileExists(tempfile))
+    wxRemoveFile(tempfile);
+  m_finished = true;
+  return ok;
+}
@@ -0,0 +1,136 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class WXMXContentWriter that streams the XML of a .wxmx file.
+ */
+
+#ifndef WXMXCONTENTWRITER_H
+#define WXMXCONTENTWRITER_H
+
+#include "CellPointers.h"
+#include <wx/string.h>
+#include <wx/stream.h>
+#include <wx/zipstrm.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*! Writes XML to a stream as UTF-8 and checks it while doing so
+
+  Building the whole content.xml of a .wxmx file in one string and then
+  parsing it again in order to test if it is valid XML needs several times as
+  much memory as the document itself. This class instead is fed the document
+  one piece at a time, checks each piece and sends it on to the stream in
+  chunks of bufferSize bytes.
+ */
+class WXMXContentWriter
+{
+public:
+  explicit WXMXContentWriter(wxOutputStream &out) : m_out(out) {}
+  //! Flushes the buffer
+  ~WXMXContentWriter() { Flush(); }
+
+  //! Writes text we know to be valid without checking it
+  void Write(const wxString &text);
+  /*! Checks and writes a sequence of complete XML elements
+
+    \return false, if xml isn't well-formed. In this case xml isn't written
+    and GetInvalidXML() returns it.
+  */
+  bool WriteElements(const wxString &xml);
+  /*! Checks and writes the XML of a GroupCell
+
+    Wraps consecutive highlighted GroupCells in a <hl> element, as
+    Cell::ListToXML() does.
+  */
+  bool WriteGroupCell(const wxString &xml, bool highlight);
+  //! Closes the <hl> element WriteGroupCell() might have opened and the root element
+  void WriteDocumentEnd();
+  //! Writes the buffer to the stream
+  bool Flush();
+  //! False if the stream has failed or WriteElements() has found invalid XML
+  bool IsOk() const { return m_ok && m_out.IsOk(); }
+  //! The first XML WriteElements() has refused to write
+  const wxString &GetInvalidXML() const { return m_invalidXML; }
+
+  /*! Tests if xml is a sequence of well-formed XML elements
+
+    Also refuses characters XML 1.0 doesn't allow in a document, like most
+    control characters.
+  */
+  static bool IsWellFormed(const wxString &xml);
+
+  //! Writes the zip entries that precede content.xml in every .wxmx file
+  static void WriteZipPreamble(wxZipOutputStream &zip);
+  //! The XML declaration and comments content.xml starts with
+  static wxString XMLHeader();
+
+private:
+  static constexpr size_t bufferSize = 65536;
+  wxOutputStream &m_out;
+  //! The UTF-8 we haven't sent to the stream, yet
+  std::string m_buffer;
+  wxString m_invalidXML;
+  bool m_ok = true;
+  //! Is WriteGroupCell() inside a <hl> element?
+  bool m_highlight = false;
+};
+
+/*! Everything a .wxmx file consists of, collected for writing it in a background task
+
+  Write() accesses the data of the wxMemoryBuffers in files, but doesn't copy
+  them: Their reference counts aren't thread-safe. This means that the thread
+  that has created the snapshot has to destroy it, as well, and that it has to
+  wait for IsFinished() before it does so.
+ */
+class WXMXSnapshot
+{
+public:
+  //! The start tag of content.xml's root element, including its attributes
+  wxString documentTag;
+  //! The XML of a GroupCell
+  struct GroupCellXML
+  {
+    wxString xml;
+    //! Is the GroupCell highlighted?
+    bool highlight;
+    GroupCellXML(const wxString &xml, bool highlight) : xml(xml), highlight(highlight) {}
+  };
+  //! The XML of each GroupCell
+  std::vector<GroupCellXML> cells;
+  //! The images and gnuplot files the XML refers to
+  std::vector<CellPointers::WXMXFile> files;
+
+  /*! Writes the .wxmx file. Can be called from a background thread.
+
+    Writes to a temp file first in order not to overwrite file with a broken
+    one if anything goes wrong.
+   */
+  bool Write(const wxString &file);
+  //! Has Write() finished?
+  bool IsFinished() const { return m_finished.load(); }
+
+private:
+  std::atomic<bool> m_finished{false};
+};
+
+#endif // WXMXCONTENTWRITER_H
@@ -38,7 +38,6 @@
 #include "EMFout.h"
 #include "WXMformat.h"
 #include "Version.h"
-#include "levenshtein/levenshtein.h"
 #include <wx/richtext/richtextbuffer.h>
 #include <wx/tooltip.h>
 #include <wx/dcbuffer.h>
@@ -50,6 +49,8 @@
 #include "SlideShowCell.h"
 #include "ImgCell.h"
 #include "MarkDown.h"
+#include "RenderTimings.h"
+#include "ZipIndex.h"
 #include "ConfigDialogue.h"
 
 #include <wx/clipbrd.h>
@@ -69,6 +70,7 @@
 #include <wx/filesys.h>
 #include <wx/fs_mem.h>
 #include <stdlib.h>
+#include <algorithm>
 #include "memory"
 
 //! This class represents the worksheet shown in the middle of the wxMaxima window.
@@ -240,6 +242,17 @@ bool Worksheet::RedrawIfRequested()
 {
   bool redrawIssued = false;
 
+  // Drawing these cells has shown that their size was estimated too small
+  for (auto const &group : m_cellPointers.m_groupsToRecalculate)
+    if (group)
+    {
+      group->ResetData();
+      group->ClearRenderCache();
+      Recalculate(group);
+      RequestRedraw(group);
+    }
+  m_cellPointers.m_groupsToRecalculate.clear();
+
   RecalculateIfNeeded();
 
   if(m_mouseMotionWas)
@@ -356,6 +369,8 @@ bool Worksheet::RedrawIfRequested()
 void Worksheet::RequestRedraw(GroupCell *start)
 {
   m_redrawRequested = true;
+  if (start)
+    start->ClearRenderCache();
 
   if (start == 0)
     m_redrawStart = GetTree();
@@ -440,6 +455,7 @@ Worksheet::~Worksheet()
 
 void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
 {
+  RenderTimings::Scope timing(RenderTimings::paint);
   m_configuration->ClearAndEnableRedrawTracing();
   m_configuration->SetBackgroundBrush(
     *(wxTheBrushList->FindOrCreateBrush(m_configuration->DefaultBackgroundColor(),
@@ -651,18 +667,27 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
       // very soon have to generated a scaled image again.
       if ((cellRect.GetBottom() <= m_lastBottom - 2 * height) || (cellRect.GetTop() >= m_lastTop + 2 * height))
       {
-        if (tmp->GetOutput())
+        if (!tmp->IsOutputUnloaded() && tmp->GetOutput())
           tmp->GetOutput()->ClearCacheList();
+        tmp->ClearRenderCache();
       }
     }
     
     tmp->SetCurrentPoint(point);
-    if (tmp->DrawThisCell(point))
+    bool drawn = tmp->DrawThisCell(point);
+    if (drawn)
     {
       tmp->InEvaluationQueue(m_evaluationQueue.IsInQueue(tmp));
       tmp->LastInEvaluationQueue(m_evaluationQueue.GetCell() == tmp);
     }
-    tmp->Draw(point);
+    if (!(drawn && m_configuration->CacheRenderedCells() && DrawGroupCellCached(tmp, point)))
+    {
+      // The cell might look different now than the bitmap we have of it
+      tmp->ClearRenderCache();
+      tmp->Draw(point);
+    }
+    if (drawn && m_configuration->LazyOutput() && !tmp->IsHidden() && tmp->GetLabel())
+      OutputLoaded(tmp);
     tmp = tmp->GetNext();
     if (tmp)
     {
@@ -686,6 +711,93 @@ void Worksheet::OnPaint(wxPaintEvent &WXUNUSED(event))
   m_configuration->ReportMultipleRedraws();
 }
 
+bool Worksheet::DrawGroupCellCached(GroupCell *group, wxPoint point)
+{
+  // Everything that is highlighted, blinks or is being edited changes its looks
+  // without being recalculated.
+  if (HasCellsSelected() || !m_cellPointers.m_selectionString.IsEmpty())
+    return false;
+  if ((GetActiveCell() && (GetActiveCell()->GetGroup() == group)) ||
+      (m_cellPointers.m_answerCell && (m_cellPointers.m_answerCell->GetGroup() == group)) ||
+      (m_cellPointers.m_groupCellUnderPointer == group) ||
+      (m_cellPointers.GetWorkingGroup() == group) ||
+      m_evaluationQueue.IsInQueue(group))
+    return false;
+
+  wxRect cellRect = group->GetRect();
+  if (cellRect.GetTop() < 0)
+    return false;
+  // Cells that are higher than the screen would need huge bitmaps
+  if (cellRect.GetHeight() > GetClientSize().y)
+    return false;
+
+  // The tile includes the cell bracket and the background EditorCells draw
+  // up to the right border of the worksheet.
+  wxRect tile(0, cellRect.GetTop() - 2,
+              wxMax(GetVirtualSize().x, GetClientSize().x), cellRect.GetHeight() + 5);
+  double scale = GetContentScaleFactor();
+  wxBitmap bitmap = group->GetRenderCache(tile);
+  if (!bitmap.IsOk())
+  {
+    if (group->ContainsSlideShows())
+      return false;
+    #ifdef __WXMAC__
+    bitmap = wxBitmap(tile.GetSize() * scale, wxBITMAP_SCREEN_DEPTH, scale);
+    #else
+    bitmap = wxBitmap(tile.GetSize() * scale, wxBITMAP_SCREEN_DEPTH);
+    #endif
+    if (!bitmap.IsOk())
+      return false;
+
+    wxMemoryDC tileDC;
+    tileDC.SetUserScale(scale, scale);
+    tileDC.SelectObject(bitmap);
+    if (!tileDC.IsOk())
+      return false;
+    tileDC.SetLogicalOrigin(tile.GetLeft(), tile.GetTop());
+    wxGCDC antiAliassingDC(tileDC);
+
+    // Let the cell draw itself into the tile instead of into the worksheet
+    wxDC *dc = m_configuration->GetDC();
+    wxDC *adc = m_configuration->GetAntialiassingDC();
+    wxRect updateRegion = m_configuration->GetUpdateRegion();
+    m_configuration->SetContext(tileDC);
+    if (antiAliassingDC.IsOk())
+    {
+      antiAliassingDC.SetLogicalOrigin(tile.GetLeft(), tile.GetTop());
+      m_configuration->SetAntialiassingDC(antiAliassingDC);
+    }
+    m_configuration->SetUpdateRegion(tile);
+
+    tileDC.SetMapMode(wxMM_TEXT);
+    tileDC.SetBackgroundMode(wxTRANSPARENT);
+    tileDC.SetBrush(m_configuration->GetBackgroundBrush());
+    tileDC.SetPen(*wxTRANSPARENT_PEN);
+    tileDC.SetLogicalFunction(wxCOPY);
+    tileDC.DrawRectangle(tile);
+    tileDC.SetPen(*(wxThePenList->FindOrCreatePen(m_configuration->GetColor(TS_DEFAULT), 1, wxPENSTYLE_SOLID)));
+    tileDC.SetBrush(*(wxTheBrushList->FindOrCreateBrush(m_configuration->GetColor(TS_DEFAULT))));
+    group->Draw(point);
+
+    m_configuration->SetUpdateRegion(updateRegion);
+    m_configuration->SetContext(*dc);
+    m_configuration->SetAntialiassingDC(*adc);
+    tileDC.SelectObject(wxNullBitmap);
+    // The exact rescale of an image replaces the approximation as soon as it is ready
+    if (!group->ShowsApproximatedImages())
+      group->SetRenderCache(bitmap, tile);
+  }
+
+  wxMemoryDC tileDC;
+  tileDC.SetUserScale(scale, scale);
+  tileDC.SelectObjectAsSource(bitmap);
+  if (!tileDC.IsOk())
+    return false;
+  tileDC.SetLogicalOrigin(tile.GetLeft(), tile.GetTop());
+  m_configuration->GetDC()->Blit(tile.GetPosition(), tile.GetSize(), &tileDC, tile.GetPosition());
+  return true;
+}
+
 GroupCell *Worksheet::InsertGroupCells(GroupCell *cells, GroupCell *where)
 {
   return InsertGroupCells(cells, where, &treeUndoActions);
@@ -872,6 +984,58 @@ void Worksheet::InsertLine(std::unique_ptr<Cell> &&newCell, bool forceNewLine)
   RequestRedraw(tmp);
 }
 
+bool Worksheet::InsertLineLazily(const wxString &xml, CellType type, bool forceNewLine, bool bigSkip,
+                                 const wxString &userLabel)
+{
+  if (!m_configuration->LazyOutput())
+    return false;
+
+  GroupCell *tmp = GetWorkingGroup();
+  if (!tmp)
+    return false;
+
+  // If the output would be visible we need the cells, anyway.
+  int view_x, view_y;
+  int width, height;
+  CalcUnscrolledPosition(0, 0, &view_x, &view_y);
+  GetClientSize(&width, &height);
+  if (!tmp->IsHidden() &&
+      (FollowEvaluation() || tmp->GetRect().Intersects(wxRect(view_x, view_y, width, height))))
+    return false;
+
+  if (!tmp->AppendUnloadedOutput(xml, type, bigSkip, forceNewLine, userLabel))
+    return false;
+
+  OutputChanged();
+  // The cells below this one have to make room for the height we have reserved.
+  Recalculate(tmp, false);
+  return true;
+}
+
+void Worksheet::OutputLoaded(GroupCell *group)
+{
+  auto &loadedOutputs = m_cellPointers.m_loadedOutputs;
+  if (loadedOutputs.empty() || (loadedOutputs.front().get() != group))
+  {
+    loadedOutputs.remove_if([group](const CellPtr<GroupCell> &loaded)
+                            { return (loaded.get() == group) || !loaded; });
+    loadedOutputs.emplace_front(group);
+    group->InLoadedOutputs(true);
+  }
+
+  while ((long) loadedOutputs.size() > m_configuration->MaxLoadedOutputs())
+  {
+    // GroupCells that have been deleted in the meantime are null by now.
+    GroupCell *oldest = loadedOutputs.back();
+    loadedOutputs.pop_back();
+    if (oldest)
+    {
+      oldest->InLoadedOutputs(false);
+      oldest->UnloadOutput();
+    }
+  }
+}
+
 void Worksheet::SetZoomFactor(double newzoom, bool recalc)
 {
   // Restrict zoom factors to tenths
@@ -920,7 +1084,33 @@ void Worksheet::SetZoomFactor(double newzoom, bool recalc)
 
 bool Worksheet::RecalculateIfNeeded()
 {
+  RenderTimings::Scope timing(RenderTimings::layout);
   UpdateConfigurationClientSize();
+
+  int width;
+  int height;
+  GetClientSize(&width, &height);
+  wxPoint topLeft;
+  CalcUnscrolledPosition(0, 0, &topLeft.x, &topLeft.y);
+  wxRect view(topLeft, wxSize(width, height));
+
+  // Everything that can be reached by scrolling by a screen's height
+  wxRect region(view);
+  region.Inflate(0, height);
+
+  // Cells we have skipped mustn't be forgotten if we recalculate the cells after
+  // them, and need to be recalculated as soon as they come into view.
+  if (m_recalculateLaterFirst && GetTree())
+  {
+    if (m_recalculateStart)
+      Recalculate(m_recalculateLaterFirst);
+    else if (view != m_recalculateLaterView)
+    {
+      m_recalculateLaterView = view;
+      RecalculateSkipped(region);
+    }
+  }
+
   if (!m_recalculateStart || !GetTree())
   {
     m_recalculateStart = {};
@@ -935,10 +1125,6 @@ bool Worksheet::RecalculateIfNeeded()
 
   UpdateConfigurationClientSize();
 
-  int width;
-  int height;
-  GetClientSize(&width, &height);
-
   wxPoint upperLeftScreenCorner;
   CalcScrolledPosition(0, 0,
                        &upperLeftScreenCorner.x, &upperLeftScreenCorner.y);
@@ -946,10 +1132,22 @@ bool Worksheet::RecalculateIfNeeded()
                                            upperLeftScreenCorner + wxPoint(width,height)));
   m_configuration->SetWorksheetPosition(GetPosition());
 
+  bool lazy = m_configuration->LazyLayout() && m_configuration->ClipToDrawRegion() &&
+    !m_configuration->GetPrinting();
+  m_recalculateLaterFirst = nullptr;
+  m_recalculateLaterLast = nullptr;
+  m_recalculateLaterView = view;
   for (auto *tmp = m_recalculateStart ? m_recalculateStart : GetTree();
        tmp; tmp = tmp->GetNext())
   {
-    tmp->Recalculate();
+    if (!lazy)
+      tmp->Recalculate();
+    else if (tmp->RecalculateInRegion(region))
+    {
+      if (!m_recalculateLaterFirst)
+        m_recalculateLaterFirst = tmp;
+      m_recalculateLaterLast = tmp;
+    }
   }
 
   if (m_configuration->AdjustWorksheetSize())
@@ -963,6 +1161,56 @@ bool Worksheet::RecalculateIfNeeded()
   return true;
 }
 
+void Worksheet::RecalculateSkipped(const wxRect &region)
+{
+  AFontSize fontSize = m_configuration->GetDefaultFontSize();
+  GroupCell *first = nullptr;
+  GroupCell *last = nullptr;
+  bool heightChanged = false;
+  GroupCell *const end = m_recalculateLaterLast;
+  GroupCell *tmp = m_recalculateLaterFirst;
+  for (; tmp; tmp = tmp->GetNext())
+  {
+    // The cells behind a cell whose size wasn't estimated right have moved
+    if (heightChanged)
+      tmp->UpdateYPosition();
+    // The cells from here on are too far away to be recalculated, yet
+    if (tmp->GetRect().GetTop() > region.GetBottom())
+      break;
+    int height = tmp->GetHeight();
+    if (tmp->NeedsRecalculation(fontSize) && tmp->RecalculateInRegion(region))
+    {
+      if (!first)
+        first = tmp;
+      last = tmp;
+    }
+    else if (tmp->GetHeight() != height)
+      heightChanged = true;
+    if (tmp == end)
+    {
+      tmp = nullptr;
+      break;
+    }
+  }
+
+  if (tmp)
+  {
+    // The cells from tmp on may still contain skipped cells
+    if (!first)
+      first = tmp;
+    last = end;
+    if (heightChanged)
+      tmp->UpdateYPositionList();
+  }
+  else if (heightChanged && end && end->GetNext())
+    end->GetNext()->UpdateYPositionList();
+  m_recalculateLaterFirst = first;
+  m_recalculateLaterLast = last;
+
+  if (heightChanged)
+    AdjustSize();
+}
+
 void Worksheet::Recalculate(Cell *start, bool force)
 {
   GroupCell *group = GetTree();
@@ -1664,24 +1912,31 @@ void Worksheet::OnMouseRightDown(wxMouseEvent &event)
                 popupMenu.Append(wxID_HELP, wxString::Format(_("Help on \"%s\""),
                                                               wordUnderCursor));
               
-              HelpFileAnchors::const_iterator it;
-              for (it = m_helpFileAnchors.begin(); it != m_helpFileAnchors.end(); ++it)
+              // The anchors are only added to, never removed
+              if(m_helpFileAnchorsSearch.GetCount() != m_helpFileAnchors.size())
+              {
+                m_helpFileAnchorsSearch.Clear();
+                for (auto const &anchor : m_helpFileAnchors)
+                  m_helpFileAnchorsSearch.Add(anchor.first);
+              }
+              for (auto const &anchor : m_helpFileAnchors)
               {
-                wxString cmdName = it->first;
+                wxString const &cmdName = anchor.first;
                 if(cmdName.EndsWith("_"))
                   continue;
                 if(cmdName.EndsWith("pkg"))
                   continue;
-                if(cmdName.StartsWith(wordUnderCursor))
-                {
-                  if (wordUnderCursor != cmdName)
-                    sameBeginning.Add(cmdName);
-                }
-                else
-                {
-                  int dstnce = LevenshteinDistance(wordUnderCursor, cmdName);
-                  if((dstnce<=4) && (dstnce > 0)) dst[dstnce-1].Add(cmdName);
-                }
+                if(cmdName.StartsWith(wordUnderCursor) && (wordUnderCursor != cmdName))
+                  sameBeginning.Add(cmdName);
+              }
+              for (auto const &match : m_helpFileAnchorsSearch.Find(wordUnderCursor, 4))
+              {
+                wxString const &cmdName = match.second;
+                if(cmdName.EndsWith("_") || cmdName.EndsWith("pkg") ||
+                   cmdName.StartsWith(wordUnderCursor))
+                  continue;
+                if(match.first > 0)
+                  dst[match.first - 1].Add(cmdName);
               }
               m_replacementsForCurrentWord.Clear();
               if(sameBeginning.GetCount() <= 10)
@@ -2874,7 +3129,8 @@ void Worksheet::DeleteRegion(GroupCell *start, GroupCell *end, UndoActions *undo
       renumber = true;
 
     // Don't keep cached versions of scaled images around in the undo buffer.
-    if (tmp->GetOutput())
+    // Unloaded outputs contain no images and would be loaded by GetOutput().
+    if (!tmp->IsOutputUnloaded() && tmp->GetOutput())
       tmp->GetOutput()->ClearCacheList();
 
     if (tmp == end)
@@ -4147,8 +4403,7 @@ void Worksheet::OnChar(wxKeyEvent &event)
   // entering unicode characters instead.
   if (m_findDialog && event.GetKeyCode() == WXK_ESCAPE)
   {
-    m_findDialog->Destroy();
-    m_findDialog = NULL;
+    CloseFindDialog();
     return;
   }
 
@@ -5357,13 +5612,26 @@ bool Worksheet::ExportToHTML(const wxString &file)
 
             case Configuration::bitmap:
             {
-              wxSize size;
               int bitmapScale = 3;
               ext = wxT(".png");
               wxConfig::Get()->Read(wxT("bitmapScale"), &bitmapScale);
-              size = CopyToFile(imgDir + wxT("/") + filename + wxString::Format(wxT("_%d.png"), count),
-                                &(*chunk),
-                                NULL, true, bitmapScale);
+              // Drawing needs the GUI thread. Compressing the png file doesn't
+              // => a background task does that while we render the next chunks.
+              BitmapOut bitmap(&m_configuration, CopySelection(&(*chunk), NULL, true), bitmapScale);
+              wxSize size = wxDefaultSize;
+              if (bitmap.IsOk())
+              {
+                size = bitmap.GetScaledSize();
+                wxImage *image = new wxImage(bitmap.ToImage());
+                wxString imgFile = imgDir + wxT("/") + filename + wxString::Format(wxT("_%d.png"), count);
+                #ifdef HAVE_OPENMP_TASKS
+                #pragma omp task firstprivate(image, imgFile)
+                #endif
+                {
+                  std::unique_ptr<wxImage> img(image);
+                  BitmapOut::SaveImage(*img, imgFile);
+                }
+              }
               int borderwidth = 0;
               wxString alttext = EditorCell::EscapeHTMLChars(chunk->ListToString());
               borderwidth = chunk->GetImageBorderWidth();
@@ -5572,7 +5840,12 @@ bool Worksheet::ExportToHTML(const wxString &file)
   }
   else
     wxLogMessage(_("Bug: HTML output is no valid XML"));
-  
+
+  // Wait for the background tasks that write the images
+  #ifdef HAVE_OPENMP_TASKS
+  #pragma omp taskwait
+  #endif
+
   wxFileOutputStream outfile(file);
   if (!outfile.IsOk())
   {
@@ -5931,6 +6204,84 @@ bool Worksheet::ExportToMAC(const wxString &file)
   since the last save. Then the original .wxmx file is replaced in a
   (hopefully) atomic operation.
 */
+wxString Worksheet::WXMXDocumentTag()
+{
+  wxString documentTag;
+  documentTag << wxT("\n<wxMaximaDocument version=\"");
+  documentTag << DOCUMENT_VERSION_MAJOR << wxT(".");
+  documentTag << DOCUMENT_VERSION_MINOR << wxT("\" zoom=\"");
+  documentTag << int(100.0 * m_configuration->GetZoomFactor()) << wxT("\"");
+
+  // **************************************************************************
+  // Find out the number of the cell the cursor is at and save this information
+  // if we find it
+
+  // Determine which cell the cursor is at.
+  long ActiveCellNumber = 1;
+  GroupCell *cursorCell = NULL;
+  if (m_hCaretActive)
+  {
+    cursorCell = GetHCaret();
+
+    // If the cursor is before the 1st cell in the worksheet the cell number
+    // is 0.
+    if (!cursorCell)
+      ActiveCellNumber = 0;
+  }
+  else
+  {
+    if (GetActiveCell())
+      cursorCell = GetActiveCell()->GetGroup();
+  }
+
+  if (cursorCell == NULL)
+    ActiveCellNumber = 0;
+  // We want to save the information that the cursor is in the nth cell.
+  // Count the cells until then.
+  GroupCell *tmp = GetTree();
+  if (tmp == NULL)
+    ActiveCellNumber = -1;
+  if (ActiveCellNumber > 0)
+  {
+    while ((tmp) && (tmp != cursorCell))
+    {
+      tmp = tmp->GetNext();
+      ActiveCellNumber++;
+    }
+  }
+  // Paranoia: What happens if we didn't find the cursor?
+  if (tmp == NULL) ActiveCellNumber = -1;
+
+  // If we know where the cursor was we save this piece of information.
+  // If not we omit it.
+  if (ActiveCellNumber >= 0)
+    documentTag << wxString::Format(wxT(" activecell=\"%li\""), ActiveCellNumber);
+
+
+  // Save the variables list for the "variables" sidepane.
+  wxArrayString variables = m_variablesPane->GetVarnames();
+  if(variables.GetCount() > 1)
+  {
+    long varcount = variables.GetCount() - 1;
+    documentTag += wxString::Format(" variables_num=\"%li\"", varcount);
+    for(unsigned long i = 0; i<variables.GetCount(); i++)
+      documentTag += wxString::Format(" variables_%li=\"%s\"", i, Cell::XMLescape(variables[i]).utf8_str());
+  }
+  
+  documentTag << ">\n";
+  return documentTag;
+}
+
+std::shared_ptr<WXMXSnapshot> Worksheet::CreateWXMXSnapshot()
+{
+  std::shared_ptr<WXMXSnapshot> snapshot = std::make_shared<WXMXSnapshot>();
+  snapshot->documentTag = WXMXDocumentTag();
+  m_cellPointers.WXMXResetCounter();
+  for (GroupCell *group = GetTree(); group; group = group->GetNext())
+    snapshot->cells.emplace_back(group->ToXMLCached(snapshot->files), group->GetHighlight());
+  return snapshot;
+}
+
 bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
 {
   #ifdef OPENMP
@@ -5959,161 +6310,17 @@ bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
       if (!zip.IsOk())
         return false;
       {
-        wxTextOutputStream output(zip);
-
-        /* The first zip entry is a file named "mimetype": This makes sure that the mimetype
-           is always stored at the same position in the file. This is common practice. One
-           example from an ePub file:
-
-           00000000  50 4b 03 04 14 00 00 08  00 00 cd bd 0a 43 6f 61  |PK...........Coa|
-           00000010  ab 2c 14 00 00 00 14 00  00 00 08 00 00 00 6d 69  |.,............mi|
-           00000020  6d 65 74 79 70 65 61 70  70 6c 69 63 61 74 69 6f  |metypeapplicatio|
-           00000030  6e 2f 65 70 75 62 2b 7a  69 70 50 4b 03 04 14 00  |n/epub+zipPK....|
-
-        */
-
-        // Make sure that the mime type is stored as plain text.
-        //
-        // We will keep that setting for the rest of the file for the following reasons:
-        //  - Compression of the .zip file won't improve compression of the embedded .png images
-        //  - The text part of the file is too small to justify compression
-        //  - not compressing the text part of the file allows version control systems to
-        //    determine which lines have changed and to track differences between file versions
-        //    efficiently (in a compressed text virtually every byte might change when one
-        //    byte at the start of the uncompressed original is)
-        //  - and if anything crashes in a bad way chances are high that the uncompressed
-        //    contents of the .wxmx file can be rescued using a text editor.
-        //  Who would - under these circumstances - care about a kilobyte?
-        zip.SetLevel(0);
-        zip.PutNextEntry(wxT("mimetype"));
-        output << wxT("text/x-wxmathml");
-        zip.CloseEntry();
-        zip.PutNextEntry(wxT("format.txt"));
-        output << wxT(
-          "\n\nThis file contains a wxMaxima session in the .wxmx format.\n"
-          ".wxmx files are .xml-based files contained in a .zip container like .odt\n"
-          "or .docx files. After changing their name to end in .zip the .xml and\n"
-          "eventual bitmap files inside them can be extracted using any .zip file\n"
-          "viewer.\n"
-          "The reason why part of a .wxmx file still might still seem to make sense in a\n"
-          "ordinary text viewer is that the text portion of .wxmx by default\n"
-          "isn't compressed: The text is typically small and compressing it would\n"
-          "mean that changing a single character would (with a high probability) change\n"
-          "big parts of the  whole contents of the compressed .zip archive.\n"
-          "Even if version control tools like git and svn that remember all changes\n"
-          "that were ever made to a file can handle binary files compression would\n"
-          "make the changed part of the file bigger and therefore seriously reduce\n"
-          "the efficiency of version control\n\n"
-          "wxMaxima can be downloaded from https://github.com/wxMaxima-developers/wxmaxima.\n"
-          "It also is part of the windows installer for maxima\n"
-          "(https://wxmaxima-developers.github.io/wxmaxima/).\n\n"
-          "If a .wxmx file is broken but the content.xml portion of the file can still be\n"
-          "viewed using a text editor just save the xml's text as \"content.xml\"\n"
-          "and try to open it using a recent version of wxMaxima.\n"
-          "If it is valid XML (the XML header is intact, all opened tags are closed again,\n"
-          "the text is saved with the text encoding \"UTF8 without BOM\" and the few\n"
-          "special characters XML requires this for are properly escaped)\n"
-          "chances are high that wxMaxima will be able to recover all code and text\n"
-          "from the XML file.\n\n"
-          );
-        zip.CloseEntry();
+        WXMXContentWriter::WriteZipPreamble(zip);
 
         // next zip entry is "content.xml", xml of GetTree()
 
         zip.PutNextEntry(wxT("content.xml"));
-        wxString xmlText;
-
-        xmlText << wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-        xmlText << wxT("\n<!--   Created using wxMaxima ") << wxT(GITVERSION) << wxT("   -->");
-        xmlText << wxT("\n<!--https://wxMaxima-developers.github.io/wxmaxima/-->\n");
-
-        // write document
-        xmlText << wxT("\n<wxMaximaDocument version=\"");
-        xmlText << DOCUMENT_VERSION_MAJOR << wxT(".");
-        xmlText << DOCUMENT_VERSION_MINOR << wxT("\" zoom=\"");
-        xmlText << int(100.0 * m_configuration->GetZoomFactor()) << wxT("\"");
-
-        // **************************************************************************
-        // Find out the number of the cell the cursor is at and save this information
-        // if we find it
-
-        // Determine which cell the cursor is at.
-        long ActiveCellNumber = 1;
-        GroupCell *cursorCell = NULL;
-        if (m_hCaretActive)
-        {
-          cursorCell = GetHCaret();
-
-          // If the cursor is before the 1st cell in the worksheet the cell number
-          // is 0.
-          if (!cursorCell)
-            ActiveCellNumber = 0;
-        }
-        else
-        {
-          if (GetActiveCell())
-            cursorCell = GetActiveCell()->GetGroup();
-        }
 
-        if (cursorCell == NULL)
-          ActiveCellNumber = 0;
-        // We want to save the information that the cursor is in the nth cell.
-        // Count the cells until then.
-        GroupCell *tmp = GetTree();
-        if (tmp == NULL)
-          ActiveCellNumber = -1;
-        if (ActiveCellNumber > 0)
-        {
-          while ((tmp) && (tmp != cursorCell))
-          {
-            tmp = tmp->GetNext();
-            ActiveCellNumber++;
-          }
-        }
-        // Paranoia: What happens if we didn't find the cursor?
-        if (tmp == NULL) ActiveCellNumber = -1;
-
-        // If we know where the cursor was we save this piece of information.
-        // If not we omit it.
-        if (ActiveCellNumber >= 0)
-          xmlText << wxString::Format(wxT(" activecell=\"%li\""), ActiveCellNumber);
-
-
-        // Save the variables list for the "variables" sidepane.
-        wxArrayString variables = m_variablesPane->GetVarnames();
-        if(variables.GetCount() > 1)
-        {
-          long varcount = variables.GetCount() - 1;
-          xmlText += wxString::Format(" variables_num=\"%li\"", varcount);
-          for(unsigned long i = 0; i<variables.GetCount(); i++)
-            xmlText += wxString::Format(" variables_%li=\"%s\"", i, Cell::XMLescape(variables[i]).utf8_str());
-        }
-  
-        xmlText << ">\n";
+        wxString documentTag = WXMXDocumentTag();
 
         // Reset image counter
         m_cellPointers.WXMXResetCounter();
 
-        if (GetTree())
-          xmlText += GetTree()->ListToXML();
-
-        // Delete all but one control character from the string: there should be
-        // no way for them to enter this string, anyway. But sometimes they still
-        // do...
-        for (wxString::const_iterator it = xmlText.begin(); it != xmlText.end(); ++it)
-        {
-          wxChar c = *it;
-          if ((c < wxT('\t')) ||
-              ((c > wxT('\n')) && (c < wxT(' '))) ||
-              (c == wxChar((char) 0x7F))
-            )
-          {
-            // *it = wxT(' ');
-          }
-        }
-
-        xmlText +=  wxT("\n</wxMaximaDocument>");
-
         {
           // Prepare reading the files we have stored in memory
           std::unique_ptr<wxFileSystem> fsystem(new wxFileSystem);
@@ -6128,48 +6335,52 @@ bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
                                      dummyBuf.GetData(),
                                      dummyBuf.GetDataLen());
 
-          // Let wxWidgets test if the document can be read again by the XML parser before
-          // the user finds out the hard way.
+          // Stream the document into the zip file one GroupCell at a time and
+          // let the writer test if each of them can be read again by the XML
+          // parser before the user finds out the hard way.
+          wxString invalidXML;
+          if (!WXMXContentWriter::IsWellFormed(documentTag + wxT("</wxMaximaDocument>")))
+            invalidXML = documentTag;
+          else if (GetTree())
           {
-            wxXmlDocument doc;
+            WXMXContentWriter content(zip);
+            content.Write(WXMXContentWriter::XMLHeader());
+            content.Write(documentTag);
+
+            // The same as GetTree()->ListToXML(), but without the need to keep the
+            // whole document in memory at once
+            for (GroupCell *group = GetTree(); group && content.IsOk(); group = group->GetNext())
+              content.WriteGroupCell(group->ToXML(), group->GetHighlight());
+            content.WriteDocumentEnd();
+            content.Flush();
+            invalidXML = content.GetInvalidXML();
+          }
+
+          // If we fail to save valid XML we abort the save process as it will
+          // only destroy data.
+          // But we can still put the erroneous data into the clipboard for debugging purposes.
+          if (!invalidXML.IsEmpty())
+          {
+            if (wxTheClipboard->Open())
             {
-              wxMemoryOutputStream ostream;
-              wxTextOutputStream txtstrm(ostream);
-              txtstrm.WriteString(xmlText);
-              wxMemoryInputStream istream(ostream);
-              doc.Load(istream);
+              wxDataObjectComposite *data = new wxDataObjectComposite;
+              data->Add(new wxTextDataObject(invalidXML));
+              wxTheClipboard->SetData(data);
+              wxLogMessage(_("Produced invalid XML. The erroneous XML data has therefore not been saved but has been put on the clipboard in order to allow to debug it."));
+              wxTheClipboard->Close();
             }
 
-            // If we fail to load the document we abort the safe process as it will
-            // only destroy data.
-            // But we can still put the erroneous data into the clipboard for debugging purposes.
-            if (!doc.IsOk())
+            // Remove all files from our internal filesystem
+            wxString memFsName = fsystem->FindFirst("*", wxFILE);
+            while(memFsName != wxEmptyString)
             {
-              if (wxTheClipboard->Open())
-              {
-                wxDataObjectComposite *data = new wxDataObjectComposite;
-                data->Add(new wxTextDataObject(xmlText));
-                wxTheClipboard->SetData(data);
-                wxLogMessage(_("Produced invalid XML. The erroneous XML data has therefore not been saved but has been put on the clipboard in order to allow to debug it."));
-                wxTheClipboard->Close();
-              }
-
-              // Remove all files from our internal filesystem
-              wxString memFsName = fsystem->FindFirst("*", wxFILE);
-              while(memFsName != wxEmptyString)
-              {
-                wxString name = memFsName.Right(memFsName.Length()-7);
-                wxMemoryFSHandler::RemoveFile(name);
-                memFsName = fsystem->FindNext();
-              }
-              return false;
+              wxString name = memFsName.Right(memFsName.Length()-7);
+              wxMemoryFSHandler::RemoveFile(name);
+              memFsName = fsystem->FindNext();
             }
+            return false;
           }
 
-          // wxWidgets could pretty-print the XML document now. But as no-one will
-          // look at it, anyway, there might be no good reason to do so.
-          if (GetTree() != NULL)output << xmlText;
-
           // Move all files we have stored in memory during saving to zip file
           wxString memFsName = fsystem->FindFirst("*", wxFILE);
           while(memFsName != wxEmptyString)
@@ -6179,11 +6390,8 @@ bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
             {
               zip.CloseEntry();
 
-              wxFSFile *fsfile;
-#ifdef HAVE_OPENMP_TASKS
-#pragma omp critical (OpenFSFile)
-#endif
-              fsfile = fsystem->OpenFile(memFsName);
+              // The in-memory filesystem is only ever used by the main thread.
+              wxFSFile *fsfile = fsystem->OpenFile(memFsName);
 
               if (fsfile)
               {
@@ -6223,36 +6431,10 @@ bool Worksheet::ExportToWXMX(const wxString &file, bool markAsSaved)
   
   // Now we try to open the file in order to see if saving hasn't failed
   // without returning an error - which can apparently happen on MSW.
-  wxString wxmxURI = wxURI(wxT("file://") + backupfile).BuildURI();
-  wxmxURI.Replace("#", "%23");
-#ifdef  __WXMSW__
-  // Fixes a missing "///" after the "file:". This works because we always get absolute
-  // file names.
-  wxRegEx uriCorector1("^file:([a-zA-Z]):");
-  wxRegEx uriCorector2("^file:([a-zA-Z][a-zA-Z]):");
-  uriCorector1.ReplaceFirst(&wxmxURI,wxT("file:///\\1:"));
-  uriCorector2.ReplaceFirst(&wxmxURI,wxT("file:///\\1:"));
-#endif
-  // The URI of the wxm code contained within the .wxmx file
-  wxString filename = wxmxURI + wxT("#zip:content.xml");
-
-  // Open the file we have saved yet just in order to see if we
-  // actually managed to save it correctly.
+  if (!ZipIndex(backupfile).Contains(wxT("content.xml")))
   {
-    wxFileSystem fs;
-    wxFSFile *fsfile;
-#ifdef HAVE_OPENMP_TASKS
-#pragma omp critical (OpenFSFile)
-#endif
-    fsfile = fs.OpenFile(filename);
-    
-    // Did we succeed in opening the file?
-    if (!fsfile)
-    {
-      wxLogMessage(_(wxT("Saving succeeded, but the file could not be read again \u21D2 Not replacing the old saved file.")));
-      return false;
-    }
-    wxDELETE(fsfile);
+    wxLogMessage(_(wxT("Saving succeeded, but the file could not be read again \u21D2 Not replacing the old saved file.")));
+    return false;
   }
   
   {
@@ -7678,20 +7860,32 @@ bool Worksheet::FindNext(const wxString &str, bool down, bool ignoreCase, bool w
   GroupCell *start = pos;
 
   bool wrappedSearch = false;
+  std::vector<size_t> matches;
   while (pos != start || !wrappedSearch)
   {
     EditorCell *editor = pos->GetEditable();
 
     if (editor)
     {
-      bool found = editor->FindNext(str, down, ignoreCase);
-
-      if (found)
+      m_cellPointers.m_searchIndex.Find(editor, editor->GetTextRevision(), editor->GetValue(), str, ignoreCase, matches);
+
+      // Search from the selection or the cursor, if there is one
+      size_t searchStart = down ? 0 : editor->GetValue().Length() + 1;
+      int selectionStart, selectionEnd;
+      editor->GetSelection(&selectionStart, &selectionEnd);
+      if (selectionStart >= 0)
+        searchStart = down ? selectionStart + 1 : selectionStart;
+      else if (editor->IsActive())
+        searchStart = editor->GetCaretPosition();
+
+      auto match = std::lower_bound(matches.begin(), matches.end(), searchStart);
+      if (!down)
+        match = (match != matches.begin()) ? match - 1 : matches.end();
+
+      if (match != matches.end())
       {
-        int strt, end;
-        editor->GetSelection(&strt, &end);
         SetActiveCell(editor);
-        editor->SetSelection(strt, end);
+        editor->SetSelection(*match, *match + str.Length());
         ScrollToCaret();
         UpdateTableOfContents();
         RequestRedraw();
@@ -7824,11 +8018,16 @@ int Worksheet::ReplaceAll(const wxString &oldString, const wxString &newString,
     return 0;
 
   int count = 0;
+  std::vector<size_t> matches;
+  m_cellPointers.m_searchIndex.StartSweep();
   for (GroupCell *tmp = GetTree(); tmp; tmp = tmp->GetNext())
   {
     EditorCell *editor = tmp->GetEditable();
     if (editor)
     {
+      m_cellPointers.m_searchIndex.Find(editor, editor->GetTextRevision(), editor->GetValue(), oldString, ignoreCase, matches);
+      if (matches.empty())
+        continue;
       SetActiveCell(editor);
       int replaced = editor->ReplaceAll(oldString, newString, ignoreCase);
       if (replaced > 0)
@@ -7840,6 +8039,8 @@ int Worksheet::ReplaceAll(const wxString &oldString, const wxString &newString,
     }
   }
 
+  m_cellPointers.m_searchIndex.EndSweep();
+
   if (count > 0)
   {
     SetSaved(false);
@@ -7850,6 +8051,44 @@ int Worksheet::ReplaceAll(const wxString &oldString, const wxString &newString,
   return count;
 }
 
+int Worksheet::CountMatches(const wxString &str, bool ignoreCase)
+{
+  int count = 0;
+  std::vector<size_t> matches;
+  m_cellPointers.m_searchIndex.StartSweep();
+  for (GroupCell *tmp = GetTree(); tmp; tmp = tmp->GetNext())
+  {
+    EditorCell *editor = tmp->GetEditable();
+    if (editor)
+    {
+      m_cellPointers.m_searchIndex.Find(editor, editor->GetTextRevision(), editor->GetValue(), str, ignoreCase, matches);
+      count += matches.size();
+    }
+  }
+  m_cellPointers.m_searchIndex.EndSweep();
+  return count;
+}
+
+void Worksheet::CloseFindDialog()
+{
+  if (m_findDialog)
+    m_findDialog->Destroy();
+  m_findDialog = NULL;
+  HighlightMatches(wxEmptyString, false);
+  // Until the next search the index would only occupy memory.
+  m_cellPointers.m_searchIndex.Clear();
+}
+
+void Worksheet::HighlightMatches(const wxString &str, bool ignoreCase)
+{
+  if ((m_cellPointers.m_searchHighlight == str) &&
+      (m_cellPointers.m_searchHighlightIgnoreCase == ignoreCase))
+    return;
+  m_cellPointers.m_searchHighlight = str;
+  m_cellPointers.m_searchHighlightIgnoreCase = ignoreCase;
+  RequestRedraw();
+}
+
 bool Worksheet::Autocomplete(AutoComplete::autoCompletionType type)
 {
   EditorCell *editor = GetActiveCell();
@@ -7997,9 +8236,12 @@ bool Worksheet::Autocomplete(AutoComplete::autoCompletionType type)
   }
 
   m_completions = m_autocomplete.CompleteSymbol(partial, type);
-  m_completions.Sort();
   m_autocompleteTemplates = (type == AutoComplete::tmplte);
 
+  /// No word starts with partial - perhaps the user has typed only some of its letters
+  if (m_completions.GetCount() == 0)
+    m_completions = m_autocomplete.CompleteSymbolFuzzy(partial, type);
+
   /// No completions - clear the selection and return false
   if (m_completions.GetCount() == 0)
   {
@@ -49,10 +49,12 @@
 #include "EvaluationQueue.h"
 #include "FindReplaceDialog.h"
 #include "Autocomplete.h"
+#include "EditDistanceSearch.h"
 #include "AutocompletePopup.h"
 #include "TableOfContents.h"
 #include "UnicodeSidebar.h"
 #include "ToolBar.h"
+#include "WXMXContentWriter.h"
 
 /*! The canvas that contains the spreadsheet the whole program is about.
 
@@ -206,6 +208,17 @@ private:
   long m_lastTop;
   //! The last ending for the area being drawn
   long m_lastBottom;
+  //! Move a GroupCell to the front of CellPointers::m_loadedOutputs and unload the outputs that haven't been seen for long
+  void OutputLoaded(GroupCell *group);
+  //! The start tag of the root element of a .wxmx file's content.xml
+  wxString WXMXDocumentTag();
+  /*! Draw a GroupCell by blitting the bitmap it has been drawn into the last time
+
+    Draws the cell into a new bitmap first, if it doesn't have one, yet.
+    \return false, if the cell's looks might change without it being
+    recalculated, which means that it has to be drawn directly.
+  */
+  bool DrawGroupCellCached(GroupCell *group, wxPoint point);
   /*! \defgroup UndoBufferFill Undo methods for cell additions/deletions:
 
     Each EditorCell has its own private undo buffer Additionally wxMaxima
@@ -777,6 +790,8 @@ public:
 
   //! The find-and-replace-dialog
   FindReplaceDialog *m_findDialog;
+  //! Closes the find-and-replace-dialog and drops the search index it has used
+  void CloseFindDialog();
 
   /*! True = schedule an update of the table of contents
 
@@ -929,7 +944,25 @@ public:
   */
   void InsertLine(std::unique_ptr<Cell> &&newCell, bool forceNewLine = false);
 
-  // Actually recalculate the worksheet.
+  /*! Add a new line to the output of the working group without generating cells for it
+
+    Only does something if Configuration::LazyOutput() is set and the working group
+    currently cannot be seen. The cells are generated when the GroupCell is drawn.
+
+    \return false, if the line has to be parsed and added using InsertLine(), instead.
+  */
+  bool InsertLineLazily(const wxString &xml, CellType type, bool forceNewLine, bool bigSkip,
+                        const wxString &userLabel);
+
+  /*! Actually recalculate the worksheet.
+
+    The GroupCells are recalculated one after another on the GUI thread: They
+    measure their text using the wxDC Configuration::GetDC() provides and fonts
+    from FontCache, which only is thread-local on MS Windows. wxWidgets doesn't
+    allow using fonts and DCs from other threads on the other platforms.
+    Configuration::LazyLayout() therefore is the way to make recalculating
+    huge worksheets fast.
+  */
   bool RecalculateIfNeeded();
 
   //! Schedule a recalculation of the worksheet starting with the cell start.
@@ -1115,6 +1148,13 @@ public:
   */
   bool ExportToWXMX(const wxString &file, bool markAsSaved = true);
 
+  /*! Collects the contents of a .wxmx file for writing it in the background
+
+    Reuses the XML and images of all GroupCells that haven't changed since
+    the last call.
+  */
+  std::shared_ptr<WXMXSnapshot> CreateWXMXSnapshot();
+
   //! The start of a RTF document
   wxString RTFStart() const;
 
@@ -1441,6 +1481,18 @@ public:
    */
   int ReplaceAll(const wxString &oldString, const wxString &newString, bool ignoreCase);
 
+  /*! Count all occurrences of a string in the editable parts of the worksheet
+
+    Used by the find dialog.
+   */
+  int CountMatches(const wxString &str, bool ignoreCase);
+
+  /*! Highlight all occurrences of a string in the editable parts of the worksheet
+
+    Used by the find dialog. An empty string turns the highlighting off.
+   */
+  void HighlightMatches(const wxString &str, bool ignoreCase);
+
   wxString GetInputAboveCaret();
 
   wxString GetOutputAboveCaret();
@@ -1525,6 +1577,8 @@ public:
 
   //! All anchors for keywords maxima's helpfile contains
   HelpFileAnchors m_helpFileAnchors;
+  //! Finds the anchors that are similar to a word. Made from m_helpFileAnchors on demand.
+  EditDistanceSearch m_helpFileAnchorsSearch;
   //! Is the help file anchors available
   bool m_helpFileAnchorsUsable;
   //! Suggestions for how the word that was right-clicked on could continue
@@ -1583,8 +1637,20 @@ protected:
   AccessibilityInfo *m_accessibilityInfo;
 #endif
   void UpdateConfigurationClientSize();
+  /*! Recalculates the cells Configuration::LazyLayout() has skipped that now are in region
+
+    Only looks at the cells between m_recalculateLaterFirst and the end of region
+    and narrows that range down to the cells that still are skipped.
+   */
+  void RecalculateSkipped(const wxRect &region);
   //! Where to start recalculation. NULL = No recalculation needed.
   GroupCell *m_recalculateStart;
+  //! The first cell Configuration::LazyLayout() made us skip while recalculating
+  CellPtr<GroupCell> m_recalculateLaterFirst;
+  //! The last cell Configuration::LazyLayout() made us skip while recalculating
+  CellPtr<GroupCell> m_recalculateLaterLast;
+  //! The visible part of the worksheet the skipped cells have last been checked against
+  wxRect m_recalculateLaterView;
   //! The x position of the mouse pointer
   int m_pointer_x;
   //! The y position of the mouse pointer
@@ -0,0 +1,376 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class XmlPullParser that splits a XML string into tags and text.
+ */
+
+#include "XmlPullParser.h"
+
+wxString XmlPullParser::Attributes::Get(const wxString &name, const wxString &defaultValue) const
+{
+  for (auto const &attr : m_attributes)
+    if (attr.first == name)
+      return attr.second;
+  return defaultValue;
+}
+
+bool XmlPullParser::Attributes::Get(const wxString &name, wxString *value) const
+{
+  for (auto const &attr : m_attributes)
+    if (attr.first == name)
+    {
+      *value = attr.second;
+      return true;
+    }
+  return false;
+}
+
+XmlPullParser::XmlPullParser(const wxString &xml) :
+  m_pos(xml.begin()),
+  m_end(xml.end()),
+  m_tagStart(xml.begin())
+{
+}
+
+bool XmlPullParser::SkipElement(wxString &xml)
+{
+  wxString::const_iterator start = m_tagStart;
+  size_t depth = GetDepth();
+  while (GetDepth() >= depth)
+  {
+    Event event = Next();
+    if ((event == EndOfDocument) || (event == Error))
+      return false;
+  }
+  xml = wxString(start, m_pos);
+  return true;
+}
+
+XmlPullParser::Event XmlPullParser::Next()
+{
+  if (m_pendingEnd)
+  {
+    // The 2nd half of an empty-element tag
+    m_pendingEnd = false;
+    m_name = m_openElements.back();
+    m_openElements.pop_back();
+    m_rootClosed = m_openElements.empty();
+    return EndElement;
+  }
+
+  m_text.Clear();
+  while (m_pos != m_end)
+  {
+    if (*m_pos == wxT('<'))
+    {
+      if (Skip(wxT("<![CDATA[")))
+      {
+        // Collect the CDATA section's contents as text
+        wxString contents;
+        while ((m_pos != m_end) && !contents.EndsWith(wxT("]]>")))
+        {
+          contents += *m_pos;
+          ++m_pos;
+        }
+        if (!contents.EndsWith(wxT("]]>")))
+          return Error;
+        contents.RemoveLast(3);
+        m_text += contents;
+        continue;
+      }
+      if (Skip(wxT("<!--")))
+      {
+        if (!SkipPast(wxT("-->")))
+          return Error;
+        continue;
+      }
+      // A processing instruction or the <?xml?> declaration
+      if (Skip(wxT("<?")))
+      {
+        if (!SkipPast(wxT("?>")))
+          return Error;
+        continue;
+      }
+      // We don't support DTDs
+      if (LookingAt(wxT("<!")))
+        return Error;
+
+      // Text ends here: Return it and leave the tag for the next call
+      if (!m_text.IsEmpty())
+      {
+        if (!m_openElements.empty())
+          return Text;
+        if (!m_text.Trim().IsEmpty())
+          return Error;
+        m_text.Clear();
+      }
+      m_tagStart = m_pos;
+      ++m_pos;
+      return ReadTag();
+    }
+
+    if (*m_pos == wxT('&'))
+    {
+      ++m_pos;
+      if (!ReadEntity(m_text))
+        return Error;
+      continue;
+    }
+
+    auto start = m_pos;
+    while ((m_pos != m_end) && (*m_pos != wxT('<')) && (*m_pos != wxT('&')))
+      ++m_pos;
+    m_text += wxString(start, m_pos);
+  }
+
+  if (!m_openElements.empty())
+    return Error;
+  if (!m_text.Trim().IsEmpty())
+    return Error;
+  if (!m_rootClosed)
+    return Error;
+  return EndOfDocument;
+}
+
+XmlPullParser::Event XmlPullParser::ReadTag()
+{
+  if (m_pos == m_end)
+    return Error;
+
+  if (*m_pos == wxT('/'))
+  {
+    ++m_pos;
+    if (!ReadName(m_name))
+      return Error;
+    SkipWhitespace();
+    if ((m_pos == m_end) || (*m_pos != wxT('>')))
+      return Error;
+    ++m_pos;
+    if (m_openElements.empty() || (m_openElements.back() != m_name))
+      return Error;
+    m_openElements.pop_back();
+    m_rootClosed = m_openElements.empty();
+    return EndElement;
+  }
+
+  // XML allows only one root element
+  if (m_rootClosed)
+    return Error;
+
+  if (!ReadName(m_name))
+    return Error;
+  m_attributes.Clear();
+  while (true)
+  {
+    SkipWhitespace();
+    if (m_pos == m_end)
+      return Error;
+    if (*m_pos == wxT('/'))
+    {
+      ++m_pos;
+      if ((m_pos == m_end) || (*m_pos != wxT('>')))
+        return Error;
+      ++m_pos;
+      m_openElements.push_back(m_name);
+      m_pendingEnd = true;
+      return StartElement;
+    }
+    if (*m_pos == wxT('>'))
+    {
+      ++m_pos;
+      m_openElements.push_back(m_name);
+      return StartElement;
+    }
+    wxString attrName;
+    wxString attrValue;
+    if (!ReadName(attrName))
+      return Error;
+    SkipWhitespace();
+    if ((m_pos == m_end) || (*m_pos != wxT('=')))
+      return Error;
+    ++m_pos;
+    SkipWhitespace();
+    if (!ReadAttributeValue(attrValue))
+      return Error;
+    // XML doesn't allow an attribute to appear twice in the same tag
+    if (m_attributes.Get(attrName, &attrValue))
+      return Error;
+    m_attributes.Add(attrName, attrValue);
+  }
+}
+
+bool XmlPullParser::ReadName(wxString &name)
+{
+  // Names may contain, but not start with, digits, dashes and dots
+  if ((m_pos == m_end) ||
+      ((*m_pos >= wxT('0')) && (*m_pos <= wxT('9'))) ||
+      (*m_pos == wxT('-')) || (*m_pos == wxT('.')))
+    return false;
+  auto start = m_pos;
+  while (m_pos != m_end)
+  {
+    wxUniChar ch = *m_pos;
+    if (!(((ch >= wxT('a')) && (ch <= wxT('z'))) ||
+          ((ch >= wxT('A')) && (ch <= wxT('Z'))) ||
+          ((ch >= wxT('0')) && (ch <= wxT('9'))) ||
+          (ch == wxT('_')) || (ch == wxT(':')) ||
+          (ch == wxT('-')) || (ch == wxT('.')) ||
+          (ch >= 0x80)))
+      break;
+    ++m_pos;
+  }
+  if (start == m_pos)
+    return false;
+  name = wxString(start, m_pos);
+  return true;
+}
+
+bool XmlPullParser::ReadAttributeValue(wxString &value)
+{
+  if (m_pos == m_end)
+    return false;
+  wxUniChar quote = *m_pos;
+  if ((quote != wxT('"')) && (quote != wxT('\'')))
+    return false;
+  ++m_pos;
+  while (m_pos != m_end)
+  {
+    if (*m_pos == quote)
+    {
+      ++m_pos;
+      return true;
+    }
+    if (*m_pos == wxT('<'))
+      return false;
+    if (*m_pos == wxT('&'))
+    {
+      ++m_pos;
+      if (!ReadEntity(value))
+        return false;
+      continue;
+    }
+    auto start = m_pos;
+    while ((m_pos != m_end) && (*m_pos != quote) && (*m_pos != wxT('<')) && (*m_pos != wxT('&')))
+      ++m_pos;
+    value += wxString(start, m_pos);
+  }
+  return false;
+}
+
+bool XmlPullParser::ReadEntity(wxString &text)
+{
+  wxString entity;
+  while ((m_pos != m_end) && (*m_pos != wxT(';')))
+  {
+    // No entity we know of is that long
+    if (entity.Length() > 10)
+      return false;
+    entity += *m_pos;
+    ++m_pos;
+  }
+  if (m_pos == m_end)
+    return false;
+  ++m_pos;
+
+  if (entity == wxT("lt"))
+    text += wxT('<');
+  else if (entity == wxT("gt"))
+    text += wxT('>');
+  else if (entity == wxT("amp"))
+    text += wxT('&');
+  else if (entity == wxT("quot"))
+    text += wxT('"');
+  else if (entity == wxT("apos"))
+    text += wxT('\'');
+  else if (entity.StartsWith(wxT("#")))
+  {
+    bool hex = entity.StartsWith(wxT("#x"));
+    wxString digits = entity.Mid(hex ? 2 : 1);
+    if (digits.IsEmpty())
+      return false;
+    // ToULong() would accept signs and leading whitespace, too
+    for (auto ch : digits)
+      if (!(((ch >= wxT('0')) && (ch <= wxT('9'))) ||
+            (hex && (((ch >= wxT('a')) && (ch <= wxT('f'))) ||
+                     ((ch >= wxT('A')) && (ch <= wxT('F')))))))
+        return false;
+    unsigned long code;
+    if (!digits.ToULong(&code, hex ? 16 : 10))
+      return false;
+    // Only references to chars XML allows in a document are valid
+    if (!((code == 0x09) || (code == 0x0A) || (code == 0x0D) ||
+          ((code >= 0x20) && (code <= 0xD7FF)) ||
+          ((code >= 0xE000) && (code <= 0xFFFD)) ||
+          ((code >= 0x10000) && (code <= 0x10FFFF))))
+      return false;
+    text += wxUniChar(static_cast<wxUint32>(code));
+  }
+  else
+    return false;
+  return true;
+}
+
+void XmlPullParser::SkipWhitespace()
+{
+  while ((m_pos != m_end) &&
+         ((*m_pos == wxT(' ')) || (*m_pos == wxT('\t')) ||
+          (*m_pos == wxT('\n')) || (*m_pos == wxT('\r'))))
+    ++m_pos;
+}
+
+bool XmlPullParser::LookingAt(const wxString &text) const
+{
+  auto pos = m_pos;
+  for (auto ch : text)
+  {
+    if ((pos == m_end) || (*pos != ch))
+      return false;
+    ++pos;
+  }
+  return true;
+}
+
+bool XmlPullParser::Skip(const wxString &text)
+{
+  if (!LookingAt(text))
+    return false;
+  for (size_t i = 0; i < text.Length(); i++)
+    ++m_pos;
+  return true;
+}
+
+bool XmlPullParser::SkipPast(const wxString &marker)
+{
+  // Only used for rare constructs like comments and processing instructions
+  // => A sliding window is fast enough.
+  wxString window;
+  while (m_pos != m_end)
+  {
+    window += *m_pos;
+    ++m_pos;
+    if (window.Length() > marker.Length())
+      window.Remove(0, 1);
+    if (window == marker)
+      return true;
+  }
+  return false;
+}
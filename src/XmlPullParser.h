@@ -0,0 +1,129 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class XmlPullParser that splits a XML string into tags and text.
+ */
+
+#ifndef XMLPULLPARSER_H
+#define XMLPULLPARSER_H
+
+#include <wx/string.h>
+#include <utility>
+#include <vector>
+
+/*! A minimal pull parser for the XML maxima sends us
+
+  wxXmlDocument converts the string to UTF-8, lets expat parse it and then builds
+  a DOM tree for it that we walk only once and then throw away. This parser instead
+  directly works on the wxString and returns one start tag, end tag or piece of text
+  at a time so the caller can create the cells while reading.
+
+  It understands elements, attributes, text, the predefined and numeric character
+  entities and CDATA sections and skips comments and processing instructions.
+  Everything else (and XML that isn't well-formed) makes Next() return Error.
+ */
+class XmlPullParser
+{
+public:
+  //! What Next() has found
+  enum Event
+  {
+    StartElement,
+    EndElement,
+    Text,
+    EndOfDocument,
+    Error
+  };
+
+  //! The attributes of a start tag
+  class Attributes
+  {
+  public:
+    //! Returns the attribute's value, or defaultValue, if the attribute doesn't exist
+    wxString Get(const wxString &name, const wxString &defaultValue = wxEmptyString) const;
+    //! Returns true and sets value, if the attribute exists
+    bool Get(const wxString &name, wxString *value) const;
+    bool Empty() const { return m_attributes.empty(); }
+    void Clear() { m_attributes.clear(); }
+    void Add(const wxString &name, const wxString &value) { m_attributes.emplace_back(name, value); }
+    const std::vector<std::pair<wxString, wxString>> &GetAll() const { return m_attributes; }
+
+  private:
+    std::vector<std::pair<wxString, wxString>> m_attributes;
+  };
+
+  //! The parser doesn't copy xml => It has to outlive the parser.
+  explicit XmlPullParser(const wxString &xml);
+
+  //! Read the next tag or the next piece of text
+  Event Next();
+
+  //! The name of the tag Next() has found
+  const wxString &GetName() const { return m_name; }
+  //! The attributes of the start tag Next() has found
+  const Attributes &GetAttributes() const { return m_attributes; }
+  //! The text Next() has found, with all character entities resolved
+  const wxString &GetText() const { return m_text; }
+  //! How many elements are open right now?
+  size_t GetDepth() const { return m_openElements.size(); }
+  /*! Reads the rest of the element whose start tag Next() has just returned
+
+    \param xml Receives the element, including its start and end tag, exactly
+    as the document contains it.
+    \return false, if the element isn't well-formed.
+   */
+  bool SkipElement(wxString &xml);
+
+private:
+  //! Reads a tag. m_pos points to the char after the "<".
+  Event ReadTag();
+  //! Reads a name. Returns false if there is no valid name at m_pos
+  bool ReadName(wxString &name);
+  //! Reads an attribute value. m_pos points to the opening quote.
+  bool ReadAttributeValue(wxString &value);
+  //! Resolves a character entity. m_pos points to the char after the "&".
+  bool ReadEntity(wxString &text);
+  //! Skips whitespace
+  void SkipWhitespace();
+  //! True if the text at m_pos starts with text
+  bool LookingAt(const wxString &text) const;
+  //! Skips text, if the text at m_pos starts with it
+  bool Skip(const wxString &text);
+  //! Skips everything until (and including) marker. Returns false if the marker wasn't found.
+  bool SkipPast(const wxString &marker);
+
+  wxString::const_iterator m_pos;
+  wxString::const_iterator m_end;
+  //! Where the tag Next() has read last begins
+  wxString::const_iterator m_tagStart;
+  wxString m_name;
+  wxString m_text;
+  Attributes m_attributes;
+  //! The names of all elements we haven't seen the end tag of, yet
+  std::vector<wxString> m_openElements;
+  //! True if the last start tag was an empty-element tag like <mspace/>
+  bool m_pendingEnd = false;
+  //! True if we have seen the root element's end tag
+  bool m_rootClosed = false;
+};
+
+#endif // XMLPULLPARSER_H
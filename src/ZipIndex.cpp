@@ -0,0 +1,397 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file defines the class ZipIndex that reads the entries of a .wxmx file.
+ */
+
+#include "ZipIndex.h"
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+#include <wx/log.h>
+#include <wx/intl.h>
+#include <algorithm>
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//! The size of the fixed part of a zip entry's local header
+static constexpr size_t localHeaderSize = 30;
+//! The size of the fixed part of a central directory entry
+static constexpr size_t centralHeaderSize = 46;
+//! The size of the "end of central directory" record, without the comment
+static constexpr size_t endRecordSize = 22;
+//! The chars 0x80-0xff of code page 437, which the names of zip entries are in by default
+static const wxUint16 cp437[128] = {
+  0x00c7, 0x00fc, 0x00e9, 0x00e2, 0x00e4, 0x00e0, 0x00e5, 0x00e7,
+  0x00ea, 0x00eb, 0x00e8, 0x00ef, 0x00ee, 0x00ec, 0x00c4, 0x00c5,
+  0x00c9, 0x00e6, 0x00c6, 0x00f4, 0x00f6, 0x00f2, 0x00fb, 0x00f9,
+  0x00ff, 0x00d6, 0x00dc, 0x00a2, 0x00a3, 0x00a5, 0x20a7, 0x0192,
+  0x00e1, 0x00ed, 0x00f3, 0x00fa, 0x00f1, 0x00d1, 0x00aa, 0x00ba,
+  0x00bf, 0x2310, 0x00ac, 0x00bd, 0x00bc, 0x00a1, 0x00ab, 0x00bb,
+  0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556,
+  0x2555, 0x2563, 0x2551, 0x2557, 0x255d, 0x255c, 0x255b, 0x2510,
+  0x2514, 0x2534, 0x252c, 0x251c, 0x2500, 0x253c, 0x255e, 0x255f,
+  0x255a, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256c, 0x2567,
+  0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256b,
+  0x256a, 0x2518, 0x250c, 0x2588, 0x2584, 0x258c, 0x2590, 0x2580,
+  0x03b1, 0x00df, 0x0393, 0x03c0, 0x03a3, 0x03c3, 0x00b5, 0x03c4,
+  0x03a6, 0x0398, 0x03a9, 0x03b4, 0x221e, 0x03c6, 0x03b5, 0x2229,
+  0x2261, 0x00b1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00f7, 0x2248,
+  0x00b0, 0x2219, 0x00b7, 0x221a, 0x207f, 0x00b2, 0x25a0, 0x00a0
+};
+
+static wxUint16 Read16(const unsigned char *data)
+{
+  return data[0] | (data[1] << 8);
+}
+
+static wxUint32 Read32(const unsigned char *data)
+{
+  return wxUint32(data[0]) | (wxUint32(data[1]) << 8) |
+    (wxUint32(data[2]) << 16) | (wxUint32(data[3]) << 24);
+}
+
+static wxUint64 Read64(const unsigned char *data)
+{
+  return wxUint64(Read32(data)) | (wxUint64(Read32(data + 4)) << 32);
+}
+
+ZipIndex::ZipIndex(const wxString &zipfile) :
+  m_fileName(zipfile)
+{
+  if (!Map())
+    return;
+  m_ok = ReadCentralDirectory();
+  if (m_ok)
+    wxLogMessage(_("Indexed %lu files in %s"), static_cast<unsigned long>(m_entries.size()),
+                 zipfile.utf8_str());
+  else
+    wxLogMessage(_("%s isn't a zip archive we can read"), zipfile.utf8_str());
+}
+
+ZipIndex::~ZipIndex()
+{
+  Unmap();
+}
+
+bool ZipIndex::Map()
+{
+#ifdef __WXMSW__
+  HANDLE handle = CreateFileW(m_fileName.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle != INVALID_HANDLE_VALUE)
+  {
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(handle, &size) && (size.QuadPart > 0))
+    {
+      HANDLE mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping)
+      {
+        void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data)
+        {
+          m_data = static_cast<const unsigned char *>(data);
+          m_size = static_cast<size_t>(size.QuadPart);
+          m_mappingHandle = mapping;
+        }
+        else
+          CloseHandle(mapping);
+      }
+    }
+    // The mapping keeps the file open.
+    CloseHandle(handle);
+  }
+#else
+  int handle = open(m_fileName.fn_str(), O_RDONLY);
+  if (handle >= 0)
+  {
+    struct stat status;
+    if ((fstat(handle, &status) == 0) && (status.st_size > 0))
+    {
+      void *data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+      if (data != MAP_FAILED)
+      {
+        m_data = static_cast<const unsigned char *>(data);
+        m_size = static_cast<size_t>(status.st_size);
+      }
+    }
+    // The mapping keeps the file open.
+    close(handle);
+  }
+#endif
+  if (m_data)
+    return true;
+
+  // If the OS doesn't let us map the file we read it instead.
+  if (!wxFileExists(m_fileName))
+    return false;
+  wxFFile file(m_fileName, wxT("rb"));
+  if (!file.IsOpened())
+    return false;
+  wxFileOffset length = file.Length();
+  if (length <= 0)
+    return false;
+  size_t read = file.Read(m_fileContents.GetWriteBuf(length), length);
+  m_fileContents.UngetWriteBuf(read);
+  if (read != static_cast<size_t>(length))
+    return false;
+  m_data = static_cast<const unsigned char *>(m_fileContents.GetData());
+  m_size = read;
+  return true;
+}
+
+void ZipIndex::Unmap()
+{
+  if (!m_data || (m_fileContents.GetDataLen() > 0))
+    return;
+#ifdef __WXMSW__
+  UnmapViewOfFile(m_data);
+  CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+#else
+  munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+  m_data = nullptr;
+}
+
+bool ZipIndex::ReadCentralDirectory()
+{
+  if (m_size < endRecordSize)
+    return false;
+
+  // The "end of central directory" record is followed by a comment of up to
+  // 64k => search backwards for its signature.
+  size_t endRecord = m_size - endRecordSize;
+  size_t searchLimit = (endRecord > 65535) ? endRecord - 65535 : 0;
+  while (Read32(m_data + endRecord) != 0x06054b50)
+  {
+    if (endRecord == searchLimit)
+      return false;
+    endRecord--;
+  }
+
+  wxInt64 offsetAdjustment = 0;
+  wxUint64 entries = Read16(m_data + endRecord + 10);
+  wxUint64 directorySize = Read32(m_data + endRecord + 12);
+  wxUint64 directoryOffset = Read32(m_data + endRecord + 16);
+
+  // Archives > 4GB or with more than 65535 entries use the Zip64 version
+  // of the record that is located by a record just before the normal one.
+  if ((directoryOffset == 0xffffffff) || (entries == 0xffff))
+  {
+    if (endRecord < 20)
+      return false;
+    const unsigned char *locator = m_data + endRecord - 20;
+    if (Read32(locator) != 0x07064b50)
+      return false;
+    wxUint64 zip64EndRecord = Read64(locator + 8);
+    if ((m_size < 56) || (zip64EndRecord > m_size - 56) ||
+        (Read32(m_data + zip64EndRecord) != 0x06064b50))
+      return false;
+    entries = Read64(m_data + zip64EndRecord + 32);
+    directorySize = Read64(m_data + zip64EndRecord + 40);
+    directoryOffset = Read64(m_data + zip64EndRecord + 48);
+  }
+  else if ((directorySize <= endRecord) && (endRecord - directorySize != directoryOffset))
+  {
+    // Archives with data in front of them (and some broken .wxmx files) have
+    // shifted offsets. The central directory normally ends where the end
+    // record begins, which tells how far.
+    wxUint64 directoryStart = endRecord - directorySize;
+    if (Read32(m_data + directoryStart) == 0x02014b50)
+    {
+      offsetAdjustment = static_cast<wxInt64>(directoryStart) - static_cast<wxInt64>(directoryOffset);
+      directoryOffset = directoryStart;
+    }
+  }
+  if ((directoryOffset > m_size) || (directorySize > m_size - directoryOffset))
+    return false;
+
+  const unsigned char *pos = m_data + directoryOffset;
+  const unsigned char *end = pos + directorySize;
+  // Don't trust the number of entries of a broken file too much.
+  m_entries.reserve(std::min<wxUint64>(entries, directorySize / centralHeaderSize));
+  for (wxUint64 i = 0; i < entries; i++)
+  {
+    if ((end - pos < static_cast<ptrdiff_t>(centralHeaderSize)) || (Read32(pos) != 0x02014b50))
+      return false;
+    wxUint16 flags = Read16(pos + 8);
+    Entry entry;
+    entry.method = Read16(pos + 10);
+    wxUint64 compressedSize = Read32(pos + 20);
+    wxUint64 size = Read32(pos + 24);
+    size_t nameLength = Read16(pos + 28);
+    size_t extraLength = Read16(pos + 30);
+    size_t commentLength = Read16(pos + 32);
+    wxUint64 offset = Read32(pos + 42);
+    if (static_cast<size_t>(end - pos) < centralHeaderSize + nameLength + extraLength + commentLength)
+      return false;
+
+    const char *name = reinterpret_cast<const char *>(pos + centralHeaderSize);
+    // Bit 11 tells that the name is UTF-8. If it isn't it is CP437.
+    wxString entryName;
+    if (flags & 0x800)
+      entryName = wxString::FromUTF8(name, nameLength);
+    else
+      for (size_t j = 0; j < nameLength; j++)
+      {
+        unsigned char ch = name[j];
+        entryName += (ch < 0x80) ? wxUniChar(ch) : wxUniChar(cp437[ch - 0x80]);
+      }
+
+    // The Zip64 extra field contains the values that didn't fit into 32 bits.
+    const unsigned char *extra = pos + centralHeaderSize + nameLength;
+    const unsigned char *extraEnd = extra + extraLength;
+    while (extraEnd - extra >= 4)
+    {
+      wxUint16 id = Read16(extra);
+      size_t length = Read16(extra + 2);
+      const unsigned char *field = extra + 4;
+      if (static_cast<size_t>(extraEnd - field) < length)
+        break;
+      if (id == 0x0001)
+      {
+        const unsigned char *fieldEnd = field + length;
+        if ((size == 0xffffffff) && (fieldEnd - field >= 8))
+        {
+          size = Read64(field);
+          field += 8;
+        }
+        if ((compressedSize == 0xffffffff) && (fieldEnd - field >= 8))
+        {
+          compressedSize = Read64(field);
+          field += 8;
+        }
+        if ((offset == 0xffffffff) && (fieldEnd - field >= 8))
+          offset = Read64(field);
+      }
+      extra += 4 + length;
+    }
+    pos += centralHeaderSize + nameLength + extraLength + commentLength;
+
+    if (entryName.EndsWith(wxT("/")))
+      continue;
+    // Skip entries that cannot be right, but keep the rest of the archive.
+    if (!HasLocalHeader(offset))
+    {
+      offset += offsetAdjustment;
+      if (!HasLocalHeader(offset))
+        continue;
+    }
+    if (compressedSize > m_size)
+      continue;
+    entry.offset = offset;
+    entry.compressedSize = compressedSize;
+    entry.size = size;
+    m_entries[Normalize(entryName)] = entry;
+  }
+  return true;
+}
+
+bool ZipIndex::HasLocalHeader(wxUint64 offset) const
+{
+  return (offset < m_size) && (m_size - offset >= localHeaderSize) &&
+    (Read32(m_data + offset) == 0x04034b50);
+}
+
+const char *ZipIndex::GetData(const Entry &entry) const
+{
+  // The central directory doesn't tell the length of the local header's
+  // "extra" field => we need to read the local header.
+  if (!HasLocalHeader(entry.offset))
+    return NULL;
+  const unsigned char *header = m_data + entry.offset;
+  size_t dataOffset = entry.offset + localHeaderSize + Read16(header + 26) + Read16(header + 28);
+  if ((dataOffset > m_size) || (m_size - dataOffset < entry.compressedSize))
+    return NULL;
+  return reinterpret_cast<const char *>(m_data + dataOffset);
+}
+
+wxString ZipIndex::Normalize(const wxString &name)
+{
+  size_t start = 0;
+  while (true)
+  {
+    if (name.compare(start, 1, wxT("/")) == 0)
+      start += 1;
+    else if (name.compare(start, 2, wxT("./")) == 0)
+      start += 2;
+    else
+      break;
+  }
+  return name.Mid(start);
+}
+
+const ZipIndex::Entry *ZipIndex::Find(const wxString &name) const
+{
+  auto it = m_entries.find(Normalize(name));
+  if (it == m_entries.end())
+    return NULL;
+  return &it->second;
+}
+
+bool ZipIndex::Contains(const wxString &name) const
+{
+  return Find(name) != NULL;
+}
+
+std::unique_ptr<wxInputStream> ZipIndex::OpenEntry(const wxString &name) const
+{
+  const Entry *entry = Find(name);
+  if (!entry)
+    return {};
+  if ((entry->method != 0) && (entry->method != 8))
+  {
+    wxLogMessage(_("%s uses an unsupported compression method"), name.utf8_str());
+    return {};
+  }
+  const char *data = GetData(*entry);
+  if (!data)
+    return {};
+
+  // wxMemoryInputStream doesn't copy the data it reads from.
+  auto stream = std::unique_ptr<wxInputStream>(new wxMemoryInputStream(data, entry->compressedSize));
+  if (entry->method == 0)
+    return stream;
+  // Zip archives contain raw deflate data without a zlib header.
+  return std::unique_ptr<wxInputStream>(new wxZlibInputStream(stream.release(), wxZLIB_NO_HEADER));
+}
+
+wxMemoryBuffer ZipIndex::Read(const wxString &name) const
+{
+  wxMemoryBuffer retval;
+  const Entry *entry = Find(name);
+  if (!entry || (entry->size == 0))
+    return retval;
+  std::unique_ptr<wxInputStream> stream = OpenEntry(name);
+  if (!stream)
+    return retval;
+  stream->Read(retval.GetWriteBuf(entry->size), entry->size);
+  retval.UngetWriteBuf(stream->LastRead());
+  return retval;
+}
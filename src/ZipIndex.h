@@ -0,0 +1,119 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  This file declares the class ZipIndex that reads the entries of a .wxmx file.
+ */
+
+#ifndef ZIPINDEX_H
+#define ZIPINDEX_H
+
+#include <wx/string.h>
+#include <wx/buffer.h>
+#include <wx/hashmap.h>
+#include <wx/stream.h>
+#include <memory>
+#include <unordered_map>
+
+/*! Random access to the files in a zip archive
+
+  wxFileSystem's "#zip:" handler opens and scans the archive each time a file
+  from it is opened and isn't thread-safe, which means that all background
+  tasks that load an image from a .wxmx file had to wait for each other.
+
+  This class maps the archive into memory and parses its central directory
+  once. Files that are stored without compression (which is what we do for
+  images and gnuplot sources) can be read directly from the mapping, the others
+  are inflated only when, and while, they are read. Nothing is modified after
+  the constructor has run, so any number of threads can read entries at the
+  same time without locking.
+
+  The file stays mapped for as long as this object exists. On MS Windows a
+  mapped file cannot be replaced which means that nobody should keep an index
+  after the file has been loaded.
+ */
+class ZipIndex
+{
+public:
+  //! Maps zipfile into memory and reads its central directory
+  explicit ZipIndex(const wxString &zipfile);
+  ~ZipIndex();
+  ZipIndex(const ZipIndex &) = delete;
+  ZipIndex &operator=(const ZipIndex &) = delete;
+
+  //! Could the central directory be read?
+  bool IsOk() const { return m_ok; }
+  //! Does the archive contain a file with this name?
+  bool Contains(const wxString &name) const;
+  /*! Returns a stream that reads a file from the archive
+
+    Returns NULL if the file doesn't exist. The stream reads from the mapping
+    and therefore must not outlive this object.
+   */
+  std::unique_ptr<wxInputStream> OpenEntry(const wxString &name) const;
+  /*! Returns a copy of the uncompressed contents of a file in the archive
+
+    Returns an empty buffer if the file doesn't exist or cannot be read.
+   */
+  wxMemoryBuffer Read(const wxString &name) const;
+  //! The name of the archive
+  const wxString &GetFileName() const { return m_fileName; }
+
+private:
+  //! Where to find a file within the archive
+  struct Entry
+  {
+    //! The position of the file's local header
+    size_t offset = 0;
+    size_t compressedSize = 0;
+    size_t size = 0;
+    //! 0 = stored, 8 = deflated
+    int method = 0;
+  };
+  //! Maps the file into memory. Falls back to reading it, if that fails.
+  bool Map();
+  //! Releases the mapping
+  void Unmap();
+  //! Fills m_entries from the central directory
+  bool ReadCentralDirectory();
+  //! Is there a local header at this offset?
+  bool HasLocalHeader(wxUint64 offset) const;
+  //! Returns the address of an entry's data or NULL if the local header is broken
+  const char *GetData(const Entry &entry) const;
+  //! Looks up an entry by name
+  const Entry *Find(const wxString &name) const;
+  //! Removes a leading "/" or "./" from the name of an entry
+  static wxString Normalize(const wxString &name);
+
+  std::unordered_map<wxString, Entry, wxStringHash, wxStringEqual> m_entries;
+  wxString m_fileName;
+  //! The contents of the file
+  const unsigned char *m_data = nullptr;
+  //! The length of the file
+  size_t m_size = 0;
+  //! The handle of the file mapping on MS Windows
+  void *m_mappingHandle = nullptr;
+  //! Only used if the file cannot be mapped into memory
+  wxMemoryBuffer m_fileContents;
+  bool m_ok = false;
+};
+
+#endif // ZIPINDEX_H
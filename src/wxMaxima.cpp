@@ -77,7 +77,6 @@
 #include <wx/clipbrd.h>
 #include <wx/filedlg.h>
 #include <wx/utils.h>
-#include <wx/uri.h>
 #include <wx/msgdlg.h>
 #include <wx/textfile.h>
 #include <wx/tokenzr.h>
@@ -238,6 +237,7 @@ wxMaxima::wxMaxima(wxWindow *parent, int id, wxLocale *locale, const wxString ti
   m_maximaStderr = NULL;
   m_ready = false;
   m_first = true;
+  m_tagEndSearchStart = 0;
   m_dispReadOut = false;
 
   m_server = NULL;
@@ -1290,6 +1290,12 @@ void wxMaxima::DoConsoleAppend(wxString s, CellType type, AppendOpt opts, const
 
   s.Replace(wxT("\n"), wxT(" "), true);
 
+  // Output nobody can see yet doesn't need to be converted to cells, yet.
+  if ((type == MC_TYPE_DEFAULT) && !(opts & AppendOpt::PromptToolTip) &&
+      m_worksheet->InsertLineLazily(s, type, opts & AppendOpt::NewLine,
+                                    opts & AppendOpt::BigSkip, userLabel))
+    return;
+
   m_parser.SetUserLabel(userLabel);
   std::unique_ptr<Cell> cell(m_parser.ParseLine(s, type));
 
@@ -1581,41 +1587,28 @@ void wxMaxima::TryToReadDataFromMaxima()
   // data and before we had been able to process it.
   if(m_client == NULL)
     return;
-  if(m_clientStream == NULL)
+  if(m_clientReader == NULL)
     return;
   if(!m_client->IsConnected())
     return;
   if(!m_client->IsData())
     return;
-  if(m_clientTextStream == NULL)
-    return;
   m_statusBar->NetworkStatus(StatusBar::receive);
 
-  // Read all new lines of text we received.
-  wxChar chr;
-
-  int newBytes = 0;
-  while((m_client->IsConnected()) && (m_client->IsData()) && (m_clientStream != NULL) &&
-        (!m_clientStream->Eof()))
+  // Read all new text we received. The reader stops after a megabyte
+  // so the GUI stays responsive during a big data transfer.
+  m_clientReader->ReadAvailable(m_newCharsFromMaxima);
+  m_bytesFromMaxima = m_clientReader->GetBytesRead();
+  m_readMBPerSecondFromMaxima = m_clientReader->GetMBPerSecond();
+  if(m_clientReader->MoreDataPending())
   {
-    chr = m_clientTextStream->GetChar();
-    if(chr == wxEOT)
-      break;
-    if(chr != '\0')
-      m_newCharsFromMaxima += chr;
-    // Trigger the gui every few kilobytes so it stays responsible during
-    // a big data transfer
-    if(newBytes++>100000)
-    {
-      // Make sure that the idle loop is triggered that causes more data to be read
-      CallAfter(&wxWakeUpIdle);
-      return;
-    }
+    // Make sure that the idle loop is triggered that causes more data to be read
+    CallAfter(&wxWakeUpIdle);
+    return;
   }
 
   if(m_pipeToStdout)
     std::cout << m_newCharsFromMaxima;
-  m_bytesFromMaxima += m_newCharsFromMaxima.Length();
 
   if(m_newCharsFromMaxima.EndsWith("\n") || m_newCharsFromMaxima.EndsWith(m_promptSuffix) || (m_first))
   {
@@ -1708,6 +1701,7 @@ void wxMaxima::OnMaximaConnect()
   m_statusBar->NetworkStatus(StatusBar::idle);
   m_worksheet->QuestionAnswered();
   m_currentOutput = wxEmptyString;
+  m_tagEndSearchStart = 0;
     
   m_client.reset(m_server->Accept(false));
   if(!m_client)
@@ -1725,8 +1719,7 @@ void wxMaxima::OnMaximaConnect()
   else
   {
     wxLogMessage(_("Connected."));
-    m_clientStream.reset(new wxSocketInputStream(*m_client));
-    m_clientTextStream.reset(new wxTextInputStream(*m_clientStream, wxT('\t'), wxConvUTF8));
+    m_clientReader.reset(new MaximaSocketReader(m_client.get()));
     m_client->SetEventHandler(*GetEventHandler());
     m_client->SetNotify(wxSOCKET_INPUT_FLAG|wxSOCKET_OUTPUT_FLAG|wxSOCKET_LOST_FLAG|wxSOCKET_CONNECTION_FLAG);
     m_client->Notify(true);
@@ -2059,6 +2052,7 @@ void wxMaxima::KillMaxima(bool logMessage)
   m_CWD = wxEmptyString;
   m_worksheet->QuestionAnswered();
   m_currentOutput = wxEmptyString;
+  m_tagEndSearchStart = 0;
   // If we did close maxima by hand we already might have a new process
   // and therefore invalidate the wrong process in this step
   if (m_process)
@@ -2067,8 +2061,7 @@ void wxMaxima::KillMaxima(bool logMessage)
   m_maximaStdout = NULL;
   m_maximaStderr = NULL;
 
-  m_clientTextStream = NULL;
-  m_clientStream = NULL;
+  m_clientReader = NULL;
 
   if(m_client && (m_client->IsConnected()))
   {
@@ -2209,6 +2202,8 @@ void wxMaxima::ReadFirstPrompt(wxString &data)
     return;
 
   m_bytesFromMaxima = 0;
+  if(m_clientReader)
+    m_clientReader->ResetStatistics();
 
   int start = 0;
   start = data.Find(wxT("Maxima "));
@@ -2269,73 +2264,90 @@ void wxMaxima::ReadFirstPrompt(wxString &data)
     TriggerEvaluation();
 }
 
-int wxMaxima::GetMiscTextEnd(const wxString &data)
-{
-  // These tests are redundant with later tests. But they are faster.
-  if(data.StartsWith(m_mathPrefix1) || (data.StartsWith(m_mathPrefix2)))
-    return 0;
-//  if(data.StartsWith(m_outputPromptPrefix))
-//    return 0;
-  if(data.StartsWith(m_statusbarPrefix))
-    return 0;
-  if(data.StartsWith(m_promptPrefix))
-    return 0;
-  if(data.StartsWith(m_symbolsPrefix))
-    return 0;
-  if(data.StartsWith(m_variablesPrefix))
-    return 0;
-  if(data.StartsWith(m_addVariablesPrefix))
-    return 0;
-  if(data.StartsWith(m_suppressOutputPrefix))
-    return 0;
-
-  int mthpos = wxMax(data.Find(m_mathPrefix1), data.Find(m_mathPrefix2));
-//  int lblpos = data.Find(m_outputPromptPrefix);
-  int statpos = data.Find(m_statusbarPrefix);
-  int prmptpos = data.Find(m_promptPrefix);
-  int symbolspos = data.Find(m_symbolsPrefix);
-  int suppressOutputPos = data.Find(m_suppressOutputPrefix);
-  int variablespos = data.Find(m_variablesPrefix);
-  int addvariablespos = data.Find(m_addVariablesPrefix);
-
-  int tagPos = data.Length();
-  if ((mthpos != wxNOT_FOUND) && (mthpos < tagPos))
-    tagPos = mthpos;
-//  if ((tagPos == wxNOT_FOUND) || ((lblpos != wxNOT_FOUND) && (lblpos < tagPos)))
-//    tagPos = lblpos;
-  if ((tagPos == wxNOT_FOUND) || ((statpos != wxNOT_FOUND) && (statpos < tagPos)))
-    tagPos = statpos;
-  if ((tagPos == wxNOT_FOUND) || ((prmptpos != wxNOT_FOUND) && (prmptpos < tagPos)))
-    tagPos = prmptpos;
-  if ((tagPos == wxNOT_FOUND) || ((prmptpos != wxNOT_FOUND) && (prmptpos < tagPos)))
-    tagPos = prmptpos;
-  if ((tagPos == wxNOT_FOUND) || ((symbolspos != wxNOT_FOUND) && (symbolspos < tagPos)))
-    tagPos = symbolspos;
-  if ((tagPos == wxNOT_FOUND) || ((variablespos != wxNOT_FOUND) && (variablespos < tagPos)))
-    tagPos = variablespos;
-  if ((tagPos == wxNOT_FOUND) || ((addvariablespos != wxNOT_FOUND) && (addvariablespos < tagPos)))
-    tagPos = addvariablespos;
-  if ((tagPos == wxNOT_FOUND) || ((suppressOutputPos != wxNOT_FOUND) && (suppressOutputPos < tagPos)))
-    tagPos = suppressOutputPos;
-  return tagPos;
-}
-
-void wxMaxima::ReadMiscText(wxString &data)
-{
-  if (data.IsEmpty())
-    return;
+wxMaxima::OutputTag wxMaxima::TagAt(const wxString &data, size_t pos) const
+{
+  if ((pos + 1 >= data.Length()) || (data[pos] != wxT('<')))
+    return tag_none;
 
-  // Extract all text that isn't a xml tag known to us.
-  int miscTextLen = GetMiscTextEnd(data);
-  if(miscTextLen <= 0)
+  switch (static_cast<wxChar>(data[pos + 1]))
   {
-    if (!data.empty())
-      m_worksheet->SetCurrentTextCell(nullptr);
-    return;
+  case wxT('m'):
+    if ((data.compare(pos, m_mathPrefix1.Length(), m_mathPrefix1) == 0) ||
+        (data.compare(pos, m_mathPrefix2.Length(), m_mathPrefix2) == 0))
+      return tag_math;
+    break;
+  case wxT('P'):
+    if (data.compare(pos, m_promptPrefix.Length(), m_promptPrefix) == 0)
+      return tag_prompt;
+    break;
+  case wxT('s'):
+    if (data.compare(pos, m_statusbarPrefix.Length(), m_statusbarPrefix) == 0)
+      return tag_statusbar;
+    if (data.compare(pos, m_suppressOutputPrefix.Length(), m_suppressOutputPrefix) == 0)
+      return tag_suppressOutput;
+    break;
+  case wxT('w'):
+    if (data.compare(pos, m_symbolsPrefix.Length(), m_symbolsPrefix) == 0)
+      return tag_symbols;
+    if (data.compare(pos, m_addVariablesPrefix.Length(), m_addVariablesPrefix) == 0)
+      return tag_addVariables;
+    break;
+  case wxT('v'):
+    if (data.compare(pos, m_variablesPrefix.Length(), m_variablesPrefix) == 0)
+      return tag_variables;
+    break;
+  case wxT('i'):
+    if (MaximaIPC::IsEnabled() &&
+        (data.compare(pos, MaximaIPC::GetPrefix().Length(), MaximaIPC::GetPrefix()) == 0))
+      return tag_ipc;
+    break;
   }
+  return tag_none;
+}
 
-  wxString miscText = data.Left(miscTextLen);
-  data = data.Right(data.Length() - miscTextLen);
+const wxString &wxMaxima::TagSuffix(OutputTag tag)
+{
+  switch (tag)
+  {
+  case tag_math:
+    return m_mathSuffix1;
+  case tag_prompt:
+    return m_promptSuffix;
+  case tag_statusbar:
+    return m_statusbarSuffix;
+  case tag_symbols:
+    return m_symbolsSuffix;
+  case tag_variables:
+    return m_variablesSuffix;
+  case tag_addVariables:
+    return m_addVariablesSuffix;
+  case tag_suppressOutput:
+    return m_suppressOutputSuffix;
+  case tag_ipc:
+    return MaximaIPC::GetSuffix();
+  default:
+  {
+    static const wxString noSuffix;
+    return noSuffix;
+  }
+  }
+}
+
+size_t wxMaxima::GetMiscTextEnd(const wxString &data, size_t pos) const
+{
+  while ((pos = data.find(wxT('<'), pos)) != wxString::npos)
+  {
+    if (TagAt(data, pos) != tag_none)
+      return pos;
+    pos++;
+  }
+  return data.Length();
+}
+
+void wxMaxima::ReadMiscText(wxString miscText, bool moreDataFollows)
+{
+  if (miscText.IsEmpty())
+    return;
 
   if(miscText == "\r")
     return;
@@ -2431,287 +2443,199 @@ void wxMaxima::ReadMiscText(wxString &data)
   if (miscText.EndsWith("\n"))
     m_worksheet->SetCurrentTextCell(nullptr);
 
-  if (!data.empty())
+  if (moreDataFollows)
     m_worksheet->SetCurrentTextCell(nullptr);
 }
 
-int wxMaxima::FindTagEnd(const wxString &data, const wxString &tag)
-{
-  if((m_currentOutputEnd.IsEmpty()) || (m_currentOutputEnd.Find(tag) != wxNOT_FOUND))
-    return data.Find(tag);
-  else
-    return wxNOT_FOUND;
-}
-
-void wxMaxima::ReadStatusBar(wxString &data)
+void wxMaxima::ReadStatusBar(const wxString &xml)
 {
-  if (!data.StartsWith(m_statusbarPrefix))
-    return;
-
-  m_worksheet->SetCurrentTextCell(nullptr);
-
-  int end;
-  if ((end = FindTagEnd(data,m_statusbarSuffix)) != wxNOT_FOUND)
+  wxXmlDocument xmldoc;
+  wxStringInputStream xmlStream(xml);
+  xmldoc.Load(xmlStream, wxT("UTF-8"));
+  wxXmlNode *node = xmldoc.GetRoot();
+  if(node != NULL)
   {
-    wxXmlDocument xmldoc;
-    wxString xml = data.Left( end + m_statusbarSuffix.Length());
-    wxStringInputStream xmlStream(xml);
-    xmldoc.Load(xmlStream, wxT("UTF-8"));
-    wxXmlNode *node = xmldoc.GetRoot();
-    if(node != NULL)
-    {
-      wxXmlNode *contents = node->GetChildren();
-      if(contents)
-        LeftStatusText(contents->GetContent(), false);
-    }
-    // Remove the status bar info from the data string
-    data = data.Right(data.Length()-end-m_statusbarSuffix.Length());
+    wxXmlNode *contents = node->GetChildren();
+    if(contents)
+      LeftStatusText(contents->GetContent(), false);
   }
 }
 
 /***
  * Checks if maxima displayed a new chunk of math
  */
-void wxMaxima::ReadMath(wxString &data)
+void wxMaxima::ReadMath(wxString xml)
 {
-  if ((!data.StartsWith(m_mathPrefix1)) && (!data.StartsWith(m_mathPrefix2)))
-    return;
-
-  m_worksheet->SetCurrentTextCell(nullptr);
-
-  // Append everything from the "beginning of math" to the "end of math" marker
-  // to the console and remove it from the data we got.
-  int mthTagLen;
-  int end = FindTagEnd(data, m_mathSuffix1);
-  if(end >= 0)
-    mthTagLen = m_mathSuffix1.Length();
-  else
-  {
-    end = FindTagEnd(data, m_mathSuffix2);
-    mthTagLen = m_mathSuffix2.Length();
-  }
-  if(end >= 0)
+  xml.Trim(true);
+  xml.Trim(false);
+  if (xml.Length() > 0)
   {
-    wxString o = data.Left(end + mthTagLen);
-    data = data.Right(data.Length() - end - mthTagLen);
-    o.Trim(true);
-    o.Trim(false);
-    if (o.Length() > 0)
+    if (m_worksheet->m_configuration->UseUserLabels())
     {
-      if (m_worksheet->m_configuration->UseUserLabels())
-      {
-        ConsoleAppend(o, MC_TYPE_DEFAULT,m_worksheet->m_evaluationQueue.GetUserLabel());
-      }
-      else
-      {
-        ConsoleAppend(o, MC_TYPE_DEFAULT);
-      }
+      ConsoleAppend(xml, MC_TYPE_DEFAULT,m_worksheet->m_evaluationQueue.GetUserLabel());
+    }
+    else
+    {
+      ConsoleAppend(xml, MC_TYPE_DEFAULT);
     }
   }
 }
 
-void wxMaxima::ReadSuppressedOutput(wxString &data)
-{
-  if (!data.StartsWith(m_suppressOutputPrefix))
-    return;
-  int end = FindTagEnd(data, m_suppressOutputSuffix);
-  if (end != wxNOT_FOUND)
-  {
-    data = data.Right(data.Length()-end-m_suppressOutputSuffix.Length());
-  }
-}
-
-void wxMaxima::ReadLoadSymbols(wxString &data)
+void wxMaxima::ReadLoadSymbols(const wxString &xml)
 {
-  if (!data.StartsWith(m_symbolsPrefix))
-    return;
-
-  m_worksheet->SetCurrentTextCell(nullptr);
-
-  int end = FindTagEnd(data, m_symbolsSuffix);
-
-  if (end != wxNOT_FOUND)
-  {
-    // Put the symbols into a separate string
-    wxString symbols = data.Left( end + m_symbolsSuffix.Length());
-    m_worksheet->AddSymbols(symbols);
-
-    // Remove the symbols from the data string
-    data = data.Right(data.Length()-end-m_symbolsSuffix.Length());
-  }
+  m_worksheet->AddSymbols(xml);
 }
 
-void wxMaxima::ReadVariables(wxString &data)
+void wxMaxima::ReadVariables(const wxString &xml)
 {
-  if (!data.StartsWith(m_variablesPrefix))
-    return;
-
-  int end = FindTagEnd(data, m_variablesSuffix);
-
-  if (end != wxNOT_FOUND)
+  int num = 0;
+  wxXmlDocument xmldoc;
+  wxStringInputStream xmlStream(xml);
+  xmldoc.Load(xmlStream, wxT("UTF-8"));
+  wxXmlNode *node = xmldoc.GetRoot();
+  if(node != NULL)
   {
-    int num = 0;
-    wxXmlDocument xmldoc;
-    wxString xml = data.Left( end + m_variablesSuffix.Length());
-    wxStringInputStream xmlStream(xml);
-    xmldoc.Load(xmlStream, wxT("UTF-8"));
-    wxXmlNode *node = xmldoc.GetRoot();
-    if(node != NULL)
+    wxXmlNode *vars = node->GetChildren();
+    while (vars != NULL)
     {
-      wxXmlNode *vars = node->GetChildren();
-      while (vars != NULL)
+      wxXmlNode *var = vars->GetChildren();
+
+      wxString name;
+      wxString value;
+      bool bound = false;
+      while(var != NULL)
       {
-        wxXmlNode *var = vars->GetChildren();
+        if(var->GetName() == wxT("name"))
+        {
+          num++;
+          wxXmlNode *namenode = var->GetChildren();
+          if(namenode)
+            name = namenode->GetContent();
+        }
+        if(var->GetName() == wxT("value"))
+        {
+          wxXmlNode *valnode = var->GetChildren();
+          if(valnode)
+          {
+            bound = true;
+            value = valnode->GetContent();
+          }
+        }
 
-        wxString name;
-        wxString value;
-        bool bound = false;
-        while(var != NULL)
+        if(bound)
         {
-          if(var->GetName() == wxT("name"))
+          if(name == "maxima_userdir")
           {
-            num++;
-            wxXmlNode *namenode = var->GetChildren();
-            if(namenode)
-              name = namenode->GetContent();
+            Dirstructure::Get()->UserConfDir(value);
+            wxLogMessage(wxString::Format(_("Maxima user configuration lies in directory %s"),value.utf8_str()));
           }
-          if(var->GetName() == wxT("value"))
+          if(name == "maxima_tempdir")
           {
-            wxXmlNode *valnode = var->GetChildren();
-            if(valnode)
+            m_maximaTempDir = value;
+            wxLogMessage(wxString::Format(_("Maxima uses temp directory %s"),value.utf8_str()));
             {
-              bound = true;
-              value = valnode->GetContent();
+              // Sometimes people delete their temp dir
+              // and gnuplot won't create a new one for them.
+              wxLogNull logNull;
+              wxMkDir(value, wxS_DIR_DEFAULT);
             }
           }
-
-          if(bound)
+          if(name == "*autoconf-version*")
           {
-            if(name == "maxima_userdir")
-            {
-              Dirstructure::Get()->UserConfDir(value);
-              wxLogMessage(wxString::Format(_("Maxima user configuration lies in directory %s"),value.utf8_str()));
-            }
-            if(name == "maxima_tempdir")
-            {
-              m_maximaTempDir = value;
-              wxLogMessage(wxString::Format(_("Maxima uses temp directory %s"),value.utf8_str()));
-              {
-                // Sometimes people delete their temp dir
-                // and gnuplot won't create a new one for them.
-                wxLogNull logNull;
-                wxMkDir(value, wxS_DIR_DEFAULT);
-              }
-            }
-            if(name == "*autoconf-version*")
-            {
-              m_maximaVersion = value;
-              wxLogMessage(wxString::Format(_("Maxima version: %s"),value.utf8_str()));
-            }
-            if(name == "*autoconf-host*")
-            {
-              m_maximaArch = value;
-              wxLogMessage(wxString::Format(_("Maxima architecture: %s"),value.utf8_str()));
-            }
-            if(name == "*maxima-infodir*")
-            {
-              m_maximaDocDir = value;
-              wxLogMessage(wxString::Format(_("Maxima's manual lies in directory %s"),value.utf8_str()));
-            }
-            if(name == "gnuplot_command")
-            {
-              m_gnuplotcommand = value;
-              wxLogMessage(wxString::Format(_("Gnuplot can be found at %s"),m_gnuplotcommand.utf8_str()));
-            }
-            if(name == "*maxima-sharedir*")
+            m_maximaVersion = value;
+            wxLogMessage(wxString::Format(_("Maxima version: %s"),value.utf8_str()));
+          }
+          if(name == "*autoconf-host*")
+          {
+            m_maximaArch = value;
+            wxLogMessage(wxString::Format(_("Maxima architecture: %s"),value.utf8_str()));
+          }
+          if(name == "*maxima-infodir*")
+          {
+            m_maximaDocDir = value;
+            wxLogMessage(wxString::Format(_("Maxima's manual lies in directory %s"),value.utf8_str()));
+          }
+          if(name == "gnuplot_command")
+          {
+            m_gnuplotcommand = value;
+            wxLogMessage(wxString::Format(_("Gnuplot can be found at %s"),m_gnuplotcommand.utf8_str()));
+          }
+          if(name == "*maxima-sharedir*")
+          {
+            value.Trim(true);
+            m_worksheet->m_configuration->MaximaShareDir(value);
+            wxLogMessage(wxString::Format(_("Maxima's share files lie in directory %s"),value.utf8_str()));
+            /// READ FUNCTIONS FOR AUTOCOMPLETION
+            m_worksheet->LoadSymbols();
+            if(m_worksheet->m_helpFileAnchors.empty())
             {
-              value.Trim(true);
-              m_worksheet->m_configuration->MaximaShareDir(value);
-              wxLogMessage(wxString::Format(_("Maxima's share files lie in directory %s"),value.utf8_str()));
-              /// READ FUNCTIONS FOR AUTOCOMPLETION
-              m_worksheet->LoadSymbols();
-              if(m_worksheet->m_helpFileAnchors.empty())
+              if(!LoadManualAnchorsFromCache())
               {
-                if(!LoadManualAnchorsFromCache())
-                {
-                  if(wxFileExists(GetMaximaHelpFile()))
-                    m_compileHelpAnchorsTimer.StartOnce(4000);
-                  else
-                    LoadBuiltInManualAnchors();
-                  }
-              }
+                if(wxFileExists(GetMaximaHelpFile()))
+                  m_compileHelpAnchorsTimer.StartOnce(4000);
+                else
+                  LoadBuiltInManualAnchors();
+                }
             }
-            if(name == "*lisp-name*")
-            {
-              m_lispType = value;
-              wxLogMessage(wxString::Format(_("Maxima was compiled using %s"),value.utf8_str()));
-            }
-            if(name == "*lisp-version*")
-            {
-              m_lispVersion = value;
-              wxLogMessage(wxString::Format(_("Lisp version: %s"),value.utf8_str()));
-            }
-            if(name == "*wx-load-file-name*")
-            {
-              m_recentPackages.AddDocument(value);
-              wxLogMessage(wxString::Format(_("Maxima has loaded the file %s."),value.utf8_str()));
-            }
-            m_worksheet->m_variablesPane->VariableValue(name, value);
           }
-          else
-            m_worksheet->m_variablesPane->VariableUndefined(name);
-
-          var = var->GetNext();
+          if(name == "*lisp-name*")
+          {
+            m_lispType = value;
+            wxLogMessage(wxString::Format(_("Maxima was compiled using %s"),value.utf8_str()));
+          }
+          if(name == "*lisp-version*")
+          {
+            m_lispVersion = value;
+            wxLogMessage(wxString::Format(_("Lisp version: %s"),value.utf8_str()));
+          }
+          if(name == "*wx-load-file-name*")
+          {
+            m_recentPackages.AddDocument(value);
+            wxLogMessage(wxString::Format(_("Maxima has loaded the file %s."),value.utf8_str()));
+          }
+          m_worksheet->m_variablesPane->VariableValue(name, value);
         }
-        vars = vars->GetNext();
+        else
+          m_worksheet->m_variablesPane->VariableUndefined(name);
+
+        var = var->GetNext();
       }
+      vars = vars->GetNext();
     }
+  }
 
-    if(num>1)
-      wxLogMessage(_("Maxima sends a new set of auto-completable symbols."));
-    else
-      wxLogMessage(_("Maxima has sent a new variable value."));
+  if(num>1)
+    wxLogMessage(_("Maxima sends a new set of auto-completable symbols."));
+  else
+    wxLogMessage(_("Maxima has sent a new variable value."));
 
-    // Remove the symbols from the data string
-    data = data.Right(data.Length()-end-m_variablesSuffix.Length());
-    TriggerEvaluation();
-    QueryVariableValue();
-  }
+  TriggerEvaluation();
+  QueryVariableValue();
 }
 
-void wxMaxima::ReadAddVariables(wxString &data)
+void wxMaxima::ReadAddVariables(const wxString &xml)
 {
-  if (!data.StartsWith(m_addVariablesPrefix))
-    return;
-
-  int end = FindTagEnd(data, m_addVariablesSuffix);
-
-  if (end != wxNOT_FOUND)
+  wxLogMessage(_("Maxima sends us a new set of variables for the watch list."));
+  wxXmlDocument xmldoc;
+  wxStringInputStream xmlStream(xml);
+  xmldoc.Load(xmlStream, wxT("UTF-8"));
+  wxXmlNode *node = xmldoc.GetRoot();
+  if(node != NULL)
   {
-    wxLogMessage(_("Maxima sends us a new set of variables for the watch list."));
-    wxXmlDocument xmldoc;
-    wxString xml = data.Left( end + m_addVariablesSuffix.Length());
-    wxStringInputStream xmlStream(xml);
-    xmldoc.Load(xmlStream, wxT("UTF-8"));
-    wxXmlNode *node = xmldoc.GetRoot();
-    if(node != NULL)
+    wxXmlNode *var = node->GetChildren();
+    while (var != NULL)
     {
-      wxXmlNode *var = node->GetChildren();
-      while (var != NULL)
+      wxString name;
       {
-        wxString name;
+        if(var->GetName() == wxT("variable"))
         {
-          if(var->GetName() == wxT("variable"))
-          {
-            wxXmlNode *valnode = var->GetChildren();
-            if(valnode)
-              m_worksheet->m_variablesPane->AddWatch(valnode->GetContent());
-          }
+          wxXmlNode *valnode = var->GetChildren();
+          if(valnode)
+            m_worksheet->m_variablesPane->AddWatch(valnode->GetContent());
         }
-        var = var->GetNext();
       }
+      var = var->GetNext();
     }
-    data = data.Right(data.Length()-end-m_addVariablesSuffix.Length());
   }
 }
 
@@ -2744,30 +2668,12 @@ bool wxMaxima::QueryVariableValue()
 /***
  * Checks if maxima displayed a new prompt.
  */
-void wxMaxima::ReadPrompt(wxString &data)
+void wxMaxima::ReadPrompt(wxString o)
 {
-  m_evalOnStartup = false;
-  if (!data.StartsWith(m_promptPrefix))
-    return;
-
-  m_worksheet->SetCurrentTextCell(nullptr);
-
-  // Assume we don't have a question prompt
-  m_worksheet->m_questionPrompt = false;
-  m_ready = true;
-  int end = FindTagEnd(data,m_promptSuffix);
-  // Did we find a prompt?
-  if (end == wxNOT_FOUND)
-    return;
-
   m_maximaBusy = false;
   m_bytesFromMaxima = 0;
-
-  wxString o = data.SubString(m_promptPrefix.Length(), end - 1);
-  // Remove the prompt we will process from the string.
-  data = data.Right(data.Length()-end-m_promptSuffix.Length());
-  if(data == wxT(" "))
-    data = wxEmptyString;
+  if(m_clientReader)
+    m_clientReader->ResetStatistics();
 
   // If we got a prompt our connection to maxima was successful.
   if(m_unsuccessfulConnectionAttempts > 0)
@@ -3143,35 +3049,16 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document, bool clea
   // open wxmx file
   wxXmlDocument xmldoc;
 
-  wxFileSystem fs;
-  
-  wxString wxmxURI = wxURI(wxT("file://") + file).BuildURI();
-  // wxURI doesn't know that a "#" in a file name is a literal "#" and
-  // not an anchor within the file so we have to care about url-encoding
-  // this char by hand.
-  wxmxURI.Replace("#", "%23");
-
-#ifdef  __WXMSW__
-  // Fixes a missing "///" after the "file:". This works because we always get absolute
-  // file names.
-  wxRegEx uriCorector1("^file:([a-zA-Z]):");
-  wxRegEx uriCorector2("^file:([a-zA-Z][a-zA-Z]):");
-
-  uriCorector1.ReplaceFirst(&wxmxURI, wxT("file:///\\1:"));
-  uriCorector2.ReplaceFirst(&wxmxURI, wxT("file:///\\1:"));
-#endif
-  // The URI of the wxm code contained within the .wxmx file
-  wxString filename = wxmxURI + wxT("#zip:content.xml");
+  // The index of the files in the archive. The background tasks that load
+  // the images share it with us.
+  auto archive = std::make_shared<ZipIndex>(file);
 
-  // Open the file
-  std::shared_ptr<wxFSFile> fsfile;
-  #ifdef HAVE_OPENMP_TASKS
-  #pragma omp critical (OpenFSFile)
-  #endif
-  fsfile.reset(fs.OpenFile(filename));
-  if (fsfile)
+  // Read the wxm code contained within the .wxmx file. It is inflated while
+  // the xml parser reads it.
+  std::unique_ptr<wxInputStream> xmlStream = archive->OpenEntry(wxT("content.xml"));
+  if (xmlStream)
   {
-    xmldoc.Load(*(fsfile->GetStream()), wxT("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
+    xmldoc.Load(*xmlStream, wxT("UTF-8"), wxXMLDOC_KEEP_WHITESPACE_NODES);
   }
   if(!xmldoc.IsOk())
   {
@@ -3179,17 +3066,13 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document, bool clea
     // a letter of ascii code 27 in content.xml. Let's filter this char out.
     
     // Re-open the file.
-    std::shared_ptr<wxFSFile> fsfile2;
-    #ifdef HAVE_OPENMP_TASKS
-    #pragma omp critical (OpenFSFile)
-    #endif
-    fsfile2.reset(fs.OpenFile(filename));
+    xmlStream = archive->OpenEntry(wxT("content.xml"));
     wxString contents;
-    if (fsfile2)
+    if (xmlStream)
     {
       // Read the file into a string
-      wxTextInputStream istream1(*fsfile2->GetStream(), wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
-      while (!fsfile2->GetStream()->Eof())
+      wxTextInputStream istream1(*xmlStream, wxT('\t'), wxConvAuto(wxFONTENCODING_UTF8));
+      while (!xmlStream->Eof())
         contents += istream1.ReadLine() + wxT("\n");
     }
     else
@@ -3361,7 +3244,7 @@ bool wxMaxima::OpenWXMXFile(const wxString &file, Worksheet *document, bool clea
 
   // Read the worksheet's contents.
   wxXmlNode *xmlcells = xmldoc.GetRoot();
-  GroupCell *tree = CreateTreeFromXMLNode(xmlcells, wxmxURI);
+  GroupCell *tree = CreateTreeFromXMLNode(xmlcells, archive);
 
   // from here on code is identical for wxm and wxmx
   if (clearDocument)
@@ -3476,7 +3359,10 @@ bool wxMaxima::OpenXML(const wxString &file, Worksheet *document)
 
   // Read the worksheet's contents.
   wxXmlNode *xmlcells = xmldoc.GetRoot();
-  GroupCell *tree = CreateTreeFromXMLNode(xmlcells, file);
+  // The images a content.xml refers to aren't in an archive we could find.
+  // An empty index makes sure we don't treat them as temporary files we
+  // may delete after loading them.
+  GroupCell *tree = CreateTreeFromXMLNode(xmlcells, std::make_shared<ZipIndex>(file));
 
   document->ClearDocument();
   StartMaxima();
@@ -3492,13 +3378,13 @@ bool wxMaxima::OpenXML(const wxString &file, Worksheet *document)
   return true;
 }
 
-GroupCell *wxMaxima::CreateTreeFromXMLNode(wxXmlNode *xmlcells, const wxString &wxmxfilename)
+GroupCell *wxMaxima::CreateTreeFromXMLNode(wxXmlNode *xmlcells, std::shared_ptr<ZipIndex> archive)
 {
   // Show a busy cursor as long as we export a .gif file (which might be a lengthy
   // action).
   wxBusyCursor crs;
 
-  MathParser mp(&m_worksheet->m_configuration, wxmxfilename);
+  MathParser mp(&m_worksheet->m_configuration, archive);
   GroupCell *tree = NULL;
   GroupCell *last = NULL;
 
@@ -4181,15 +4067,9 @@ bool wxMaxima::InterpretDataFromMaxima()
 
   if ((m_xmlInspector) && (IsPaneDisplayed(menu_pane_xmlInspector)))
     m_xmlInspector->Add_FromMaxima(m_newCharsFromMaxima);
-  // This way we can avoid searching the whole string for a
-  // ending tag if we have received only a few bytes of the
-  // data between 2 tags
-  m_currentOutputEnd = m_currentOutput.Right(30) + m_newCharsFromMaxima;
 
   m_currentOutput += m_newCharsFromMaxima;
   m_newCharsFromMaxima = wxEmptyString;
-  if ((m_xmlInspector) && (IsPaneDisplayed(menu_pane_xmlInspector)))
-    m_xmlInspector->Add_FromMaxima(m_newCharsFromMaxima);
 
   if (!m_dispReadOut &&
       (m_currentOutput != wxT("\n")) &&
@@ -4199,67 +4079,126 @@ bool wxMaxima::InterpretDataFromMaxima()
     m_dispReadOut = true;
   }
 
-  size_t length_old = 0;
+  // The output is interpreted in a single pass: pos is the position of the first
+  // char we haven't processed yet. The processed part of m_currentOutput is only
+  // removed once we have interpreted everything we can.
+  size_t pos = 0;
 
-  while (length_old != m_currentOutput.Length())
+  // A prompt makes ReadPrompt() send the next command to maxima and therefore
+  // changes the working group. Everything else in this batch was sent by maxima
+  // before it got the new command, though => it still belongs to the old group.
+  GroupCell *oldActiveCell = NULL;
+  GroupCell *newActiveCell = NULL;
+
+  while (pos < m_currentOutput.Length())
   {
-    if (m_currentOutput.StartsWith("\n<"))
-      m_currentOutput = m_currentOutput.Right(m_currentOutput.Length() - 1);
+    if (m_first)
+    {
+      // This function determines the port maxima is running on from  the text
+      // maxima outputs at startup. This piece of text is afterwards discarded.
+      m_currentOutput.erase(0, pos);
+      pos = 0;
+      ReadFirstPrompt(m_currentOutput);
+      if (m_first)
+        break;
+      continue;
+    }
+
+    // ReadFirstPrompt() has already acted on this flag.
+    m_evalOnStartup = false;
+
+    if ((m_currentOutput[pos] == wxT('\n')) && (TagAt(m_currentOutput, pos + 1) != tag_none))
+      pos++;
+
+    OutputTag tag = TagAt(m_currentOutput, pos);
+
+    // Handle text that isn't wrapped in a known tag: Mostly Error messages or warnings.
+    if (tag == tag_none)
+    {
+      size_t end = GetMiscTextEnd(m_currentOutput, pos);
+      ReadMiscText(m_currentOutput.Mid(pos, end - pos), end < m_currentOutput.Length());
+      pos = end;
+      continue;
+    }
 
-    length_old = m_currentOutput.Length();
+    m_worksheet->SetCurrentTextCell(nullptr);
+    if (tag == tag_prompt)
+    {
+      // Assume we don't have a question prompt
+      m_worksheet->m_questionPrompt = false;
+      m_ready = true;
+    }
 
-    GroupCell *oldActiveCell = NULL;
-    GroupCell *newActiveCell = NULL;
+    // Find the end of the tag. If we have searched a part of the tag already the
+    // last time we got data from maxima we don't need to search it once more.
+    const wxString &suffix =
+      ((tag == tag_math) &&
+       (m_currentOutput.compare(pos, m_mathPrefix2.Length(), m_mathPrefix2) == 0)) ?
+      m_mathSuffix2 : TagSuffix(tag);
+    size_t searchStart = pos;
+    if ((pos == 0) && (m_tagEndSearchStart > searchStart))
+      searchStart = m_tagEndSearchStart;
+    size_t end = m_currentOutput.find(suffix, searchStart);
+    if (end == wxString::npos)
+    {
+      // The tag is incomplete: wait for more data.
+      size_t searched = m_currentOutput.Length() - pos;
+      m_tagEndSearchStart = (searched >= suffix.Length()) ? searched - suffix.Length() + 1 : 0;
+      break;
+    }
+    m_tagEndSearchStart = 0;
+    end += suffix.Length();
+    wxString xml = m_currentOutput.Mid(pos, end - pos);
+    pos = end;
 
-    // Handle text that isn't wrapped in a known tag
-    if (!m_first)
+    switch (tag)
+    {
+    case tag_prompt:
     {
-      // First read the prompt that tells us that maxima awaits the next command:
-      // If that is the case ReadPrompt() sends the next command to maxima and
-      // maxima can work while we interpret its output.
+      if (newActiveCell != oldActiveCell)
+        m_worksheet->SetWorkingGroup(newActiveCell);
       oldActiveCell = m_worksheet->GetWorkingGroup();
-      ReadPrompt(m_currentOutput);
+      ReadPrompt(xml.Mid(m_promptPrefix.Length(),
+                         xml.Length() - m_promptPrefix.Length() - m_promptSuffix.Length()));
       newActiveCell = m_worksheet->GetWorkingGroup();
-
       // Temporarily switch to the WorkingGroup the output we don't have interpreted yet
       // was for
       if (newActiveCell != oldActiveCell)
         m_worksheet->SetWorkingGroup(oldActiveCell);
-      // Handle the <mth> tag that contains math output and sometimes text.
-      ReadMath(m_currentOutput);
-
-      // The following function calls each extract and remove one type of XML tag
-      // information from the beginning of the data string we got - but only do so
-      // after the closing tag has been transferred, as well.
-      ReadLoadSymbols(m_currentOutput);
-
+      if (m_currentOutput.compare(pos, wxString::npos, wxT(" ")) == 0)
+        pos++;
+      break;
+    }
+    case tag_math:
+      ReadMath(xml);
+      break;
+    case tag_symbols:
+      ReadLoadSymbols(xml);
+      break;
+    case tag_variables:
+      ReadVariables(xml);
+      break;
+    case tag_addVariables:
+      ReadAddVariables(xml);
+      break;
+    case tag_statusbar:
+      ReadStatusBar(xml);
+      break;
+    case tag_ipc:
+      m_ipc.ReadInputData(xml);
+      break;
+    case tag_suppressOutput:
+    default:
       // Discard startup warnings
-      ReadSuppressedOutput(m_currentOutput);
-
-      // Let's see if maxima informs us about the values of variables
-      ReadVariables(m_currentOutput);
-
-      // Let's see if maxima tells us to add new symbols to the watchlist
-      ReadAddVariables(m_currentOutput);
-
-      // Handle the XML tag that contains Status bar updates
-      ReadStatusBar(m_currentOutput);
-
-      // Handle the XML tag that contains the interprocess communication messages
-      m_ipc.ReadInputData(m_currentOutput);
-
-      // Handle text that isn't XML output: Mostly Error messages or warnings.
-      ReadMiscText(m_currentOutput);
+      break;
     }
-    else
-      // This function determines the port maxima is running on from  the text
-      // maxima outputs at startup. This piece of text is afterwards discarded.
-      ReadFirstPrompt(m_currentOutput);
-
-    // Switch to the WorkingGroup the next bunch of data is for.
-    if (newActiveCell != oldActiveCell)
-      m_worksheet->SetWorkingGroup(newActiveCell);
   }
+
+  // Switch to the WorkingGroup the next bunch of data is for.
+  if (newActiveCell != oldActiveCell)
+    m_worksheet->SetWorkingGroup(newActiveCell);
+
+  m_currentOutput.erase(0, pos);
   return true;
 }
 
@@ -4333,11 +4272,15 @@ void wxMaxima::OnIdle(wxIdleEvent &event)
   {
     if (
       (m_oldFindString != m_worksheet->m_findDialog->GetData()->GetFindString()) ||
-      (m_oldFindFlags != m_worksheet->m_findDialog->GetData()->GetFlags())
+      (m_oldFindFlags != m_worksheet->m_findDialog->GetData()->GetFlags()) ||
+      (m_oldFindHighlightAll != m_worksheet->m_findDialog->GetHighlightAll())
       )
     {
       m_oldFindFlags = m_worksheet->m_findDialog->GetData()->GetFlags();
       m_oldFindString = m_worksheet->m_findDialog->GetData()->GetFindString();
+      m_oldFindHighlightAll = m_worksheet->m_findDialog->GetHighlightAll();
+      m_oldFindTextRevision = EditorCell::GetLastTextRevision();
+      UpdateFindMatches();
 
       bool incrementalSearch = true;
       wxConfig::Get()->Read("incrementalSearch", &incrementalSearch);
@@ -4352,6 +4295,12 @@ void wxMaxima::OnIdle(wxIdleEvent &event)
       event.RequestMore();
       return;
     }
+    // Editing the worksheet might have changed the number of matches.
+    if (m_oldFindTextRevision != EditorCell::GetLastTextRevision())
+    {
+      m_oldFindTextRevision = EditorCell::GetLastTextRevision();
+      UpdateFindMatches();
+    }
   }
 
   if(m_worksheet->RedrawIfRequested())
@@ -5335,22 +5284,8 @@ bool wxMaxima::AutoSave()
   if (m_worksheet->m_configuration->AutoSaveAsTempFile() ||
       m_worksheet->m_currentFile.IsEmpty())
   {
-    bool saved = m_worksheet->ExportToWXMX(m_tempfileName);
-
     wxLogMessage(wxString::Format(_("Autosaving as temp file %s"), m_tempfileName.utf8_str()));
-    if((m_tempfileName != oldTempFile) && saved)
-    {
-      if(!oldTempFile.IsEmpty())
-      {
-        if(wxFileExists(oldTempFile))
-        {
-          SuppressErrorDialogs blocker;
-          wxLogMessage(wxString::Format(_("Trying to remove the old temp file %s"), oldTempFile.utf8_str()));
-          wxRemoveFile(oldTempFile);
-        }
-      }
-    }
-    RegisterAutoSaveFile();
+    AutoSaveInBackground(m_tempfileName, oldTempFile);
   }
   else
   {
@@ -5367,6 +5302,43 @@ bool wxMaxima::AutoSave()
   return savedWas;
 }
 
+bool wxMaxima::AutoSaveInBackground(const wxString &file, const wxString &oldFile)
+{
+  if (m_autoSaveSnapshot && !m_autoSaveSnapshot->IsFinished())
+  {
+    wxLogMessage(_("The last autosave is still being written. Skipping this one."));
+    return false;
+  }
+
+  m_autoSaveSnapshot = m_worksheet->CreateWXMXSnapshot();
+  WXMXSnapshot *snapshot = m_autoSaveSnapshot.get();
+  wxString filename = file;
+  wxString oldFilename = oldFile;
+  #ifdef HAVE_OPENMP_TASKS
+  #pragma omp task firstprivate(snapshot, filename, oldFilename)
+  #endif
+  {
+    if (snapshot->Write(filename))
+      CallAfter([this, filename, oldFilename]{ TempFileAutoSaved(filename, oldFilename); });
+    else
+      wxLogMessage(_("Autosaving as %s has failed"), filename);
+  }
+  return true;
+}
+
+void wxMaxima::TempFileAutoSaved(const wxString &file, const wxString &oldFile)
+{
+  if((file != oldFile) && !oldFile.IsEmpty() && wxFileExists(oldFile))
+  {
+    SuppressErrorDialogs blocker;
+    wxLogMessage(wxString::Format(_("Trying to remove the old temp file %s"), oldFile.utf8_str()));
+    wxRemoveFile(oldFile);
+  }
+  // If another file has been opened in the meantime its temp file is a different one.
+  if(file == m_tempfileName)
+    RegisterAutoSaveFile();
+}
+
 void wxMaxima::FileMenu(wxCommandEvent &event)
 {
   if(m_worksheet != NULL)
@@ -5959,6 +5931,27 @@ void wxMaxima::EditMenu(wxCommandEvent &event)
   m_worksheet->RequestRedraw();
 }
 
+void wxMaxima::UpdateFindMatches()
+{
+  if (m_worksheet->m_findDialog == NULL)
+  {
+    m_worksheet->HighlightMatches(wxEmptyString, false);
+    return;
+  }
+
+  wxString findString = m_worksheet->m_findDialog->GetData()->GetFindString();
+  bool ignoreCase = !(m_worksheet->m_findDialog->GetData()->GetFlags() & wxFR_MATCHCASE);
+  if (m_worksheet->m_findDialog->GetHighlightAll())
+    m_worksheet->HighlightMatches(findString, ignoreCase);
+  else
+    m_worksheet->HighlightMatches(wxEmptyString, false);
+
+  if (findString.IsEmpty())
+    m_worksheet->m_findDialog->SetMatchCount(-1);
+  else
+    m_worksheet->m_findDialog->SetMatchCount(m_worksheet->CountMatches(findString, ignoreCase));
+}
+
 void wxMaxima::OnFind(wxFindDialogEvent &event)
 {
   if (!m_worksheet->FindNext(event.GetFindString(),
@@ -5969,10 +5962,9 @@ void wxMaxima::OnFind(wxFindDialogEvent &event)
 
 void wxMaxima::OnFindClose(wxFindDialogEvent &WXUNUSED(event))
 {
-  if (m_worksheet->m_findDialog != NULL)
-    m_worksheet->m_findDialog->Destroy();
+  m_worksheet->CloseFindDialog();
   m_oldFindString = wxEmptyString;
-  m_worksheet->m_findDialog = NULL;
+  UpdateFindMatches();
 }
 
 void wxMaxima::OnReplace(wxFindDialogEvent &event)
@@ -5990,6 +5982,7 @@ void wxMaxima::OnReplace(wxFindDialogEvent &event)
     LoggingMessageBox(_("No matches found!"));
   else
     m_worksheet->UpdateTableOfContents();
+  UpdateFindMatches();
 }
 
 void wxMaxima::OnReplaceAll(wxFindDialogEvent &event)
@@ -6003,6 +5996,7 @@ void wxMaxima::OnReplaceAll(wxFindDialogEvent &event)
   LoggingMessageBox(wxString::Format(_("Replaced %d occurrences."), count));
   if (count > 0)
     m_worksheet->UpdateTableOfContents();
+  UpdateFindMatches();
 }
 
 void wxMaxima::OnSymbolAdd(wxCommandEvent &event)
@@ -34,6 +34,7 @@
 #include "wxMaximaFrame.h"
 #include "MathParser.h"
 #include "MaximaIPC.h"
+#include "MaximaSocketReader.h"
 #include "Dirstructure.h"
 
 #include <wx/socket.h>
@@ -222,6 +223,12 @@ private:
   wxString m_oldFindString;
   //! This string allows us to detect when the string we search for has changed.
   int m_oldFindFlags;
+  //! Allows us to detect when the user has toggled the "highlight all" checkbox.
+  bool m_oldFindHighlightAll = false;
+  //! Allows us to detect when the worksheet has been edited while the find dialog is open.
+  unsigned long m_oldFindTextRevision = 0;
+  //! Update the number of matches and the highlighting in the find dialog
+  void UpdateFindMatches();
   //! On opening a new file we only need a new maxima process if the old one ever evaluated cells.
   bool m_hasEvaluatedCells;
   //! Searches for maxima's output prompts
@@ -499,65 +506,79 @@ protected:
    */
   void ReadFirstPrompt(wxString &data);
 
+  //! The XML tags maxima's output can contain
+  enum OutputTag
+  {
+    tag_none,
+    tag_math,
+    tag_prompt,
+    tag_statusbar,
+    tag_symbols,
+    tag_variables,
+    tag_addVariables,
+    tag_suppressOutput,
+    tag_ipc
+  };
+
+  /*! Determines which of the tags we know of starts at the position pos in data
+
+    The first character after the "<" decides which tags are candidates so no tag
+    is compared to data more than once.
+   */
+  OutputTag TagAt(const wxString &data, size_t pos) const;
+
+  //! The closing marker of a tag TagAt() has recognized
+  static const wxString &TagSuffix(OutputTag tag);
+
   /*! Determine where the text for ReadMiscText ends
 
     Every error message or other line maxima outputs should end in a newline character. 
     But sometimes it doesn't and a <code>\<mth\></code> tag comes first \f$ =>\f$ This 
-    function determines where the miscellaneous text ends.
+    function determines where the miscellaneous text that starts at pos ends.
+    If no known tag follows, the text ends at the end of data.
    */
-  int GetMiscTextEnd(const wxString &data);
-
-  //! Find the end of a tag in wxMaxima's output.
-  int FindTagEnd(const wxString &data, const wxString &tag);
+  size_t GetMiscTextEnd(const wxString &data, size_t pos) const;
 
   /*! Reads text that isn't enclosed between xml tags.
 
      Some commands provide status messages before the math output or the command has finished.
      This function makes wxMaxima output them directly as they arrive.
 
-     After processing the lines not enclosed in xml tags they are removed from data.
+     \param miscText The text to output
+     \param moreDataFollows true, if maxima's output continues after the text
    */
-  void ReadMiscText(wxString &data);
+  void ReadMiscText(wxString miscText, bool moreDataFollows);
 
   /*! Reads the input prompt from Maxima.
 
-     After processing the input prompt it is removed from data.
+     \param o The text between the \<PROMPT\> and \</PROMPT\> markers.
    */
-  void ReadPrompt(wxString &data);
+  void ReadPrompt(wxString o);
 
   /*! Reads the output of wxstatusbar() commands
 
     wxstatusbar allows the user to give and update visual feedback from long-running 
     commands and makes sure this feedback is deleted once the command is finished.
    */
-  void ReadStatusBar(wxString &data);
+  void ReadStatusBar(const wxString &xml);
 
   /*! Reads the math cell's contents from Maxima.
      
      Math cells are enclosed between the tags \<mth\> and \</mth\>. 
-     This function removes the from data after appending them
-     to the console.
-
-     After processing the status bar marker is removed from data.
+     This function appends them to the console.
    */
-  void ReadMath(wxString &data);
+  void ReadMath(wxString xml);
 
-  /*! Reads autocompletion templates we get on definition of a function or variable
-
-    After processing the templates they are removed from data.
-   */
-  void ReadLoadSymbols(wxString &data);
-
-  //! Read (and discard) suppressed output
-  void ReadSuppressedOutput(wxString &data);
+  //! Reads autocompletion templates we get on definition of a function or variable
+  void ReadLoadSymbols(const wxString &xml);
 
   /*! Reads the variable values maxima advertises to us
    */
-  void ReadVariables(wxString &data);
+  void ReadVariables(const wxString &xml);
   
   /*! Reads the "add variable to watch list" tag maxima can send us
    */
-  void ReadAddVariables(wxString &data);
+  void ReadAddVariables(const wxString &xml);
 
 #ifndef __WXMSW__
 
@@ -633,7 +654,7 @@ protected:
   bool OpenWXMXFile(const wxString &file, Worksheet *document, bool clearDocument = true);
 
   //! Loads a wxmx description
-  GroupCell *CreateTreeFromXMLNode(wxXmlNode *xmlcells, const wxString &wxmxfilename = {});
+  GroupCell *CreateTreeFromXMLNode(wxXmlNode *xmlcells, std::shared_ptr<ZipIndex> archive = {});
 
   /*! Saves the current file
 
@@ -648,6 +669,20 @@ protected:
     Returns false if a save was necessary, but not possible.
    */
   bool AutoSave();
+
+  /*! Writes the worksheet to file in a background task
+
+    Only the cells that have changed since the last call are converted to XML
+    again. Once the file has been written TempFileAutoSaved() is called.
+
+    \param file The temp file to write
+    \param oldFile The temp file the last autosave has written
+    \return false, if the last file this function has started to write hasn't
+    been finished, yet.
+  */
+  bool AutoSaveInBackground(const wxString &file, const wxString &oldFile);
+  //! Removes the old temp file and registers the new one once AutoSaveInBackground() has succeeded
+  void TempFileAutoSaved(const wxString &file, const wxString &oldFile);
   
   int SaveDocumentP();
 
@@ -661,8 +696,8 @@ protected:
   }
 
   std::unique_ptr<wxSocketBase> m_client;
-  std::unique_ptr<wxSocketInputStream> m_clientStream;
-  std::unique_ptr<wxTextInputStream> m_clientTextStream;
+  //! Reads maxima's output from m_client in big blocks
+  std::unique_ptr<MaximaSocketReader> m_clientReader;
   wxSocketServer *m_server;
   wxProcess *m_process;
   //! The stdout of the maxima process
@@ -672,15 +707,12 @@ protected:
   int m_port;
   //! All chars from maxima that still aren't part of m_currentOutput
   wxString m_newCharsFromMaxima;
-  /*! The end of maxima's current uninterpreted output, see m_currentOutput.
-   
-    If we just want to look if maxima's current output contains an ending tag
-    this is the place we can search in fast.
+  /*! Where to resume searching for the end of an incomplete tag in m_currentOutput
 
-    wxEmptyString means that the current output isn't long enought to make 
-    creating this string worthwile.
+    If a tag in maxima's output hasn't been closed yet we don't need to search the
+    part of it we already have searched again once more data arrives.
    */
-  wxString m_currentOutputEnd;
+  size_t m_tagEndSearchStart;
   //! Caches the name of wxMaxima's help file.
   wxString m_wxMaximaHelpFile;
   //! All from maxima's current output we still haven't interpreted
@@ -758,6 +790,11 @@ protected:
   bool m_maximaBusy;
   wxMemoryBuffer m_rawDataToSend;
   unsigned long int m_rawBytesSent;
+  /*! The data AutoSaveInBackground() is writing
+
+    Is kept until the next autosave as it has to be destroyed by the GUI thread.
+  */
+  std::shared_ptr<WXMXSnapshot> m_autoSaveSnapshot;
 private:
 #if wxUSE_DRAG_AND_DROP
 
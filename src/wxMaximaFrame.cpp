@@ -57,6 +57,7 @@ wxMaximaFrame::wxMaximaFrame(wxWindow *parent, int id, const wxString &title,
   m_recentPackages(wxT("packages"))
 {
   m_bytesFromMaxima = 0;
+  m_readMBPerSecondFromMaxima = -1;
   m_drawDimensions_last = -1;
   // Suppress window updates until this window has fully been created.
   // Not redrawing the window whilst constructing it hopefully speeds up
@@ -551,6 +552,11 @@ void wxMaximaFrame::UpdateStatusMaximaBusy()
           m_bytesReadDisplayTimer.StartOnce(300);
           if(m_bytesFromMaxima == 0)
             RightStatusText(_("Reading Maxima output"),false);
+          else if(m_readMBPerSecondFromMaxima >= 0)
+            RightStatusText(wxString::Format(
+                              _("Reading Maxima output: %li bytes (%.1f MB/s)"),
+                              m_bytesFromMaxima, m_readMBPerSecondFromMaxima),
+                            false);
           else
             RightStatusText(wxString::Format(
                               _("Reading Maxima output: %li bytes"), m_bytesFromMaxima),
@@ -575,6 +575,8 @@ public:
 protected:
   //! How many bytes did maxima send us until now?
   long m_bytesFromMaxima;
+  //! How fast did we read maxima's output (in MB/s)? -1 = not enough data for a guess
+  double m_readMBPerSecondFromMaxima;
   //! The process id of maxima. Is determined by ReadFirstPrompt.
   long m_pid;
   //! The last name GetTempAutosavefileName() has returned.
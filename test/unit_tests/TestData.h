@@ -0,0 +1,151 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+/*! \file
+  Real input for the benchmarks of the unit tests.
+
+  Instead of generating their input the benchmarks read the files the
+  automatic tests in test/automatic_test_files use and the list of the
+  subjects of maxima's manual wxMaxima is shipped with.
+ */
+
+#ifndef TESTDATA_H
+#define TESTDATA_H
+
+#include <wx/dir.h>
+#include <wx/ffile.h>
+#include <wx/sstream.h>
+#include <wx/wfstream.h>
+#include <wx/zipstrm.h>
+#include <memory>
+#include <vector>
+
+//! The directory with wxMaxima's sources. test/unit_tests/CMakeLists.txt defines it.
+#ifndef WXM_SOURCE_DIR
+#define WXM_SOURCE_DIR "."
+#endif
+
+//! The names of the files in test/automatic_test_files that match a wildcard, sorted
+inline std::vector<wxString> TestFiles(const wxString &wildcard)
+{
+  wxArrayString names;
+  wxDir::GetAllFiles(wxString(WXM_SOURCE_DIR) + "/test/automatic_test_files",
+                     &names, wildcard, wxDIR_FILES);
+  names.Sort();
+  return std::vector<wxString>(names.begin(), names.end());
+}
+
+//! The contents of a file that is encoded in UTF-8
+inline wxString ReadTextFile(const wxString &name)
+{
+  wxString contents;
+  wxFFile file(name, wxT("rb"));
+  if (file.IsOpened())
+    file.ReadAll(&contents, wxConvUTF8);
+  return contents;
+}
+
+//! The subjects of maxima's manual, as listed in data/manual_anchors.xml
+inline std::vector<wxString> ManualKeywords()
+{
+  std::vector<wxString> keywords;
+  wxString xml = ReadTextFile(wxString(WXM_SOURCE_DIR) + "/data/manual_anchors.xml");
+  size_t start = 0;
+  while ((start = xml.find(wxT("<key>"), start)) != wxString::npos)
+  {
+    start += 5;
+    size_t end = xml.find(wxT("</key>"), start);
+    if (end == wxString::npos)
+      break;
+    keywords.push_back(xml.Mid(start, end - start));
+    start = end;
+  }
+  return keywords;
+}
+
+//! The code of all input cells of the .wxm files in test/automatic_test_files
+inline wxString TestWxmCode()
+{
+  const wxString inputStart = wxT("/* [wxMaxima: input   start ] */\n");
+  const wxString inputEnd = wxT("/* [wxMaxima: input   end   ] */");
+  wxString code;
+  for (auto const &name : TestFiles("*.wxm"))
+  {
+    wxString wxm = ReadTextFile(name);
+    size_t start = 0;
+    while ((start = wxm.find(inputStart, start)) != wxString::npos)
+    {
+      start += inputStart.Length();
+      size_t end = wxm.find(inputEnd, start);
+      if (end == wxString::npos)
+        break;
+      code += wxm.Mid(start, end - start);
+      start = end;
+    }
+  }
+  return code;
+}
+
+//! The contents of each .wxmx file's content.xml in test/automatic_test_files
+inline std::vector<wxString> TestWxmxContents()
+{
+  std::vector<wxString> contents;
+  for (auto const &name : TestFiles("*.wxmx"))
+  {
+    wxFFileInputStream file(name);
+    wxZipInputStream zip(file);
+    std::unique_ptr<wxZipEntry> entry;
+    while (entry.reset(zip.GetNextEntry()), entry)
+    {
+      if (entry->GetName() != "content.xml")
+        continue;
+      wxString xml;
+      wxStringOutputStream output(&xml, wxConvUTF8);
+      zip.Read(output);
+      contents.push_back(xml);
+    }
+  }
+  return contents;
+}
+
+//! The names of the elements of a XML document in the order they are opened
+inline std::vector<wxString> ElementNames(const wxString &xml)
+{
+  std::vector<wxString> names;
+  for (auto ch = xml.begin(); ch != xml.end(); ++ch)
+  {
+    if (*ch != '<')
+      continue;
+    auto nameStart = ch + 1;
+    if ((nameStart == xml.end()) || (*nameStart == '/') || (*nameStart == '?') ||
+        (*nameStart == '!'))
+      continue;
+    auto nameEnd = nameStart;
+    while ((nameEnd != xml.end()) && (*nameEnd != '>') && (*nameEnd != '/') &&
+           (*nameEnd != ' ') && (*nameEnd != '\t') && (*nameEnd != '\r') && (*nameEnd != '\n'))
+      ++nameEnd;
+    names.emplace_back(nameStart, nameEnd);
+    ch = nameStart;
+  }
+  return names;
+}
+
+#endif // TESTDATA_H
@@ -0,0 +1,69 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#include "ConfusableNames.cpp"
+#include <catch2/catch.hpp>
+
+SCENARIO("ConfusableNames maps lookalike chars to the same char") {
+  GIVEN("names with latin, greek and cyrillic lookalikes") {
+    THEN("their skeletons are the same") {
+      CHECK(ConfusableNames::Skeleton(wxT("A")) == ConfusableNames::Skeleton(wxT("Α")));
+      CHECK(ConfusableNames::Skeleton(wxT("A")) == ConfusableNames::Skeleton(wxT("А")));
+      // Lookalikes of lookalikes
+      CHECK(ConfusableNames::Skeleton(wxT("l")) == ConfusableNames::Skeleton(wxT("Ι")));
+      CHECK(ConfusableNames::Skeleton(wxT("xCx")) == ConfusableNames::Skeleton(wxT("хϲχ")));
+    }
+  }
+  GIVEN("names that only look a little alike") {
+    THEN("their skeletons differ") {
+      CHECK(ConfusableNames::Skeleton(wxT("M")) != ConfusableNames::Skeleton(wxT("B")));
+      CHECK(ConfusableNames::Skeleton(wxT("a")) != ConfusableNames::Skeleton(wxT("A")));
+      CHECK(ConfusableNames::Skeleton(wxT("ab")) != ConfusableNames::Skeleton(wxT("a")));
+    }
+  }
+}
+
+SCENARIO("ConfusableNames finds names that look alike") {
+  ConfusableNames names;
+  for (auto const &name : {wxT("Alpha"), wxT("Αlpha"), wxT("beta"), wxT("Alpha"),
+                           wxT("Аlpha"), wxT("gamma")})
+    names.Add(name);
+  GIVEN("names that were added") {
+    THEN("all pairs of lookalikes are found, but no name is its own lookalike") {
+      CHECK(names.GetLookalikePairs().size() == 3);
+      CHECK(names.GetLookalikes(wxT("Alpha")).size() == 2);
+      CHECK(names.GetLookalikes(wxT("beta")).empty());
+    }
+  }
+  GIVEN("a name that wasn't added") {
+    THEN("its lookalikes are found") {
+      CHECK(names.GetLookalikes(wxT("Αlphа")).size() == 3);
+      CHECK(names.GetLookalikes(wxT("gаmma")) == std::vector<wxString>{wxT("gamma")});
+    }
+  }
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,102 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "EditDistanceSearch.cpp"
+#include "levenshtein/levenshtein.cpp"
+#include "TestData.h"
+#include <catch2/catch.hpp>
+#include <random>
+
+SCENARIO("EditDistanceSearch calculates the Levenshtein distance") {
+  GIVEN("random pairs of words") {
+    std::mt19937 random(42);
+    auto randomWord = [&random](size_t maxLength) {
+      const wxString chars = wxT("abcde_äα");
+      wxString word;
+      for (size_t i = random() % (maxLength + 1); i > 0; i--)
+        word += chars[random() % chars.Length()];
+      return word;
+    };
+    THEN("the distance is the same as the one the full matrix gives") {
+      for (int i = 0; i < 10000; i++)
+      {
+        wxString pattern = randomWord((i % 10 == 0) ? 70 : 10);
+        wxString text = randomWord(10);
+        INFO("Pattern: " << pattern.ToStdString() << " Text: " << text.ToStdString());
+        int distance = LevenshteinDistance(pattern, text);
+        CHECK(EditDistanceSearch::Distance(pattern, text, 100) == distance);
+        CHECK(std::min(EditDistanceSearch::Distance(pattern, text, 2), 3) == std::min(distance, 3));
+      }
+    }
+  }
+}
+
+SCENARIO("EditDistanceSearch finds similar words") {
+  EditDistanceSearch search;
+  for (auto const &word : {"integrate", "integer", "intersect", "plot2d", "plot3d", "draw"})
+    search.Add(word);
+  GIVEN("a misspelled word") {
+    auto result = search.Find("intgrate", 5);
+    THEN("the similar words are found, the most similar first") {
+      REQUIRE(result.size() == 3);
+      CHECK(result[0] == std::make_pair(1, wxString("integrate")));
+      CHECK(result[1] == std::make_pair(5, wxString("integer")));
+      CHECK(result[2] == std::make_pair(5, wxString("intersect")));
+    }
+  }
+  GIVEN("a word that is in the list") {
+    auto result = search.Find("plot2d", 1);
+    THEN("it is found with the distance 0") {
+      REQUIRE(result.size() == 2);
+      CHECK(result[0] == std::make_pair(0, wxString("plot2d")));
+      CHECK(result[1] == std::make_pair(1, wxString("plot3d")));
+    }
+  }
+}
+
+// The hidden benchmark "test_EditDistanceSearch [benchmark]" compares the
+// search with what the spelling suggestions for a word used to cost: one
+// full Levenshtein matrix per subject of maxima's manual.
+TEST_CASE("EditDistanceSearch benchmark", "[.][benchmark]") {
+  std::vector<wxString> keywords = ManualKeywords();
+  REQUIRE(!keywords.empty());
+  EditDistanceSearch search;
+  for (auto const &keyword : keywords)
+    search.Add(keyword);
+  BENCHMARK("full matrix for every word") {
+    size_t found = 0;
+    for (auto const &keyword : keywords)
+      if (LevenshteinDistance("intgrate", keyword) <= 4)
+        found++;
+    return found;
+  };
+  BENCHMARK("EditDistanceSearch") {
+    return search.Find("intgrate", 4).size();
+  };
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
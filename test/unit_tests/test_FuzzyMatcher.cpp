@@ -0,0 +1,111 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "FuzzyMatcher.cpp"
+#include "TestData.h"
+#include <catch2/catch.hpp>
+
+static FuzzyMatcher Matcher(const std::vector<wxString> &words)
+{
+  FuzzyMatcher matcher;
+  for (auto const &word : words)
+    matcher.Add(word);
+  return matcher;
+}
+
+SCENARIO("FuzzyMatcher finds words that contain the chars of the query in order") {
+  FuzzyMatcher matcher = Matcher({"integrate", "intersect", "integer", "lsquares_estimates",
+                                  "expand", "ratsimp", "linsolve"});
+  GIVEN("a query that is a prefix of some words") {
+    auto result = matcher.Find("inte", 10);
+    THEN("these words are found and the shorter ones come first") {
+      REQUIRE(result.size() == 3);
+      CHECK(result[0] == "integer");
+      CHECK(result[1] == "integrate");
+      CHECK(result[2] == "intersect");
+    }
+  }
+  GIVEN("a query that only contains some of the chars of a word") {
+    auto result = matcher.Find("intgrt", 10);
+    THEN("the word is found") {
+      REQUIRE(result.size() == 1);
+      CHECK(result[0] == "integrate");
+    }
+  }
+  GIVEN("a query whose chars appear in the wrong order") {
+    THEN("nothing is found") {
+      CHECK(matcher.Find("tni", 10).empty());
+      CHECK(matcher.Find("xyz", 10).empty());
+    }
+  }
+  GIVEN("a query whose chars are found at the start of a word's parts in one word and in the middle of another") {
+    auto result = matcher.Find("le", 10);
+    THEN("the word whose parts start with the chars comes first") {
+      REQUIRE(result.size() == 2);
+      CHECK(result[0] == "lsquares_estimates");
+      CHECK(result[1] == "linsolve");
+      CHECK(FuzzyMatcher::Score(L"le", L"lsquares_estimates") > FuzzyMatcher::Score(L"le", L"linsolve"));
+    }
+  }
+  GIVEN("a query in another case") {
+    THEN("the words are found, anyway") {
+      CHECK(matcher.Find("EXP", 10).size() == 1);
+    }
+  }
+  GIVEN("words the user uses a lot") {
+    FuzzyMatcher used = Matcher({"integer", "integrate"});
+    used.Add("intersect", 5);
+    THEN("they are ranked higher") {
+      CHECK(used.Find("inte", 10)[0] == "intersect");
+    }
+  }
+  GIVEN("a limit on the number of fuzzy matches") {
+    THEN("all prefix matches but only that many of the other matches are returned") {
+      CHECK(matcher.Find("in", 0).size() == 3);
+      CHECK(matcher.Find("i", 1).size() == 4);
+    }
+  }
+}
+
+// "test_FuzzyMatcher [benchmark]" measures what a keystroke in the
+// autocompletion popup costs if all subjects of maxima's manual are candidates.
+TEST_CASE("FuzzyMatcher benchmark", "[.][benchmark]") {
+  std::vector<wxString> keywords = ManualKeywords();
+  REQUIRE(!keywords.empty());
+  FuzzyMatcher matcher = Matcher(keywords);
+  BENCHMARK("one letter") {
+    return matcher.Find("p", 50).size();
+  };
+  BENCHMARK("a prefix") {
+    return matcher.Find("plot", 50).size();
+  };
+  BENCHMARK("some letters") {
+    return matcher.Find("intgrt", 50).size();
+  };
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,145 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#include "Cell.cpp"
+#include "CellPointers.cpp"
+#include "CellPtr.cpp"
+#include "FontAttribs.cpp"
+#include "FontCache.cpp"
+#include "LongNumberCell.cpp"
+#include "StringUtils.cpp"
+#include "TextCell.cpp"
+#include "TextExtentCache.cpp"
+#include "TextStyle.cpp"
+#include "VisiblyInvalidCell.cpp"
+#include <catch2/catch.hpp>
+
+CellPointers pointers(nullptr);
+
+Configuration::Configuration(wxDC *dc, InitOpt) : m_dc(dc) {}
+Configuration::~Configuration() {}
+long Configuration::Scale_Px(double) const { return 1; }
+AFontSize Configuration::Scale_Px(AFontSize) const { return {}; }
+wxFontStyle Configuration::IsItalic(long) const { return {}; }
+wxColour Configuration::GetColor(TextStyle) { return {}; }
+Style Configuration::GetStyle(TextStyle, AFontSize) const { return {}; }
+CellPointers *Cell::GetCellPointers() const { return &pointers; }
+void Configuration::NotifyOfCellRedraw(const Cell *) {}
+
+//! A number with 100 digits, as MathParser passes it to the cell: with unicode minus signs
+static wxString LongNumber()
+{
+  wxString number = wxT("\u2212");
+  for (int i = 0; i < 10; i++)
+    number += wxT("1234567890");
+  return number + wxT("e\u22125");
+}
+
+SCENARIO("A copy of a LongNumberCell has the same number") {
+  Configuration config;
+  config.SetDisplayedDigits(30);
+  Configuration *pConfig = &config;
+  GIVEN("A long number and its copy") {
+    LongNumberCell cell(nullptr, &pConfig, LongNumber());
+    auto copy = cell.Copy();
+    THEN("the copy has the same value")
+      REQUIRE(copy->GetValue() == LongNumber());
+    THEN("the copy exports the same text")
+      REQUIRE(copy->ToString() == cell.ToString());
+    WHEN("the copy is given a new value") {
+      copy->SetValue(wxT("12345678901234567890"));
+      THEN("the copy has the new value")
+        REQUIRE(copy->GetValue() == wxT("12345678901234567890"));
+      THEN("the original keeps its value")
+        REQUIRE(cell.GetValue() == LongNumber());
+    }
+  }
+}
+
+SCENARIO("A LongNumberCell keeps the kind of its minus signs") {
+  Configuration config;
+  config.SetDisplayedDigits(30);
+  Configuration *pConfig = &config;
+  GIVEN("A long number with unicode minus signs") {
+    LongNumberCell cell(nullptr, &pConfig, LongNumber());
+    THEN("ToString() replaces them by ASCII minus signs") {
+      wxString expected = LongNumber();
+      expected.Replace(wxT("\u2212"), wxT("-"));
+      REQUIRE(cell.ToString() == expected);
+    }
+    THEN("ToXML() keeps them")
+      REQUIRE(cell.ToXML() == wxT("<n>") + LongNumber() + wxT("</n>"));
+    WHEN("a cell is made from the XML the cell exports") {
+      wxString xml = cell.ToXML();
+      LongNumberCell reread(nullptr, &pConfig,
+                            xml.Mid(3, xml.Length() - 3 - 4));
+      THEN("it has the same value")
+        REQUIRE(reread.GetValue() == cell.GetValue());
+      THEN("it exports the same text")
+        REQUIRE(reread.ToString() == cell.ToString());
+    }
+  }
+  GIVEN("A long number with an ASCII minus sign in its exponent") {
+    wxString number = LongNumber();
+    number.Replace(wxT("e\u2212"), wxT("e-"));
+    LongNumberCell cell(nullptr, &pConfig, number);
+    THEN("GetValue() returns the ASCII minus sign")
+      REQUIRE(cell.GetValue() == number);
+    THEN("ToXML() returns the ASCII minus sign")
+      REQUIRE(cell.ToXML() == wxT("<n>") + number + wxT("</n>"));
+  }
+}
+
+SCENARIO("A LongNumberCell shows only the first and the last digits") {
+  Configuration config;
+  Configuration *pConfig = &config;
+  GIVEN("A number with more digits than are to be displayed") {
+    config.SetDisplayedDigits(30);
+    LongNumberCell cell(nullptr, &pConfig, LongNumber());
+    THEN("10 digits are shown at each end")
+      REQUIRE(cell.GetDisplayedText() ==
+              wxT("\u2212123456789[84 digits]4567890e\u22125"));
+    WHEN("more digits are to be displayed") {
+      config.SetDisplayedDigits(60);
+      THEN("20 digits are shown at each end")
+        REQUIRE(cell.GetDisplayedText() ==
+                wxT("\u22121234567890123456789[64 digits]45678901234567890e\u22125"));
+    }
+    WHEN("all digits are to be displayed") {
+      config.SetDisplayedDigits(200);
+      THEN("the whole number is shown")
+        REQUIRE(cell.GetDisplayedText() == LongNumber());
+    }
+  }
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, char *argv[])
+{
+  wxEntryStart(argc, argv);
+  auto rc = Catch::Session().run(argc, argv);
+  wxEntryCleanup();
+  return rc;
+}
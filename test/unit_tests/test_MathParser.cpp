@@ -0,0 +1,154 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#include "AbsCell.cpp"
+#include "AtCell.cpp"
+#include "Cell.cpp"
+#include "CellPointers.cpp"
+#include "CellPtr.cpp"
+#include "Configuration.cpp"
+#include "ConfusableNames.cpp"
+#include "ConjugateCell.cpp"
+#include "DiffCell.cpp"
+#include "EditorCell.cpp"
+#include "ExptCell.cpp"
+#include "FontAttribs.cpp"
+#include "FontCache.cpp"
+#include "FracCell.cpp"
+#include "FunCell.cpp"
+#include "GroupCell.cpp"
+#include "Image.cpp"
+#include "ImgCell.cpp"
+#include "IntCell.cpp"
+#include "LabelCell.cpp"
+#include "LimitCell.cpp"
+#include "ListCell.cpp"
+#include "LongNumberCell.cpp"
+#include "MarkDown.cpp"
+#include "MathParser.cpp"
+#include "MathTags.cpp"
+#include "MatrCell.cpp"
+#include "MaximaTokenizer.cpp"
+#include "ParenCell.cpp"
+#include "RenderTimings.cpp"
+#include "SlideShowCell.cpp"
+#include "SqrtCell.cpp"
+#include "StringUtils.cpp"
+#include "SubCell.cpp"
+#include "SubSupCell.cpp"
+#include "SumCell.cpp"
+#include "TextCell.cpp"
+#include "TextExtentCache.cpp"
+#include "TextStyle.cpp"
+#include "VisiblyInvalidCell.cpp"
+#include "XmlPullParser.cpp"
+#include "ZipIndex.cpp"
+#include <catch2/catch.hpp>
+
+CellPointers pointers(nullptr);
+
+CellPointers *Cell::GetCellPointers() const { return &pointers; }
+wxBitmap SvgBitmap::RGBA2wxBitmap(unsigned char const *, int const &, int const &) { return {}; }
+int ErrorRedirector::m_messages_logPaneOnly;
+Dirstructure *Dirstructure::m_dirStructure;
+wxString Dirstructure::MaximaDefaultLocation() { return {}; }
+int LoggingMessageBox(const wxString &, const wxString &, int, wxWindow *, int, int) { return wxOK; }
+
+SCENARIO("MathParser highlights everything inside <hl>") {
+  Configuration config(nullptr, Configuration::temporary);
+  Configuration *pConfig = &config;
+  MathParser parser(&pConfig);
+  GIVEN("text directly inside <hl>") {
+    std::unique_ptr<Cell> cell(parser.ParseLine(wxT("<mth><hl>text</hl></mth>")));
+    THEN("its cell is highlighted") {
+      REQUIRE(cell);
+      CHECK(cell->ToString() == wxT("text"));
+      CHECK(cell->GetHighlight());
+    }
+  }
+  GIVEN("a variable inside <hl>") {
+    std::unique_ptr<Cell> cell(parser.ParseLine(wxT("<mth><hl><v>x</v></hl></mth>")));
+    THEN("its cell is highlighted") {
+      REQUIRE(cell);
+      CHECK(cell->ToString() == wxT("x"));
+      CHECK(cell->GetHighlight());
+    }
+  }
+  GIVEN("text before and after <hl>") {
+    std::unique_ptr<Cell> cell(parser.ParseLine(wxT("<mth>a<hl>b</hl>c</mth>")));
+    THEN("only the text inside <hl> is highlighted") {
+      REQUIRE(cell);
+      CHECK_FALSE(cell->GetHighlight());
+      REQUIRE(cell->GetNext());
+      CHECK(cell->GetNext()->ToString() == wxT("b"));
+      CHECK(cell->GetNext()->GetHighlight());
+      REQUIRE(cell->GetNext()->GetNext());
+      CHECK_FALSE(cell->GetNext()->GetNext()->GetHighlight());
+    }
+  }
+}
+
+SCENARIO("MathParser keeps the entries of big matrices as XML") {
+  Configuration config(nullptr, Configuration::temporary);
+  Configuration *pConfig = &config;
+  // Don't replace the matrix by a "too long" message
+  config.ShowLength(3);
+  MathParser parser(&pConfig);
+  GIVEN("a 60x60 matrix") {
+    wxString xml = wxT("<mth><tb>");
+    for (int i = 0; i < 60; i++)
+    {
+      xml += wxT("<mtr>");
+      for (int j = 0; j < 60; j++)
+        xml += wxString::Format(wxT("<mtd><n>%i</n></mtd>"), 60 * i + j);
+      xml += wxT("</mtr>");
+    }
+    xml += wxT("</tb></mth>");
+    std::unique_ptr<Cell> cell(parser.ParseLine(xml));
+    THEN("only the rows up to MatrCell::maxEagerEntries entries are built") {
+      REQUIRE(cell);
+      int built = 0;
+      for (auto inner = cell->InnerBegin(); inner != cell->InnerEnd(); ++inner)
+        if (inner)
+          built++;
+      CHECK(built == 42 * 60);
+    }
+    THEN("the entries that aren't built are exported, nevertheless") {
+      REQUIRE(cell);
+      CHECK(cell->ToString().Contains(wxT("3599")));
+      CHECK(cell->ToXML().Contains(wxT("<mtd><n>3599</n></mtd>")));
+      CHECK(cell->Copy()->ToTeX().Contains(wxT("3599")));
+    }
+  }
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, char *argv[])
+{
+  wxEntryStart(argc, argv);
+  auto rc = Catch::Session().run(argc, argv);
+  wxEntryCleanup();
+  return rc;
+}
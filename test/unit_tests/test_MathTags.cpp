@@ -0,0 +1,141 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "MathTags.cpp"
+#include "TestData.h"
+#include <catch2/catch.hpp>
+#include <wx/hashmap.h>
+#include <set>
+#include <vector>
+
+static const std::vector<std::pair<wxString, MathTag>> mathTags = {
+  {"v", MathTag::v}, {"mi", MathTag::mi}, {"mo", MathTag::mo}, {"t", MathTag::t},
+  {"n", MathTag::n}, {"mn", MathTag::mn}, {"p", MathTag::p}, {"f", MathTag::f},
+  {"mfrac", MathTag::mfrac}, {"e", MathTag::e}, {"msup", MathTag::msup},
+  {"i", MathTag::i}, {"munder", MathTag::munder}, {"fn", MathTag::fn},
+  {"g", MathTag::g}, {"s", MathTag::s}, {"fnm", MathTag::fnm}, {"q", MathTag::q},
+  {"d", MathTag::d}, {"sm", MathTag::sm}, {"in", MathTag::in},
+  {"mspace", MathTag::mspace}, {"at", MathTag::at}, {"a", MathTag::a},
+  {"cj", MathTag::cj}, {"ie", MathTag::ie},
+  {"mmultiscripts", MathTag::mmultiscripts}, {"lm", MathTag::lm},
+  {"r", MathTag::r}, {"mrow", MathTag::mrow}, {"tb", MathTag::tb},
+  {"mth", MathTag::mth}, {"line", MathTag::line}, {"lbl", MathTag::lbl},
+  {"st", MathTag::st}, {"hl", MathTag::hl}, {"h", MathTag::h},
+  {"img", MathTag::img}, {"slide", MathTag::slide}, {"editor", MathTag::editor},
+  {"cell", MathTag::cell}, {"ascii", MathTag::ascii}, {"output", MathTag::output},
+  {"mtd", MathTag::mtd}, {"math", MathTag::math}
+};
+
+static const std::vector<std::pair<wxString, GroupTag>> groupTags = {
+  {"code", GroupTag::code}, {"image", GroupTag::image},
+  {"pagebreak", GroupTag::pagebreak}, {"text", GroupTag::text},
+  {"title", GroupTag::title}, {"section", GroupTag::section},
+  {"subsection", GroupTag::subsection}, {"subsubsection", GroupTag::subsubsection},
+  {"heading5", GroupTag::heading5}, {"heading6", GroupTag::heading6}
+};
+
+SCENARIO("MathTagFromName knows all tags") {
+  GIVEN("the names of all tags MathParser handles") {
+    THEN("each name maps to its own tag") {
+      std::set<MathTag> seen;
+      for (auto const &tag : mathTags)
+      {
+        INFO("Tag name: " << tag.first.ToStdString());
+        CHECK(MathTagFromName(tag.first) == tag.second);
+        seen.insert(tag.second);
+      }
+      CHECK(seen.size() == static_cast<std::size_t>(MathTag::count) - 1);
+    }
+  }
+  GIVEN("names that aren't tags") {
+    THEN("the tag is unknown") {
+      for (auto const &name : {"", "x", "vv", "mii", "m", "span", "mmultiscript", "MI", "spans"})
+        CHECK(MathTagFromName(name) == MathTag::unknown);
+    }
+  }
+}
+
+SCENARIO("GroupTagFromName knows all cell types") {
+  GIVEN("the names of all cell types") {
+    THEN("each name maps to its own tag") {
+      std::set<GroupTag> seen;
+      for (auto const &tag : groupTags)
+      {
+        CHECK(GroupTagFromName(tag.first) == tag.second);
+        seen.insert(tag.second);
+      }
+      CHECK(seen.size() == static_cast<std::size_t>(GroupTag::count) - 1);
+    }
+    THEN("an unknown type maps to unknown") {
+      CHECK(GroupTagFromName("answer") == GroupTag::unknown);
+      CHECK(GroupTagFromName("") == GroupTag::unknown);
+    }
+  }
+}
+
+SCENARIO("TagTable starts empty") {
+  TagTable<MathTag, int (*)()> table;
+  CHECK(table.empty());
+  table[MathTag::v] = []{ return 1; };
+  CHECK(!table.empty());
+  CHECK(table[MathTag::unknown] == nullptr);
+}
+
+// Not run by default. Run "test_MathTags [benchmark]" to see what the
+// dispatch of the tags of the test files' content.xml costs compared to the
+// string hash MathParser used before.
+TEST_CASE("Tag dispatch benchmark", "[.][benchmark]") {
+  std::vector<wxString> names;
+  for (auto const &xml : TestWxmxContents())
+  {
+    auto fileNames = ElementNames(xml);
+    names.insert(names.end(), fileNames.begin(), fileNames.end());
+  }
+  REQUIRE(!names.empty());
+
+  WX_DECLARE_STRING_HASH_MAP(MathTag, MathTagHash);
+  MathTagHash hash;
+  for (auto const &tag : mathTags)
+    hash[tag.first] = tag.second;
+
+  BENCHMARK("string hash") {
+    int sum = 0;
+    for (auto const &name : names)
+    {
+      auto tag = hash.find(name);
+      sum += static_cast<int>((tag == hash.end()) ? MathTag::unknown : tag->second);
+    }
+    return sum;
+  };
+  BENCHMARK("MathTagFromName") {
+    int sum = 0;
+    for (auto const &name : names)
+      sum += static_cast<int>(MathTagFromName(name));
+    return sum;
+  };
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
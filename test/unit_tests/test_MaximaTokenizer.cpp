@@ -0,0 +1,157 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "MaximaTokenizer.cpp"
+#include "TestData.h"
+#include <catch2/catch.hpp>
+
+Configuration::Configuration(wxDC *dc, InitOpt) : m_dc(dc) {}
+Configuration::~Configuration() {}
+
+using TokenList = MaximaTokenizer::TokenList;
+
+static TokenList Tokenize(const wxString &text, Configuration *configuration)
+{
+  return MaximaTokenizer(text, configuration).PopTokens();
+}
+
+//! Tokenizes oldText, and then newText re-using the tokens of oldText
+static TokenList Retokenize(const wxString &oldText, const wxString &newText,
+                            Configuration *configuration)
+{
+  return MaximaTokenizer(newText, configuration,
+                         oldText, Tokenize(oldText, configuration)).PopTokens();
+}
+
+static bool Equal(const TokenList &a, const TokenList &b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if ((a[i].GetText() != b[i].GetText()) || (a[i].GetStyle() != b[i].GetStyle()))
+      return false;
+  return true;
+}
+
+SCENARIO("Re-tokenizing a changed text gives the same tokens as tokenizing it from scratch") {
+  Configuration configuration;
+  configuration.SetChangeAsterisk(false);
+  configuration.InLispMode(false);
+
+  // Pairs of old and new text
+  const std::vector<std::pair<wxString, wxString>> edits = {
+    {"", "a"},
+    {"a", ""},
+    {"a:b;", "a:b;"},
+    {"f(x):=x^2;", "f(x):=x^3;"},
+    {"f(x):=x^2;", "f(x):=x^2;\ng(x):=x;"},
+    {"f(x):=x^2;", "g:1;\nf(x):=x^2;"},
+    // Typing a name char by char
+    {"sin x", "sinh x"},
+    {"a: 12;", "a: 123;"},
+    {"a: 1.5e3;", "a: 1.5e+3;"},
+    // A name turns into a function if a "(" follows
+    {"f  x", "f  (x"},
+    {"f\n\n x", "f\n\n (x"},
+    {"f (x)", "f x)"},
+    // Strings and comments swallow the rest of the text until they are closed
+    {"a:1;\nb:2;\nc:3;", "a:\"1;\nb:2;\nc:3;"},
+    {"a:\"1;\nb:2;\nc:3;", "a:1;\nb:2;\nc:3;"},
+    {"a:1;\nb:2;\nc:\"3\";", "a:\"1;\nb:2;\nc:\"3\";"},
+    {"a:1; b:2; c:3;", "a:1; /* b:2; c:3;"},
+    {"a:1; /* b:2; */ c:3;", "a:1; / b:2; */ c:3;"},
+    {"a:1; /* b:2; */ c:3;", "a:1; /* b:2; * c:3;"},
+    {"x:\"a\\\"b\";", "x:\"a\\b\";"},
+    // A ":" that turns into a ":lisp" command
+    {"a:1;\n:li (print 1)\nb:2;", "a:1;\n:lisp (print 1)\nb:2;"},
+    {"a:1;\n:lisp (print 1)\nb:2;", "a:1;\n:lis (print 1)\nb:2;"},
+    {"a:1;\n:lisp (print 1)\nb:2;", "a:1;\n:lisp (print 1) b:2;"},
+    {"a:1;\nto_lis;(to-maxima)\nb:2;", "a:1;\nto_lisp;(to-maxima)\nb:2;"},
+    // Escaped chars and line continuations in names
+    {"ab\\\ncd", "abx\\\ncd"},
+    {"ab\\cd", "abcd"},
+    {"?a; b", "?ab; b"},
+  };
+
+  GIVEN("text that has been edited") {
+    THEN("the tokens are the same as tokenizing the new text from scratch") {
+      for (auto const &edit : edits)
+      {
+        INFO("Old text: " << edit.first.ToStdString());
+        INFO("New text: " << edit.second.ToStdString());
+        CHECK(Equal(Retokenize(edit.first, edit.second, &configuration),
+                    Tokenize(edit.second, &configuration)));
+      }
+    }
+  }
+  GIVEN("every possible single char edit of a text") {
+    const wxString text = "f(x):=block([a:\"1\"], /* c */ a^2+x)$\n:lisp (print 1)\ng (y):=y;";
+    THEN("the tokens are the same as tokenizing the new text from scratch") {
+      for (size_t i = 0; i <= text.Length(); i++)
+        for (auto ch : wxString("a (\"*/:\n;"))
+        {
+          wxString inserted = text.Left(i) + ch + text.Mid(i);
+          INFO("Text: " << inserted.ToStdString());
+          CHECK(Equal(Retokenize(text, inserted, &configuration),
+                      Tokenize(inserted, &configuration)));
+          CHECK(Equal(Retokenize(inserted, text, &configuration),
+                      Tokenize(text, &configuration)));
+        }
+    }
+  }
+  GIVEN("tokens that were made in lisp mode") {
+    configuration.InLispMode(true);
+    THEN("we fall back to tokenizing the whole text") {
+      CHECK(Equal(Retokenize("(print 1)  ", "(print 12)  ", &configuration),
+                  Tokenize("(print 12)  ", &configuration)));
+    }
+  }
+}
+
+// What a keystroke costs in a code cell that contains the code of all .wxm
+// files the automatic tests use. Hidden: run "test_MaximaTokenizer [benchmark]".
+TEST_CASE("Tokenizer benchmark", "[.][benchmark]") {
+  Configuration configuration;
+  configuration.SetChangeAsterisk(false);
+  configuration.InLispMode(false);
+
+  wxString text = TestWxmCode();
+  REQUIRE(!text.IsEmpty());
+  wxString typed = text.Left(text.Length() / 2) + "y" + text.Mid(text.Length() / 2);
+  TokenList tokens = Tokenize(text, &configuration);
+
+  BENCHMARK("tokenize everything") {
+    return Tokenize(typed, &configuration).size();
+  };
+  BENCHMARK_ADVANCED("re-tokenize the change")(Catch::Benchmark::Chronometer meter) {
+    std::vector<TokenList> oldTokens(meter.runs(), tokens);
+    meter.measure([&](int i) {
+      return MaximaTokenizer(typed, &configuration, text, std::move(oldTokens[i])).PopTokens().size();
+    });
+  };
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,114 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "SearchIndex.cpp"
+#include <catch2/catch.hpp>
+
+//! The cells SearchIndex is told about. It only uses their addresses.
+static const char cells[3] = {};
+static const EditorCell *const cell1 = reinterpret_cast<const EditorCell *>(&cells[0]);
+static const EditorCell *const cell2 = reinterpret_cast<const EditorCell *>(&cells[1]);
+static const EditorCell *const cell3 = reinterpret_cast<const EditorCell *>(&cells[2]);
+
+static std::vector<size_t> Find(SearchIndex &index, const EditorCell *cell, unsigned long revision,
+                                const wxString &text, const wxString &str, bool ignoreCase = true)
+{
+  std::vector<size_t> starts;
+  index.Find(cell, revision, text, str, ignoreCase, starts);
+  return starts;
+}
+
+SCENARIO("SearchIndex finds all matches") {
+  SearchIndex index;
+  wxString text = "integrate(sin(x),x);\rIntegrate(cos(x),x);";
+  GIVEN("a case-insensitive search") {
+    THEN("all matches are found, including overlapping ones") {
+      CHECK(Find(index, cell1, 1, text, "integrate") == std::vector<size_t>({0, 21}));
+      CHECK(Find(index, cell1, 1, text, "(x),") == std::vector<size_t>({13, 34}));
+      CHECK(Find(index, cell1, 1, "aaaa", "aaa") == std::vector<size_t>({0, 1}));
+    }
+    THEN("strings shorter than a trigram are found") {
+      CHECK(Find(index, cell1, 1, text, "x)") == std::vector<size_t>({14, 17, 35, 38}));
+      CHECK(Find(index, cell1, 1, text, "si") == std::vector<size_t>({10}));
+    }
+    THEN("soft line breaks match spaces") {
+      CHECK(Find(index, cell1, 1, text, "; i") == std::vector<size_t>({19}));
+    }
+    THEN("strings that aren't in the text aren't found") {
+      CHECK(Find(index, cell1, 1, text, "integral").empty());
+      CHECK(Find(index, cell1, 1, text, "").empty());
+      CHECK(Find(index, cell1, 1, text, text + "x").empty());
+    }
+  }
+  GIVEN("a case-sensitive search") {
+    THEN("only the matches with the right case are found") {
+      CHECK(Find(index, cell1, 1, text, "Integrate", false) == std::vector<size_t>({21}));
+      CHECK(Find(index, cell1, 1, text, "iNtegrate", false).empty());
+      CHECK(Find(index, cell1, 1, text, "X)", false).empty());
+    }
+  }
+}
+
+SCENARIO("SearchIndex keeps the index of each cell up to date") {
+  SearchIndex index;
+  Find(index, cell1, 1, "sin(x)", "sin");
+  Find(index, cell2, 2, "cos(x)", "cos");
+  GIVEN("a cell whose text has got a new revision") {
+    THEN("the new text is searched") {
+      CHECK(Find(index, cell1, 3, "tan(x)", "sin").empty());
+      CHECK(Find(index, cell1, 3, "tan(x)", "tan") == std::vector<size_t>({0}));
+    }
+  }
+  GIVEN("a cell whose text has changed its length without a new revision") {
+    THEN("the new text is searched, anyway") {
+      CHECK(Find(index, cell1, 1, "asin(x)", "sin") == std::vector<size_t>({1}));
+    }
+  }
+  GIVEN("several cells") {
+    THEN("each has its own index") {
+      CHECK(index.GetSize() == 2);
+      CHECK(Find(index, cell2, 2, "cos(x)", "sin").empty());
+      CHECK(Find(index, cell3, 4, "sin(x)+cos(x)", "cos") == std::vector<size_t>({7}));
+      CHECK(index.GetSize() == 3);
+    }
+  }
+  GIVEN("a sweep that only searches some cells") {
+    index.StartSweep();
+    Find(index, cell2, 2, "cos(x)", "cos");
+    index.EndSweep();
+    THEN("the index of the other cells is dropped") {
+      CHECK(index.GetSize() == 1);
+    }
+  }
+  GIVEN("a cleared index") {
+    index.Clear();
+    THEN("it holds no cells, but can still be searched") {
+      CHECK(index.GetSize() == 0);
+      CHECK(Find(index, cell1, 1, "sin(x)", "sin") == std::vector<size_t>({0}));
+    }
+  }
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,115 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#include "Cell.cpp"
+#include "CellPointers.cpp"
+#include "CellPtr.cpp"
+#include "FontAttribs.cpp"
+#include "FontCache.cpp"
+#include "Image.cpp"
+#include "ImgCell.cpp"
+#include "SlideShowCell.cpp"
+#include "StringUtils.cpp"
+#include "TextCell.cpp"
+#include "TextExtentCache.cpp"
+#include "TextStyle.cpp"
+#include "VisiblyInvalidCell.cpp"
+#include "ZipIndex.cpp"
+#include <catch2/catch.hpp>
+
+CellPointers pointers(nullptr);
+
+Configuration::Configuration(wxDC *dc, InitOpt) : m_dc(dc) {}
+Configuration::~Configuration() {}
+long Configuration::Scale_Px(double) const { return 1; }
+AFontSize Configuration::Scale_Px(AFontSize) const { return {}; }
+wxFontStyle Configuration::IsItalic(long) const { return {}; }
+wxColour Configuration::GetColor(TextStyle) { return {}; }
+Style Configuration::GetStyle(TextStyle, AFontSize) const { return {}; }
+CellPointers *Cell::GetCellPointers() const { return &pointers; }
+void Configuration::NotifyOfCellRedraw(const Cell *) {}
+
+wxBitmap SvgBitmap::RGBA2wxBitmap(unsigned char const *, int const &, int const &) { return {}; }
+
+int ErrorRedirector::m_messages_logPaneOnly;
+
+//! How often the list of cells whose XML has changed contains cell
+static long XMLChangedCount(Cell *cell)
+{
+  return std::count(pointers.m_xmlChangedCells.begin(), pointers.m_xmlChangedCells.end(), cell);
+}
+
+SCENARIO("A slideshow tells when its XML attributes change") {
+  Configuration config;
+  Configuration *pConfig = &config;
+  GIVEN("A slideshow whose XML has just been autosaved") {
+    SlideShow cell(nullptr, &pConfig);
+    // GroupCell::ToXMLCached() removes the cells of the group it has saved
+    pointers.m_xmlChangedCells.clear();
+    WHEN("the frame it shows changes before the next autosave")
+    {
+      cell.SetDisplayedIndex(0);
+      THEN("its XML is marked as changed")
+        REQUIRE(XMLChangedCount(&cell) == 1);
+    }
+    WHEN("its frame rate changes before the next autosave")
+    {
+      cell.SetFrameRate(5);
+      THEN("its XML is marked as changed")
+        REQUIRE(XMLChangedCount(&cell) == 1);
+    }
+    WHEN("its animation is started and stopped before the next autosave")
+    {
+      cell.AnimationRunning(true);
+      cell.AnimationRunning(false);
+      THEN("its XML is marked as changed only once")
+        REQUIRE(XMLChangedCount(&cell) == 1);
+    }
+    WHEN("nothing changes before the next autosave")
+      THEN("its XML isn't marked as changed")
+        REQUIRE(XMLChangedCount(&cell) == 0);
+  }
+  GIVEN("A slideshow whose XML has changed")
+  {
+    auto cell = std::make_unique<SlideShow>(nullptr, &pConfig);
+    pointers.m_xmlChangedCells.clear();
+    cell->SetDisplayedIndex(0);
+    WHEN("it is deleted before the next autosave")
+    {
+      cell.reset();
+      THEN("the list of changed cells doesn't keep it alive")
+        REQUIRE(!pointers.m_xmlChangedCells.front());
+    }
+  }
+}
+
+// If we don't provide our own main when compiling on MinGW
+// we currently get an error message that WinMain@16 is missing
+// (https://github.com/catchorg/Catch2/issues/1287)
+int main(int argc, char *argv[])
+{
+  wxEntryStart(argc, argv);
+  auto rc = Catch::Session().run(argc, argv);
+  wxEntryCleanup();
+  return rc;
+}
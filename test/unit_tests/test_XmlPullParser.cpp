@@ -0,0 +1,143 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+
+#define CATCH_CONFIG_RUNNER
+#include "XmlPullParser.cpp"
+#include <catch2/catch.hpp>
+
+//! Reads all of xml and returns true if the parser accepted it
+static bool Parses(const wxString &xml)
+{
+  XmlPullParser parser(xml);
+  while (true)
+  {
+    switch (parser.Next())
+    {
+    case XmlPullParser::EndOfDocument:
+      return true;
+    case XmlPullParser::Error:
+      return false;
+    default:
+      break;
+    }
+  }
+}
+
+SCENARIO("XmlPullParser reads well-formed XML") {
+  GIVEN("an element with attributes, text and character references") {
+    wxString xml = wxT("<mth a=\"1\" b='&lt;'><v>x&#x2212;&#9;</v><mspace/></mth>");
+    XmlPullParser parser(xml);
+    THEN("it returns its start tags, end tags and text in order") {
+      REQUIRE(parser.Next() == XmlPullParser::StartElement);
+      CHECK(parser.GetName() == wxT("mth"));
+      CHECK(parser.GetAttributes().Get(wxT("a")) == wxT("1"));
+      CHECK(parser.GetAttributes().Get(wxT("b")) == wxT("<"));
+      REQUIRE(parser.Next() == XmlPullParser::StartElement);
+      CHECK(parser.GetName() == wxT("v"));
+      REQUIRE(parser.Next() == XmlPullParser::Text);
+      CHECK(parser.GetText() == wxT("x\u2212\t"));
+      REQUIRE(parser.Next() == XmlPullParser::EndElement);
+      REQUIRE(parser.Next() == XmlPullParser::StartElement);
+      CHECK(parser.GetName() == wxT("mspace"));
+      REQUIRE(parser.Next() == XmlPullParser::EndElement);
+      REQUIRE(parser.Next() == XmlPullParser::EndElement);
+      CHECK(parser.GetName() == wxT("mth"));
+      CHECK(parser.Next() == XmlPullParser::EndOfDocument);
+    }
+  }
+  GIVEN("names containing digits, dashes and dots") {
+    THEN("they are accepted") {
+      CHECK(Parses(wxT("<a1-b.c x2=\"\"></a1-b.c>")));
+    }
+  }
+}
+
+SCENARIO("XmlPullParser skips elements") {
+  GIVEN("a table whose entries are skipped") {
+    wxString xml = wxT("<tb><mtr><mtd><v>a</v>&amp;</mtd><mtd/></mtr></tb>");
+    XmlPullParser parser(xml);
+    REQUIRE(parser.Next() == XmlPullParser::StartElement);
+    REQUIRE(parser.Next() == XmlPullParser::StartElement);
+    THEN("SkipElement() returns each entry as the document contains it") {
+      wxString entry;
+      REQUIRE(parser.Next() == XmlPullParser::StartElement);
+      REQUIRE(parser.SkipElement(entry));
+      CHECK(entry == wxT("<mtd><v>a</v>&amp;</mtd>"));
+      REQUIRE(parser.Next() == XmlPullParser::StartElement);
+      REQUIRE(parser.SkipElement(entry));
+      CHECK(entry == wxT("<mtd/>"));
+      REQUIRE(parser.Next() == XmlPullParser::EndElement);
+      CHECK(parser.GetName() == wxT("mtr"));
+    }
+  }
+  GIVEN("an element that isn't closed") {
+    wxString xml = wxT("<tb><mtd><v>a</v>");
+    XmlPullParser parser(xml);
+    REQUIRE(parser.Next() == XmlPullParser::StartElement);
+    REQUIRE(parser.Next() == XmlPullParser::StartElement);
+    THEN("SkipElement() fails") {
+      wxString entry;
+      CHECK_FALSE(parser.SkipElement(entry));
+    }
+  }
+}
+
+SCENARIO("XmlPullParser rejects what expat would reject") {
+  GIVEN("character references to chars XML doesn't allow") {
+    THEN("they are errors") {
+      CHECK_FALSE(Parses(wxT("<r>&#1;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#x1F;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#xFFFE;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#xD800;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#x110000;</r>")));
+      CHECK_FALSE(Parses(wxT("<r a=\"&#0;\"></r>")));
+    }
+  }
+  GIVEN("malformed character references") {
+    THEN("they are errors") {
+      CHECK_FALSE(Parses(wxT("<r>&#;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#x;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#-65;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&# 65;</r>")));
+      CHECK_FALSE(Parses(wxT("<r>&#X41;</r>")));
+    }
+  }
+  GIVEN("names that start with a digit, a dash or a dot") {
+    THEN("they are errors") {
+      CHECK_FALSE(Parses(wxT("<1r></1r>")));
+      CHECK_FALSE(Parses(wxT("<r 1a=\"\"></r>")));
+      CHECK_FALSE(Parses(wxT("<-r></-r>")));
+      CHECK_FALSE(Parses(wxT("<r .a=\"\"></r>")));
+    }
+  }
+  GIVEN("a tag with the same attribute twice") {
+    THEN("it is an error") {
+      CHECK_FALSE(Parses(wxT("<r a=\"1\" a=\"1\"></r>")));
+      CHECK_FALSE(Parses(wxT("<r a=\"1\" b=\"2\" a=\"3\"/>")));
+    }
+  }
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}
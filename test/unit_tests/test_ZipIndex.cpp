@@ -0,0 +1,248 @@
+// -*- mode: c++; c-file-style: "linux"; c-basic-offset: 2; indent-tabs-mode: nil -*-
+//
+//  Copyright (C) 2020 Gunter Königsmann <wxMaxima@physikbuch.de>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//  SPDX-License-Identifier: GPL-2.0+
+
+#define CATCH_CONFIG_RUNNER
+#include "ZipIndex.cpp"
+#include <catch2/catch.hpp>
+#include <wx/filename.h>
+#include <string>
+#include <vector>
+
+static void Put16(std::string &zip, wxUint16 value)
+{
+  for (int i = 0; i < 2; i++)
+    zip += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+static void Put32(std::string &zip, wxUint32 value)
+{
+  for (int i = 0; i < 4; i++)
+    zip += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+static void Put64(std::string &zip, wxUint64 value)
+{
+  Put32(zip, value & 0xffffffff);
+  Put32(zip, value >> 32);
+}
+
+//! A file in a zip archive MakeZip() generates
+struct ZipFile
+{
+  //! The name, as the bytes the archive contains
+  std::string name;
+  std::string data;
+  //! Is the name UTF-8 or CP437?
+  bool utf8;
+};
+
+/*! Generates a zip archive that stores files without compression
+
+  \param zip64 Use the Zip64 records for the central directory and the offsets
+  \param prefix Data that precedes the archive without its offsets accounting for it
+*/
+static std::string MakeZip(const std::vector<ZipFile> &files, bool zip64 = false,
+                           const std::string &prefix = {})
+{
+  std::string zip;
+  std::vector<wxUint32> offsets;
+  for (auto const &file : files)
+  {
+    offsets.push_back(zip.size());
+    Put32(zip, 0x04034b50);
+    Put16(zip, 20);
+    Put16(zip, file.utf8 ? 0x800 : 0);
+    Put16(zip, 0);  // stored
+    Put32(zip, 0);  // time and date
+    Put32(zip, 0);  // CRC, which ZipIndex doesn't check
+    Put32(zip, file.data.size());
+    Put32(zip, file.data.size());
+    Put16(zip, file.name.size());
+    Put16(zip, 0);
+    zip += file.name + file.data;
+  }
+
+  wxUint64 directoryOffset = zip.size();
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    Put32(zip, 0x02014b50);
+    Put16(zip, zip64 ? 45 : 20);
+    Put16(zip, zip64 ? 45 : 20);
+    Put16(zip, files[i].utf8 ? 0x800 : 0);
+    Put16(zip, 0);
+    Put32(zip, 0);
+    Put32(zip, 0);
+    Put32(zip, files[i].data.size());
+    Put32(zip, files[i].data.size());
+    Put16(zip, files[i].name.size());
+    Put16(zip, zip64 ? 12 : 0);
+    Put16(zip, 0);  // comment
+    Put16(zip, 0);  // disk
+    Put16(zip, 0);  // internal attributes
+    Put32(zip, 0);  // external attributes
+    Put32(zip, zip64 ? 0xffffffff : offsets[i]);
+    zip += files[i].name;
+    if (zip64)
+    {
+      Put16(zip, 0x0001);
+      Put16(zip, 8);
+      Put64(zip, offsets[i]);
+    }
+  }
+  wxUint64 directorySize = zip.size() - directoryOffset;
+
+  if (zip64)
+  {
+    wxUint64 zip64EndRecord = zip.size();
+    Put32(zip, 0x06064b50);
+    Put64(zip, 44);
+    Put16(zip, 45);
+    Put16(zip, 45);
+    Put32(zip, 0);
+    Put32(zip, 0);
+    Put64(zip, files.size());
+    Put64(zip, files.size());
+    Put64(zip, directorySize);
+    Put64(zip, directoryOffset);
+
+    Put32(zip, 0x07064b50);
+    Put32(zip, 0);
+    Put64(zip, zip64EndRecord);
+    Put32(zip, 1);
+  }
+
+  Put32(zip, 0x06054b50);
+  Put16(zip, 0);
+  Put16(zip, 0);
+  Put16(zip, zip64 ? 0xffff : files.size());
+  Put16(zip, zip64 ? 0xffff : files.size());
+  Put32(zip, zip64 ? 0xffffffff : directorySize);
+  Put32(zip, zip64 ? 0xffffffff : directoryOffset);
+  Put16(zip, 0);
+  return prefix + zip;
+}
+
+//! A temp file that contains a zip archive for as long as it exists
+class ZipFileOnDisk
+{
+public:
+  explicit ZipFileOnDisk(const std::string &contents) :
+    m_name(wxFileName::CreateTempFileName(wxT("test_ZipIndex")))
+  {
+    wxFFile file(m_name, wxT("wb"));
+    file.Write(contents.data(), contents.size());
+  }
+  ~ZipFileOnDisk() { wxRemoveFile(m_name); }
+  const wxString &GetName() const { return m_name; }
+private:
+  wxString m_name;
+};
+
+static std::string ReadEntry(const ZipIndex &index, const wxString &name)
+{
+  wxMemoryBuffer data = index.Read(name);
+  return std::string(static_cast<const char *>(data.GetData()), data.GetDataLen());
+}
+
+static const std::vector<ZipFile> files = {
+  {"mimetype", "text/x-wxmathml", false},
+  {"content.xml", "<wxMaximaDocument/>", true},
+  {"image1.png", "not really a png", false}
+};
+
+SCENARIO("ZipIndex reads the files of an archive") {
+  GIVEN("an ordinary archive") {
+    ZipFileOnDisk zip(MakeZip(files));
+    ZipIndex index(zip.GetName());
+    THEN("all files can be read") {
+      REQUIRE(index.IsOk());
+      for (auto const &file : files)
+        CHECK(ReadEntry(index, file.name) == file.data);
+      CHECK(index.Contains("./content.xml"));
+      CHECK(!index.Contains("image2.png"));
+    }
+  }
+  GIVEN("a Zip64 archive") {
+    ZipFileOnDisk zip(MakeZip(files, true));
+    ZipIndex index(zip.GetName());
+    THEN("the Zip64 records are used") {
+      REQUIRE(index.IsOk());
+      for (auto const &file : files)
+        CHECK(ReadEntry(index, file.name) == file.data);
+    }
+  }
+  GIVEN("an archive with data in front of it that its offsets don't account for") {
+    ZipFileOnDisk zip(MakeZip(files, false, std::string(1000, 'x')));
+    ZipIndex index(zip.GetName());
+    THEN("the files are found, anyway") {
+      REQUIRE(index.IsOk());
+      for (auto const &file : files)
+        CHECK(ReadEntry(index, file.name) == file.data);
+    }
+  }
+  GIVEN("names that aren't UTF-8") {
+    // "\x81" is a "ü" in CP437, "\xe1" a "ß".
+    ZipFileOnDisk zip(MakeZip({{"\x81""bung.png", "1", false},
+                               {"Stra\xe1""e.png", "2", false},
+                               {"\xc3\xbc""bung.gnuplot", "3", true}}));
+    ZipIndex index(zip.GetName());
+    THEN("they are read as CP437") {
+      REQUIRE(index.IsOk());
+      CHECK(ReadEntry(index, wxString::FromUTF8("\xc3\xbc""bung.png")) == "1");
+      CHECK(ReadEntry(index, wxString::FromUTF8("Stra\xc3\x9f""e.png")) == "2");
+      CHECK(ReadEntry(index, wxString::FromUTF8("\xc3\xbc""bung.gnuplot")) == "3");
+    }
+  }
+}
+
+SCENARIO("ZipIndex refuses broken archives") {
+  std::string archive = MakeZip(files);
+  GIVEN("an archive whose end has been cut off") {
+    ZipFileOnDisk zip(archive.substr(0, archive.size() - 10));
+    THEN("it cannot be read") {
+      CHECK(!ZipIndex(zip.GetName()).IsOk());
+    }
+  }
+  GIVEN("an archive that has lost its central directory") {
+    std::string endRecord = archive.substr(archive.size() - 22);
+    ZipFileOnDisk zip(archive.substr(0, archive.find("PK\x01\x02")) + endRecord);
+    THEN("it cannot be read") {
+      CHECK(!ZipIndex(zip.GetName()).IsOk());
+    }
+  }
+  GIVEN("an archive that has been cut off in the middle") {
+    ZipFileOnDisk zip(archive.substr(0, archive.size() / 2));
+    THEN("it cannot be read") {
+      CHECK(!ZipIndex(zip.GetName()).IsOk());
+    }
+  }
+  GIVEN("a file that isn't a zip archive at all") {
+    ZipFileOnDisk zip("<wxMaximaDocument/>");
+    THEN("it cannot be read") {
+      CHECK(!ZipIndex(zip.GetName()).IsOk());
+    }
+  }
+}
+
+int main(int argc, const char* argv[])
+{
+  return Catch::Session().run(argc, argv);
+}